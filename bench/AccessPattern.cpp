@@ -0,0 +1,129 @@
+#include "AccessPattern.h"
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace {
+
+const size_t WORD = 8;
+const size_t OBJECT = 64;
+const size_t STRIDE = 264;   // a little over four lines, so strides drift across sets
+const size_t TILE = 16;      // tile edge in elements for the matrix pattern
+
+void sequential(std::vector<size_t>& out, size_t count, size_t footprint) {
+    for (size_t i = 0; i < count; i++) {
+        out.push_back((i * WORD) % footprint);
+    }
+}
+
+void strided(std::vector<size_t>& out, size_t count, size_t footprint) {
+    for (size_t i = 0; i < count; i++) {
+        out.push_back((i * STRIDE) % footprint);
+    }
+}
+
+void uniformRandom(std::vector<size_t>& out, size_t count, size_t footprint, std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> dist(0, footprint / WORD - 1);
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(dist(rng) * WORD);
+    }
+}
+
+void zipfian(std::vector<size_t>& out, size_t count, size_t footprint, std::mt19937_64& rng) {
+    size_t objects = footprint / OBJECT;
+
+    // Cumulative popularity of each rank
+    std::vector<double> cdf(objects);
+    double sum = 0.0;
+    for (size_t k = 0; k < objects; k++) {
+        sum += 1.0 / std::pow((double)(k + 1), 0.99);
+        cdf[k] = sum;
+    }
+
+    // Scatter the ranks so popular objects are not all adjacent
+    std::vector<size_t> placement(objects);
+    std::iota(placement.begin(), placement.end(), 0);
+    std::shuffle(placement.begin(), placement.end(), rng);
+
+    std::uniform_real_distribution<double> dist(0.0, sum);
+    for (size_t i = 0; i < count; i++) {
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+        if (rank >= objects) rank = objects - 1;
+        out.push_back(placement[rank] * OBJECT);
+    }
+}
+
+void pointerChase(std::vector<size_t>& out, size_t count, size_t footprint, std::mt19937_64& rng) {
+    // Sattolo's algorithm gives a single cycle through every node
+    size_t nodes = footprint / OBJECT;
+    std::vector<size_t> next(nodes);
+    std::iota(next.begin(), next.end(), 0);
+    for (size_t i = nodes - 1; i > 0; i--) {
+        size_t j = std::uniform_int_distribution<size_t>(0, i - 1)(rng);
+        std::swap(next[i], next[j]);
+    }
+
+    size_t node = 0;
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(node * OBJECT);
+        node = next[node];
+    }
+}
+
+void matrixTiled(std::vector<size_t>& out, size_t count, size_t footprint) {
+    // Three n x n matrices of doubles laid out back to back
+    size_t n = (size_t)std::sqrt((double)(footprint / (3 * WORD)));
+    n -= n % TILE;
+    if (n == 0) n = TILE;
+    size_t a = 0, b = n * n * WORD, c = 2 * n * n * WORD;
+
+    while (out.size() < count) {
+        for (size_t ii = 0; ii < n; ii += TILE)
+        for (size_t jj = 0; jj < n; jj += TILE)
+        for (size_t kk = 0; kk < n; kk += TILE)
+        for (size_t i = ii; i < ii + TILE; i++)
+        for (size_t j = jj; j < jj + TILE; j++) {
+            for (size_t k = kk; k < kk + TILE; k++) {
+                out.push_back(a + (i * n + k) * WORD);
+                out.push_back(b + (k * n + j) * WORD);
+            }
+            out.push_back(c + (i * n + j) * WORD);
+            if (out.size() >= count) {
+                out.resize(count);
+                return;
+            }
+        }
+    }
+}
+
+} // namespace
+
+const char* patternName(PatternKind kind) {
+    switch (kind) {
+        case PATTERN_SEQUENTIAL: return "sequential";
+        case PATTERN_STRIDED: return "strided";
+        case PATTERN_RANDOM: return "random";
+        case PATTERN_ZIPFIAN: return "zipfian";
+        case PATTERN_POINTER_CHASE: return "pointer_chase";
+        case PATTERN_MATRIX_TILED: return "matrix_tiled";
+    }
+    return "unknown";
+}
+
+std::vector<size_t> generatePattern(PatternKind kind, size_t count, size_t footprint,
+                                    uint64_t seed) {
+    std::vector<size_t> out;
+    out.reserve(count);
+
+    std::mt19937_64 rng(seed);
+    switch (kind) {
+        case PATTERN_SEQUENTIAL: sequential(out, count, footprint); break;
+        case PATTERN_STRIDED: strided(out, count, footprint); break;
+        case PATTERN_RANDOM: uniformRandom(out, count, footprint, rng); break;
+        case PATTERN_ZIPFIAN: zipfian(out, count, footprint, rng); break;
+        case PATTERN_POINTER_CHASE: pointerChase(out, count, footprint, rng); break;
+        case PATTERN_MATRIX_TILED: matrixTiled(out, count, footprint); break;
+    }
+    return out;
+}
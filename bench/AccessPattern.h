@@ -0,0 +1,24 @@
+#ifndef ACCESS_PATTERN_H
+#define ACCESS_PATTERN_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+enum PatternKind {
+    PATTERN_SEQUENTIAL,     // 8-byte words in address order
+    PATTERN_STRIDED,        // fixed stride, wrapping around the footprint
+    PATTERN_RANDOM,         // uniform over the footprint
+    PATTERN_ZIPFIAN,        // 64-byte objects with Zipf(0.99) popularity
+    PATTERN_POINTER_CHASE,  // walk of a random cyclic linked list
+    PATTERN_MATRIX_TILED    // tiled matrix multiply C += A * B
+};
+
+// Deterministic for a given (kind, count, footprint, seed). Addresses are
+// generated up front so the timed loop measures only the simulator.
+std::vector<size_t> generatePattern(PatternKind kind, size_t count, size_t footprint,
+                                    uint64_t seed);
+
+const char* patternName(PatternKind kind);
+
+#endif // ACCESS_PATTERN_H
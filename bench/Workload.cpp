@@ -0,0 +1,133 @@
+#include "Workload.h"
+#include <random>
+#include <deque>
+#include <cmath>
+
+namespace {
+
+const size_t MIN_SIZE = 16;
+const size_t MAX_SIZE = 4096;
+const size_t TARGET_LIVE = 256;  // live objects the random workloads hover around
+
+class Generator {
+public:
+    Generator(uint64_t seed) : rng(seed), next_object(0) {}
+
+    size_t uniformSize() {
+        return std::uniform_int_distribution<size_t>(MIN_SIZE, MAX_SIZE / 4)(rng);
+    }
+
+    // Pareto with alpha = 1.2: mostly small requests, occasional large ones
+    size_t powerLawSize() {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double size = MIN_SIZE / std::pow(1.0 - u, 1.0 / 1.2);
+        return size > MAX_SIZE ? MAX_SIZE : (size_t)size;
+    }
+
+    bool chance(double p) {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+    }
+
+    size_t pick(size_t n) {
+        return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+    }
+
+    size_t alloc(Workload& w, size_t size) {
+        w.ops.push_back({WorkloadOp::ALLOC, size, next_object});
+        return next_object++;
+    }
+
+    void freeAt(Workload& w, std::vector<size_t>& live, size_t index) {
+        w.ops.push_back({WorkloadOp::FREE, 0, live[index]});
+        live[index] = live.back();
+        live.pop_back();
+    }
+
+    size_t objects() const { return next_object; }
+
+private:
+    std::mt19937_64 rng;
+    size_t next_object;
+};
+
+// Allocate while below the target population, free a random object above it
+void randomChurn(Workload& w, Generator& gen, size_t num_ops, bool power_law) {
+    std::vector<size_t> live;
+    while (w.ops.size() < num_ops) {
+        double p_alloc = live.size() < TARGET_LIVE ? 0.7 : 0.3;
+        if (live.empty() || gen.chance(p_alloc)) {
+            live.push_back(gen.alloc(w, power_law ? gen.powerLawSize() : gen.uniformSize()));
+        } else {
+            gen.freeAt(w, live, gen.pick(live.size()));
+        }
+    }
+}
+
+// A slowly growing long-lived set with bursts of short-lived objects that
+// all die together at the end of each burst
+void bursty(Workload& w, Generator& gen, size_t num_ops) {
+    std::vector<size_t> long_lived;
+    std::vector<size_t> burst;
+    while (w.ops.size() < num_ops) {
+        if (long_lived.size() < TARGET_LIVE / 4 || gen.chance(0.05)) {
+            long_lived.push_back(gen.alloc(w, gen.uniformSize()));
+        }
+        if (long_lived.size() > TARGET_LIVE / 2) {
+            gen.freeAt(w, long_lived, gen.pick(long_lived.size()));
+        }
+
+        size_t burst_len = 32 + gen.pick(96);
+        for (size_t i = 0; i < burst_len && w.ops.size() < num_ops; i++) {
+            burst.push_back(gen.alloc(w, gen.powerLawSize()));
+        }
+        while (!burst.empty() && w.ops.size() < num_ops) {
+            gen.freeAt(w, burst, burst.size() - 1);
+        }
+    }
+}
+
+// Queue of messages: the producer allocates, the consumer frees the oldest
+void producerConsumer(Workload& w, Generator& gen, size_t num_ops) {
+    std::deque<size_t> queue;
+    while (w.ops.size() < num_ops) {
+        bool produce = queue.size() < TARGET_LIVE / 2 ||
+                       (queue.size() < TARGET_LIVE && gen.chance(0.5));
+        if (produce) {
+            queue.push_back(gen.alloc(w, gen.uniformSize()));
+        } else {
+            w.ops.push_back({WorkloadOp::FREE, 0, queue.front()});
+            queue.pop_front();
+        }
+    }
+}
+
+} // namespace
+
+const char* workloadName(WorkloadKind kind) {
+    switch (kind) {
+        case WORKLOAD_UNIFORM: return "uniform";
+        case WORKLOAD_POWER_LAW: return "power_law";
+        case WORKLOAD_BURSTY: return "bursty";
+        case WORKLOAD_PRODUCER_CONSUMER: return "producer_consumer";
+    }
+    return "unknown";
+}
+
+Workload generateWorkload(WorkloadKind kind, size_t num_ops, uint64_t seed) {
+    Workload w;
+    w.name = workloadName(kind);
+    w.ops.reserve(num_ops);
+
+    Generator gen(seed);
+    switch (kind) {
+        case WORKLOAD_UNIFORM: randomChurn(w, gen, num_ops, false); break;
+        case WORKLOAD_POWER_LAW: randomChurn(w, gen, num_ops, true); break;
+        case WORKLOAD_BURSTY: bursty(w, gen, num_ops); break;
+        case WORKLOAD_PRODUCER_CONSUMER: producerConsumer(w, gen, num_ops); break;
+    }
+    if (w.ops.size() > num_ops) {
+        w.ops.resize(num_ops);
+    }
+    w.num_objects = gen.objects();
+    return w;
+}
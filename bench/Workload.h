@@ -0,0 +1,35 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// One step of a synthetic allocation trace. Objects are numbered by the
+// order of their ALLOC; a FREE names the object it releases.
+struct WorkloadOp {
+    enum Type { ALLOC, FREE } type;
+    size_t size;    // bytes requested (ALLOC only)
+    size_t object;  // object index
+};
+
+enum WorkloadKind {
+    WORKLOAD_UNIFORM,            // uniform sizes, random frees
+    WORKLOAD_POWER_LAW,          // heavy-tailed sizes, random frees
+    WORKLOAD_BURSTY,             // bursts of short-lived objects over a long-lived base
+    WORKLOAD_PRODUCER_CONSUMER   // objects freed in allocation order
+};
+
+struct Workload {
+    std::string name;
+    std::vector<WorkloadOp> ops;
+    size_t num_objects;
+};
+
+// Deterministic for a given (kind, num_ops, seed)
+Workload generateWorkload(WorkloadKind kind, size_t num_ops, uint64_t seed);
+
+const char* workloadName(WorkloadKind kind);
+
+#endif // WORKLOAD_H
@@ -0,0 +1,225 @@
+#include "Workload.h"
+#include "MemoryManager.h"
+#include "BuddyAllocator.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Allocator benchmark: replays synthetic workloads against every
+// AllocStrategy and the buddy allocator, timing each operation.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    size_t num_ops = 20000;
+    size_t memory = 1 << 19;      // power of two so the buddy allocator accepts it
+    uint64_t seed = 42;
+    size_t sample_every = 64;     // ops between fragmentation samples
+    std::string json_path = "bench_results.json";
+};
+
+struct BenchResult {
+    std::string workload;
+    std::string allocator;
+    size_t ops;
+    size_t failed;
+    double mean_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double p999_ns;
+    double max_ns;
+    double ops_per_sec;
+    size_t peak_frag;         // external fragmentation, percent
+    size_t peak_utilization;  // used / total, percent
+};
+
+// Uniform interface over the two allocators
+struct StandardAdapter {
+    MemoryManager mm;
+    StandardAdapter(AllocStrategy strategy, size_t memory) {
+        mm.setVerbose(false);
+        mm.init(memory);
+        mm.setStrategy(strategy);
+    }
+    int alloc(size_t size) { return mm.malloc(size); }
+    void release(int id) { mm.free(id); }
+    size_t fragmentation() const { return mm.calculateExternalFragmentation(); }
+    size_t used() const { return mm.getUsedMemory(); }
+};
+
+struct BuddyAdapter {
+    BuddyAllocator buddy;
+    explicit BuddyAdapter(size_t memory) {
+        buddy.setVerbose(false);
+        buddy.init(memory);
+    }
+    int alloc(size_t size) { return buddy.allocate(size); }
+    void release(int id) { buddy.free(id); }
+    size_t fragmentation() const { return buddy.calculateExternalFragmentation(); }
+    size_t used() const { return buddy.getUsedMemory(); }
+};
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+template <typename Adapter>
+BenchResult runWorkload(Adapter& allocator, const Workload& workload, const std::string& name,
+                        const BenchConfig& config) {
+    BenchResult r;
+    r.workload = workload.name;
+    r.allocator = name;
+    r.ops = workload.ops.size();
+    r.failed = 0;
+    r.peak_frag = 0;
+    r.peak_utilization = 0;
+
+    std::vector<int> ids(workload.num_objects, -1);
+    std::vector<double> times;
+    times.reserve(workload.ops.size());
+    double total_ns = 0.0;
+
+    MEMSIM_PHASE(workload.name + " / " + name);
+    for (size_t i = 0; i < workload.ops.size(); i++) {
+        const WorkloadOp& op = workload.ops[i];
+        if (op.type == WorkloadOp::ALLOC) {
+            auto start = Clock::now();
+            int id = allocator.alloc(op.size);
+            auto end = Clock::now();
+            ids[op.object] = id;
+            if (id == -1) r.failed++;
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        } else {
+            int id = ids[op.object];
+            if (id == -1) continue;  // the allocation failed, nothing to free
+            auto start = Clock::now();
+            allocator.release(id);
+            auto end = Clock::now();
+            ids[op.object] = -1;
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        total_ns += times.back();
+
+        // Sample outside the timed region
+        if (i % config.sample_every == 0) {
+            r.peak_frag = std::max(r.peak_frag, allocator.fragmentation());
+            r.peak_utilization = std::max(r.peak_utilization, allocator.used() * 100 / config.memory);
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    r.mean_ns = times.empty() ? 0.0 : total_ns / times.size();
+    r.p50_ns = percentile(times, 0.50);
+    r.p90_ns = percentile(times, 0.90);
+    r.p99_ns = percentile(times, 0.99);
+    r.p999_ns = percentile(times, 0.999);
+    r.max_ns = times.empty() ? 0.0 : times.back();
+    r.ops_per_sec = total_ns > 0.0 ? times.size() * 1e9 / total_ns : 0.0;
+    return r;
+}
+
+static void printResult(const BenchResult& r) {
+    std::cout << std::left << std::setw(18) << r.workload << std::setw(11) << r.allocator
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(9) << r.mean_ns << std::setw(9) << r.p50_ns
+              << std::setw(9) << r.p99_ns << std::setw(10) << r.p999_ns
+              << std::setw(12) << r.ops_per_sec
+              << std::setw(7) << r.peak_frag << "%" << std::setw(7) << r.peak_utilization << "%"
+              << std::setw(8) << r.failed << "\n";
+}
+
+static void writeJson(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    std::ofstream out(config.json_path);
+    if (!out) {
+        std::cout << "Error: Cannot write " << config.json_path << "\n";
+        return;
+    }
+
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"benchmark\": \"alloc_bench\",\n"
+        << "  \"ops\": " << config.num_ops << ",\n"
+        << "  \"memory\": " << config.memory << ",\n"
+        << "  \"seed\": " << config.seed << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"workload\": \"" << r.workload << "\", \"allocator\": \"" << r.allocator
+            << "\", \"ops\": " << r.ops << ", \"failed\": " << r.failed
+            << ", \"mean_ns\": " << r.mean_ns << ", \"p50_ns\": " << r.p50_ns
+            << ", \"p90_ns\": " << r.p90_ns << ", \"p99_ns\": " << r.p99_ns
+            << ", \"p999_ns\": " << r.p999_ns << ", \"max_ns\": " << r.max_ns
+            << ", \"ops_per_sec\": " << r.ops_per_sec
+            << ", \"peak_external_frag_pct\": " << r.peak_frag
+            << ", \"peak_utilization_pct\": " << r.peak_utilization << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    std::cout << "\nResults written to " << config.json_path << "\n";
+}
+
+static void printUsage() {
+    std::cout << "Usage: alloc_bench [--ops N] [--memory BYTES] [--seed S] [--json FILE]\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (arg == "--ops") config.num_ops = std::stoull(argv[++i]);
+        else if (arg == "--memory") config.memory = std::stoull(argv[++i]);
+        else if (arg == "--seed") config.seed = std::stoull(argv[++i]);
+        else if (arg == "--json") config.json_path = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    const WorkloadKind kinds[] = {WORKLOAD_UNIFORM, WORKLOAD_POWER_LAW,
+                                  WORKLOAD_BURSTY, WORKLOAD_PRODUCER_CONSUMER};
+    const struct { AllocStrategy strategy; const char* name; } strategies[] = {
+        {FIRST_FIT, "first_fit"}, {NEXT_FIT, "next_fit"},
+        {BEST_FIT, "best_fit"}, {WORST_FIT, "worst_fit"}};
+
+    std::cout << "=== Allocator Benchmark ===\n";
+    std::cout << config.num_ops << " ops per workload, " << config.memory
+              << " bytes of memory, seed " << config.seed << "\n\n";
+    std::cout << std::left << std::setw(18) << "workload" << std::setw(11) << "allocator"
+              << std::right << std::setw(9) << "mean ns" << std::setw(9) << "p50 ns"
+              << std::setw(9) << "p99 ns" << std::setw(10) << "p99.9 ns"
+              << std::setw(12) << "ops/sec" << std::setw(8) << "frag" << std::setw(8) << "util"
+              << std::setw(8) << "failed" << "\n";
+
+    std::vector<BenchResult> results;
+    for (WorkloadKind kind : kinds) {
+        // Every allocator sees the identical trace
+        Workload workload = generateWorkload(kind, config.num_ops, config.seed);
+
+        for (const auto& s : strategies) {
+            StandardAdapter allocator(s.strategy, config.memory);
+            results.push_back(runWorkload(allocator, workload, s.name, config));
+            printResult(results.back());
+        }
+        BuddyAdapter buddy(config.memory);
+        results.push_back(runWorkload(buddy, workload, "buddy", config));
+        printResult(results.back());
+    }
+
+    writeJson(results, config);
+    if (profileCompiled()) {
+        profileReport();
+    }
+    return 0;
+}
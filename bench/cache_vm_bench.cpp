@@ -0,0 +1,330 @@
+#include "AccessPattern.h"
+#include "FixedCache.h"
+#include "SampledCache.h"
+#include "VirtualMemory.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cache and virtual memory micro-benchmark: drives Cache::access and
+// VirtualMemory::translate with generated address patterns and measures the
+// simulator's own throughput alongside the simulated hit ratio.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    size_t accesses = 200000;
+    size_t footprint = 16 << 20;  // bytes touched by each pattern
+    size_t repeats = 5;
+    uint64_t seed = 42;
+    std::string json_path = "bench_cache_vm.json";
+};
+
+struct BenchResult {
+    std::string target;   // "cache" or "vm"
+    std::string impl;     // "generic" or "fixed" for caches
+    std::string config;
+    std::string pattern;
+    size_t accesses;
+    double best_ops_per_sec;
+    double median_ops_per_sec;
+    double hit_ratio;     // percent
+    double hit_ratio_ci = -1;  // 95% half-width for sampled caches, percent
+};
+
+struct CacheConfig {
+    const char* name;
+    size_t size;
+    size_t block_size;
+    size_t associativity;
+    ReplacementPolicy policy;
+};
+
+struct VmConfig {
+    const char* name;
+    size_t num_pages;
+    size_t page_size;
+    size_t num_frames;
+    PageReplacementPolicy policy;
+};
+
+// Constructors announce themselves on stdout; keep that out of the table
+class QuietScope {
+public:
+    QuietScope() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+    ~QuietScope() { std::cout.rdbuf(saved); }
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+};
+
+// One untimed warm-up pass, then `repeats` timed passes from a reset state.
+// Hit ratio is the same for every pass since each starts from reset.
+template <typename Reset, typename Run, typename Ratio>
+BenchResult measure(const std::vector<size_t>& addresses, const BenchConfig& config,
+                    [[maybe_unused]] const std::string& phase, Reset reset, Run run, Ratio ratio) {
+    BenchResult r;
+    r.accesses = addresses.size();
+
+    reset();
+    run();
+
+    std::vector<double> rates;
+    MEMSIM_PHASE(phase);
+    for (size_t i = 0; i < config.repeats; i++) {
+        reset();
+        auto start = Clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        rates.push_back(seconds > 0.0 ? addresses.size() / seconds : 0.0);
+    }
+    r.hit_ratio = ratio();
+
+    std::sort(rates.begin(), rates.end());
+    r.best_ops_per_sec = rates.back();
+    r.median_ops_per_sec = rates[rates.size() / 2];
+    return r;
+}
+
+// Median time of reset() right after a pass over the addresses, the cost a
+// parameter sweep pays between runs
+template <typename Reset, typename Run>
+double measureReset(const BenchConfig& config, Reset reset, Run run) {
+    std::vector<double> times;
+    for (size_t i = 0; i < config.repeats; i++) {
+        run();
+        auto start = Clock::now();
+        reset();
+        times.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static void printResult(const BenchResult& r) {
+    std::cout << std::left << std::setw(7) << r.target << std::setw(9) << r.impl
+              << std::setw(16) << r.config
+              << std::setw(15) << r.pattern << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << r.median_ops_per_sec / 1e6 << std::setw(14)
+              << r.best_ops_per_sec / 1e6 << std::setw(10) << std::setprecision(2)
+              << r.hit_ratio << "%";
+    if (r.hit_ratio_ci >= 0) {
+        std::cout << " +/- " << r.hit_ratio_ci << "%";
+    }
+    std::cout << "\n";
+}
+
+static void writeJson(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    std::ofstream out(config.json_path);
+    if (!out) {
+        std::cout << "Error: Cannot write " << config.json_path << "\n";
+        return;
+    }
+
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"benchmark\": \"cache_vm_bench\",\n"
+        << "  \"accesses\": " << config.accesses << ",\n"
+        << "  \"footprint\": " << config.footprint << ",\n"
+        << "  \"repeats\": " << config.repeats << ",\n"
+        << "  \"seed\": " << config.seed << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"target\": \"" << r.target << "\", \"impl\": \"" << r.impl
+            << "\", \"config\": \"" << r.config
+            << "\", \"pattern\": \"" << r.pattern << "\", \"accesses\": " << r.accesses
+            << ", \"median_accesses_per_sec\": " << r.median_ops_per_sec
+            << ", \"best_accesses_per_sec\": " << r.best_ops_per_sec
+            << ", \"hit_ratio_pct\": " << r.hit_ratio;
+        if (r.hit_ratio_ci >= 0) {
+            out << ", \"hit_ratio_ci95_pct\": " << r.hit_ratio_ci;
+        }
+        out << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    std::cout << "\nResults written to " << config.json_path << "\n";
+}
+
+static void printUsage() {
+    std::cout << "Usage: cache_vm_bench [--accesses N] [--footprint BYTES] [--repeats R]"
+              << " [--seed S] [--json FILE]\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (arg == "--accesses") config.accesses = std::stoull(argv[++i]);
+        else if (arg == "--footprint") config.footprint = std::stoull(argv[++i]);
+        else if (arg == "--repeats") config.repeats = std::stoull(argv[++i]);
+        else if (arg == "--seed") config.seed = std::stoull(argv[++i]);
+        else if (arg == "--json") config.json_path = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.repeats == 0) config.repeats = 1;
+
+    const PatternKind patterns[] = {PATTERN_SEQUENTIAL, PATTERN_STRIDED, PATTERN_RANDOM,
+                                    PATTERN_ZIPFIAN, PATTERN_POINTER_CHASE,
+                                    PATTERN_MATRIX_TILED};
+    const CacheConfig caches[] = {
+        {"32K-1way", 32 << 10, 64, 1, LRU},
+        {"32K-8way-lru", 32 << 10, 64, 8, LRU},
+        {"32K-8way-fifo", 32 << 10, 64, 8, FIFO},
+        {"32K-8way-plru", 32 << 10, 64, 8, TREE_PLRU},
+        {"32K-8way-srrip", 32 << 10, 64, 8, SRRIP},
+        {"32K-8way-drrip", 32 << 10, 64, 8, DRRIP},
+        {"32K-8way-random", 32 << 10, 64, 8, RANDOM_REPLACEMENT},
+        {"1M-16way-lru", 1 << 20, 64, 16, LRU},
+    };
+    const VmConfig vms[] = {
+        {"4K-pages-fifo", config.footprint / 4096, 4096, 1024, PAGE_FIFO},
+        {"4K-pages-lru", config.footprint / 4096, 4096, 1024, PAGE_LRU},
+    };
+
+    std::cout << "=== Cache / VM Benchmark ===\n";
+    std::cout << config.accesses << " accesses per run, " << config.footprint
+              << " byte footprint, " << config.repeats << " timed repeats after warm-up\n\n";
+    std::cout << std::left << std::setw(7) << "target" << std::setw(9) << "impl"
+              << std::setw(16) << "config"
+              << std::setw(15) << "pattern" << std::right << std::setw(14) << "median Macc/s"
+              << std::setw(14) << "best Macc/s" << std::setw(11) << "hit ratio" << "\n";
+
+    std::vector<BenchResult> results;
+    for (PatternKind kind : patterns) {
+        std::vector<size_t> addresses =
+            generatePattern(kind, config.accesses, config.footprint, config.seed);
+
+        // Each geometry runs on the generic Cache and on the specialization
+        // chosen by makeCache, so the two can be compared directly
+        for (const CacheConfig& c : caches) {
+            for (int fixed = 0; fixed < 2; fixed++) {
+                std::unique_ptr<CacheBase> cache;
+                {
+                    QuietScope quiet;
+                    if (fixed) {
+                        cache = makeCache("bench", c.size, c.block_size, c.associativity, c.policy);
+                    } else {
+                        cache = std::make_unique<Cache>("bench", c.size, c.block_size,
+                                                        c.associativity, c.policy);
+                    }
+                }
+                // Policies without a specialization only run once
+                bool generic = dynamic_cast<Cache*>(cache.get()) != nullptr;
+                if (fixed && generic) continue;
+                size_t hits = 0;
+                BenchResult r = measure(addresses, config,
+                    std::string("cache ") + (generic ? "generic " : "fixed ") + c.name + " " + patternName(kind),
+                    [&]() { cache->reset(); },
+                    [&]() { for (size_t a : addresses) hits += cache->access(a); },
+                    [&]() { return 100.0 * cache->getHits() / (cache->getHits() + cache->getMisses()); });
+                r.target = "cache";
+                r.impl = generic ? "generic" : "fixed";
+                r.config = c.name;
+                r.pattern = patternName(kind);
+                results.push_back(r);
+                printResult(r);
+            }
+        }
+
+        // The largest cache again with set and time sampling: speed gained
+        // against the error bound on the hit ratio
+        const CacheConfig& big = caches[sizeof(caches) / sizeof(caches[0]) - 1];
+        for (int kind_of_sampling = 0; kind_of_sampling < 2; kind_of_sampling++) {
+            std::unique_ptr<SampledCache> cache;
+            {
+                QuietScope quiet;
+                cache = std::make_unique<SampledCache>(
+                    makeCache("bench", big.size, big.block_size, big.associativity, big.policy));
+                if (kind_of_sampling == 0) {
+                    cache->setSetSampling(16);
+                } else {
+                    cache->setTimeSampling(10000, 1000, 1000);
+                }
+            }
+            size_t hits = 0;
+            BenchResult r = measure(addresses, config,
+                std::string("cache ") + (kind_of_sampling == 0 ? "sets/16 " : "time/10 ") + patternName(kind),
+                [&]() { cache->reset(); },
+                [&]() { for (size_t a : addresses) hits += cache->access(a); },
+                [&]() { return 100.0 * (1.0 - cache->missRatio()); });
+            double half = cache->missRatioHalfWidth();
+            r.hit_ratio_ci = half >= 0 ? 100.0 * half : -1;
+            r.target = "cache";
+            r.impl = kind_of_sampling == 0 ? "sets/16" : "time/10";
+            r.config = big.name;
+            r.pattern = patternName(kind);
+            results.push_back(r);
+            printResult(r);
+        }
+
+        for (const VmConfig& v : vms) {
+            std::unique_ptr<VirtualMemory> vm;
+            {
+                QuietScope quiet;
+                vm = std::make_unique<VirtualMemory>(v.num_pages, v.page_size, v.num_frames, v.policy);
+            }
+            vm->setVerbose(false);
+            size_t sink = 0;
+            BenchResult r = measure(addresses, config,
+                std::string("vm ") + v.name + " " + patternName(kind),
+                [&]() { vm->reset(); },
+                [&]() { for (size_t a : addresses) sink += vm->translate(a); },
+                [&]() { return 100.0 * vm->getPageHits() / (vm->getPageHits() + vm->getPageFaults()); });
+            r.target = "vm";
+            r.impl = "-";
+            r.config = v.name;
+            r.pattern = patternName(kind);
+            results.push_back(r);
+            printResult(r);
+        }
+    }
+
+    // Reset on large configurations only moves to a new epoch, so it should
+    // not grow with the number of lines or pages. The caches come from
+    // makeCache, as in the CLI: LRU gets FixedCache, SRRIP the generic Cache.
+    {
+        std::vector<size_t> addresses =
+            generatePattern(PATTERN_RANDOM, config.accesses, config.footprint, config.seed);
+        std::unique_ptr<CacheBase> fixed;
+        std::unique_ptr<CacheBase> generic;
+        std::unique_ptr<VirtualMemory> vm;
+        {
+            QuietScope quiet;
+            fixed = makeCache("bench", 64 << 20, 64, 16, LRU);
+            generic = makeCache("bench", 64 << 20, 64, 16, SRRIP);
+            vm = std::make_unique<VirtualMemory>(1 << 20, 4096, 4096, PAGE_LRU);
+        }
+        vm->setVerbose(false);
+        size_t sink = 0;
+        double fixed_ns = measureReset(config, [&]() { fixed->reset(); },
+                                       [&]() { for (size_t a : addresses) sink += fixed->access(a); });
+        double generic_ns = measureReset(config, [&]() { generic->reset(); },
+                                         [&]() { for (size_t a : addresses) sink += generic->access(a); });
+        double vm_ns = measureReset(config, [&]() { vm->reset(); },
+                                    [&]() { for (size_t a : addresses) sink += vm->translate(a); });
+        std::cout << "\nReset after a run, 64M-16way caches (1048576 lines): lru " << std::setprecision(0)
+                  << fixed_ns << " ns, srrip " << generic_ns << " ns; 4G vm (1048576 pages, 4096 frames) "
+                  << vm_ns << " ns\n";
+    }
+
+    writeJson(results, config);
+    if (profileCompiled()) {
+        profileReport();
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include "AllocTrace.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <climits>
+#include <malloc.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Overhead of the LD_PRELOAD trace shim: runs a multi-threaded malloc/free
+// loop in child processes with and without the shim and compares the CPU
+// time per call, which unlike wall time does not depend on how many cores
+// the threads share. The traced run's file is kept so it can be replayed.
+
+extern char** environ;
+
+struct BenchConfig {
+    size_t threads = 4;
+    size_t ops = 1000000;         // malloc and free calls per thread
+    size_t repeats = 5;
+    uint64_t seed = 42;
+    bool aligned = false;         // rotate through the aligned allocators
+    std::string shim_path = "bin/libmemsim_trace.so";
+    std::string trace_path = "bench_trace.bin";
+    std::string json_path = "bench_trace.json";
+};
+
+// Allocate with malloc, or with posix_memalign, aligned_alloc, memalign
+// or valloc in turn if `aligned`
+static char* allocate(size_t size, bool aligned, uint64_t x) {
+    if (!aligned) {
+        return static_cast<char*>(std::malloc(size));
+    }
+    size_t alignment = std::min<size_t>(size, 64);
+    void* p = nullptr;
+    switch (x % 4) {
+    case 0: if (posix_memalign(&p, alignment, size) != 0) p = nullptr; break;
+    case 1: p = aligned_alloc(alignment, size); break;
+    case 2: p = memalign(alignment, size); break;
+    default: p = valloc(size); break;
+    }
+    return static_cast<char*>(p);
+}
+
+// Each thread keeps up to 1024 blocks of 16 B to 2 KiB and frees or
+// allocates a random slot per call, writing the first byte of each block
+static void workerLoop(size_t ops, uint64_t seed, bool aligned) {
+    std::vector<char*> slots(1024, nullptr);
+    uint64_t x = seed * 0x9E3779B97F4A7C15ull + 1;
+    for (size_t i = 0; i < ops; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        char*& slot = slots[x % slots.size()];
+        if (slot) {
+            std::free(slot);
+            slot = nullptr;
+        } else {
+            slot = allocate(size_t(16) << ((x >> 20) % 8), aligned, x >> 32);
+            slot[0] = 1;
+        }
+    }
+    for (char* slot : slots) {
+        std::free(slot);
+    }
+}
+
+static double cpuNs() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+}
+
+// Child side: run the workload and print CPU ns per call on one line
+static int runChild(const BenchConfig& config) {
+    double start = cpuNs();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < config.threads; t++) {
+        workers.emplace_back(workerLoop, config.ops, config.seed + t, config.aligned);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    std::cout << (cpuNs() - start) / (config.threads * config.ops) << "\n";
+    return 0;
+}
+
+// Run this program as a child, with the shim preloaded if `traced`, and
+// return the CPU ns per call it reports, or a negative value on failure
+static double spawnChild(const char* self, const BenchConfig& config, bool traced) {
+    std::vector<std::string> args = {self, "--child", "--threads", std::to_string(config.threads),
+                                     "--ops", std::to_string(config.ops),
+                                     "--seed", std::to_string(config.seed)};
+    if (config.aligned) {
+        args.push_back("--aligned");
+    }
+    std::vector<std::string> env;
+    for (char** e = environ; *e; e++) {
+        if (std::strncmp(*e, "LD_PRELOAD=", 11) != 0 && std::strncmp(*e, "MEMSIM_TRACE=", 13) != 0) {
+            env.push_back(*e);
+        }
+    }
+    if (traced) {
+        env.push_back("LD_PRELOAD=" + config.shim_path);
+        env.push_back("MEMSIM_TRACE=" + config.trace_path);
+    }
+    std::vector<char*> argv, envp;
+    for (std::string& a : args) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+    for (std::string& e : env) envp.push_back(&e[0]);
+    envp.push_back(nullptr);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    pid_t pid;
+    int error = posix_spawn(&pid, self, &actions, nullptr, argv.data(), envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error != 0) {
+        close(fds[0]);
+        return -1;
+    }
+
+    std::string output;
+    char chunk[256];
+    ssize_t n;
+    while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) {
+        output.append(chunk, n);
+    }
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || output.empty()) {
+        return -1;
+    }
+    return std::stod(output);
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static void printUsage() {
+    std::cout << "Usage: trace_bench [--threads T] [--ops N] [--repeats R] [--seed S] [--aligned]"
+              << " [--shim LIB] [--trace FILE] [--json FILE]\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    bool child = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--child") {
+            child = true;
+            continue;
+        }
+        if (arg == "--aligned") {
+            config.aligned = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (arg == "--threads") config.threads = std::stoull(argv[++i]);
+        else if (arg == "--ops") config.ops = std::stoull(argv[++i]);
+        else if (arg == "--repeats") config.repeats = std::stoull(argv[++i]);
+        else if (arg == "--seed") config.seed = std::stoull(argv[++i]);
+        else if (arg == "--shim") config.shim_path = argv[++i];
+        else if (arg == "--trace") config.trace_path = argv[++i];
+        else if (arg == "--json") config.json_path = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.threads == 0) config.threads = 1;
+    if (config.ops == 0) config.ops = 1;
+    if (config.repeats == 0) config.repeats = 1;
+    if (child) {
+        return runChild(config);
+    }
+
+    // The dynamic loader needs a path it can open from the child's cwd
+    char resolved[PATH_MAX];
+    if (!realpath(config.shim_path.c_str(), resolved)) {
+        std::cout << "Error: Cannot find " << config.shim_path << " (build it with make trace)\n";
+        return 1;
+    }
+    config.shim_path = resolved;
+    char self[PATH_MAX];
+    ssize_t self_len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (self_len <= 0) {
+        std::cout << "Error: Cannot locate this executable\n";
+        return 1;
+    }
+    self[self_len] = '\0';
+
+    std::cout << "=== Trace Shim Overhead ===\n";
+    std::cout << config.threads << " threads x " << config.ops
+              << (config.aligned ? " aligned alloc/free" : " malloc/free") << " calls, median of "
+              << config.repeats << " runs\n\n";
+
+    // Alternate the two so drift in machine load hits both alike
+    std::vector<double> untraced, traced;
+    for (size_t r = 0; r < config.repeats; r++) {
+        double plain = spawnChild(self, config, false);
+        double shimmed = spawnChild(self, config, true);
+        if (plain < 0 || shimmed < 0) {
+            std::cout << "Error: Benchmark child failed\n";
+            return 1;
+        }
+        untraced.push_back(plain);
+        traced.push_back(shimmed);
+    }
+    double base_ns = median(untraced);
+    double traced_ns = median(traced);
+
+    std::ifstream trace(config.trace_path, std::ios::binary | std::ios::ate);
+    size_t trace_bytes = trace ? (size_t)trace.tellg() : 0;
+    size_t records = trace_bytes > sizeof(AllocTraceHeader) ?
+                     (trace_bytes - sizeof(AllocTraceHeader)) / sizeof(AllocTraceRecord) : 0;
+    double calls = double(config.threads) * config.ops;
+
+    std::cout << std::left << std::setw(12) << "" << std::right << std::setw(18) << "CPU ns per call"
+              << std::setw(20) << "Mcalls/s per core" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(12) << "untraced" << std::right << std::setw(18) << base_ns
+              << std::setw(20) << 1e3 / base_ns << "\n";
+    std::cout << std::left << std::setw(12) << "traced" << std::right << std::setw(18) << traced_ns
+              << std::setw(20) << 1e3 / traced_ns << "\n";
+    std::cout << "\nOverhead: " << 100.0 * (traced_ns - base_ns) / base_ns << "% ("
+              << traced_ns - base_ns << " ns more per call)\n";
+    std::cout << "Trace: " << records << " records (" << std::setprecision(2) << records / calls
+              << " per call), " << trace_bytes << " bytes in " << config.trace_path << "\n";
+
+    std::ofstream out(config.json_path);
+    if (!out) {
+        std::cout << "Error: Cannot write " << config.json_path << "\n";
+        return 1;
+    }
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"benchmark\": \"trace_bench\",\n"
+        << "  \"threads\": " << config.threads << ",\n"
+        << "  \"ops\": " << config.ops << ",\n"
+        << "  \"repeats\": " << config.repeats << ",\n"
+        << "  \"seed\": " << config.seed << ",\n"
+        << "  \"aligned\": " << (config.aligned ? "true" : "false") << ",\n"
+        << "  \"untraced_cpu_ns_per_call\": " << base_ns << ",\n"
+        << "  \"traced_cpu_ns_per_call\": " << traced_ns << ",\n"
+        << "  \"overhead_pct\": " << 100.0 * (traced_ns - base_ns) / base_ns << ",\n"
+        << "  \"records\": " << records << ",\n"
+        << "  \"trace_bytes\": " << trace_bytes << "\n}\n";
+    std::cout << "\nResults written to " << config.json_path << "\n";
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Allocation traces recorded from a live process by the LD_PRELOAD shim
+// (libmemsim_trace.so) and replayed against the simulated allocators.
+//
+// File layout, host byte order: one AllocTraceHeader, then 24-byte
+// records. Each thread buffers its records and appends them in chunks, so
+// the file is ordered by time within a thread but not across threads.
+
+const uint64_t ALLOC_TRACE_MAGIC = 0x52544D49534D454DULL;  // "MEMSIMTR" little-endian
+const uint32_t ALLOC_TRACE_VERSION = 1;
+
+enum AllocTraceOp : uint8_t {
+    TRACE_MALLOC,
+    TRACE_CALLOC,
+    TRACE_REALLOC,  // the new block; the old one has its own TRACE_FREE first
+    TRACE_FREE,
+    TRACE_ALIGNED   // posix_memalign, aligned_alloc, memalign or valloc
+};
+
+struct AllocTraceHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_bytes;
+    uint64_t pid;
+    uint64_t start_ns;    // CLOCK_REALTIME when tracing started
+};
+
+// Allocations are stamped after the real call returns and frees before it
+// is made, so a block freed by one thread and reused by another sorts in
+// the right order.
+struct AllocTraceRecord {
+    uint64_t time_ns;     // CLOCK_MONOTONIC, since tracing started
+    uint64_t address;     // block returned, or freed
+    uint32_t size;        // bytes requested, saturated; 0 for TRACE_FREE
+    uint16_t thread;      // threads numbered from 0 in order of first record
+    uint8_t op;
+    uint8_t align_shift;  // log2 of the alignment for TRACE_ALIGNED, else 0
+};
+
+static_assert(sizeof(AllocTraceHeader) == 32, "AllocTraceHeader should be 32 bytes");
+static_assert(sizeof(AllocTraceRecord) == 24, "AllocTraceRecord should be 24 bytes");
+
+class MemoryManager;
+class BuddyAllocator;
+
+// Reads every record and sorts them by time, keeping the file order of
+// equal times. Prints an error and returns false if the file is rejected.
+bool readAllocTrace(const std::string& path, AllocTraceHeader& header,
+                    std::vector<AllocTraceRecord>& records);
+
+// Replay a trace in time order: each traced block becomes a simulated
+// allocation of the same size, freed when the traced block is. Aligned
+// allocations are replayed as plain ones of the same size. Frees of
+// blocks allocated before tracing started are counted and skipped.
+bool replayAllocTrace(const std::string& path, MemoryManager& memory);
+bool replayAllocTrace(const std::string& path, BuddyAllocator& buddy);
+
+#endif // ALLOC_TRACE_H
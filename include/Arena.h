@@ -0,0 +1,77 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "MemoryManager.h"
+#include <map>
+#include <vector>
+#include <cstddef>
+
+class BuddyAllocator;
+
+// A bump-pointer region carved out of one block of the underlying allocator.
+// Objects in an arena are never freed individually; reset releases them all.
+struct Arena {
+    int id;
+    int backing_id;      // block id in the underlying allocator
+    size_t base;         // start address of the backing block
+    size_t capacity;     // usable bytes in the backing block
+    size_t offset;       // bump pointer, relative to base
+    size_t peak_offset;  // highest offset reached since creation
+
+    // Statistics
+    size_t alloc_count;
+    size_t failed_allocs;
+    size_t reset_count;
+    size_t requested_bytes;  // bytes asked for in the current region
+    size_t padding_bytes;    // alignment padding in the current region
+
+    // Request sizes of the current region (or the last one before a reset),
+    // replayed against per-object malloc/free by ArenaManager::stats. Only
+    // the first TRACE_LIMIT requests of a region are kept.
+    std::vector<size_t> trace;
+    std::vector<size_t> last_trace;
+    size_t last_alloc_count;  // allocations in the region before the last reset
+
+    Arena(int arena_id = -1, int block_id = -1, size_t addr = 0, size_t cap = 0)
+        : id(arena_id), backing_id(block_id), base(addr), capacity(cap),
+          offset(0), peak_offset(0), alloc_count(0), failed_allocs(0),
+          reset_count(0), requested_bytes(0), padding_bytes(0), last_alloc_count(0) {}
+};
+
+class ArenaManager {
+public:
+    static const size_t ALIGNMENT = 8;
+    static const size_t TRACE_LIMIT = 1 << 16;  // request sizes kept per region
+
+    explicit ArenaManager(MemoryManager& manager);
+    explicit ArenaManager(BuddyAllocator& allocator);
+
+    int create(size_t size);
+    size_t allocate(int arena_id, size_t size);
+    void reset(int arena_id);
+    void destroy(int arena_id);
+    void clear();
+    // Arena whose region is the given block of the underlying allocator,
+    // -1 if none; such a block may only be released by destroy
+    int ownerOf(int block_id) const;
+    void stats(int arena_id) const;
+    void stats() const;
+
+    // Follow backing blocks moved by MemoryManager::compact
+    void relocate(const std::vector<Relocation>& relocations);
+
+private:
+    MemoryManager* memory_manager;
+    BuddyAllocator* buddy_allocator;
+    std::map<int, Arena> arenas;
+    int next_id;
+
+    // Helper methods
+    int backingAllocate(size_t size);
+    void backingFree(int block_id);
+    size_t backingAddress(int block_id) const;
+    size_t backingSize(int block_id) const;
+    void compareWithMalloc(const Arena& arena) const;
+};
+
+#endif // ARENA_H
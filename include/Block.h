@@ -1,16 +1,29 @@
-#ifndef BLOCK_H
-#define BLOCK_H
-
-#include <cstddef>
-
-struct Block {
-    size_t address;  // start offset in physical memory
-    size_t size;     // length of this block
-    bool is_free;    // true if free, false if allocated
-    int id;          // block ID for tracking allocations
-    
-    Block(size_t addr = 0, size_t sz = 0, bool free = true, int block_id = -1)
-        : address(addr), size(sz), is_free(free), id(block_id) {}
-};
-
-#endif // BLOCK_H
\ No newline at end of file
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <cstdint>
+
+// 12 bytes per block. Address and size count granules of the owning
+// MemoryManager, which are single bytes unless memory exceeds 4 GiB.
+// Allocation times of live blocks are kept by the MemoryManager.
+struct Block {
+    uint32_t address;     // start offset in physical memory, in granules
+    uint32_t size;        // length of this block, in granules
+    int32_t id;           // block ID for tracking allocations, -1 if free
+    
+    Block(uint32_t addr = 0, uint32_t sz = 0, int block_id = -1)
+        : address(addr), size(sz), id(block_id) {}
+    
+    bool isFree() const { return id < 0; }
+};
+
+static_assert(sizeof(Block) == 12, "Block should pack into 12 bytes");
+
+// Allocation time of a live block, in allocator operations from the
+// MemoryManager's epoch base
+struct AllocTime {
+    int32_t id;
+    uint32_t time;
+};
+
+#endif // BLOCK_H
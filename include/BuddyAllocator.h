@@ -1,46 +1,80 @@
-#ifndef BUDDY_ALLOCATOR_H
-#define BUDDY_ALLOCATOR_H
-
-#include <map>
-#include <list>
-#include <cstddef>
-
-struct BuddyBlock {
-    size_t address;
-    size_t size;
-    int id;
-    
-    BuddyBlock(size_t addr = 0, size_t sz = 0, int block_id = -1)
-        : address(addr), size(sz), id(block_id) {}
-};
-
-class BuddyAllocator {
-public:
-    BuddyAllocator();
-    
-    void init(size_t total_size);
-    int allocate(size_t size);
-    void free(int block_id);
-    void dump() const;
-    void stats() const;
-    
-private:
-    std::map<size_t, std::list<size_t>> free_lists;  // free lists keyed by block size
-    std::map<int, BuddyBlock> allocated_blocks;      // track allocated blocks by ID
-    size_t total_memory;
-    size_t used_memory;
-    int next_id;
-    
-    // Statistics
-    size_t total_alloc_requests;
-    size_t failed_requests;
-    size_t internal_frag;
-    
-    // Helper methods
-    size_t nextPowerOfTwo(size_t n) const;
-    bool isPowerOfTwo(size_t n) const;
-    size_t getBuddyAddress(size_t address, size_t size) const;
-    void splitBlock(size_t address, size_t current_size, size_t target_size);
-};
-
+#ifndef BUDDY_ALLOCATOR_H
+#define BUDDY_ALLOCATOR_H
+
+#include "Histogram.h"
+#include "SampleWriter.h"
+#include <map>
+#include <list>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <ostream>
+
+struct BuddyBlock {
+    size_t address;
+    size_t size;
+    int id;
+    size_t alloc_time;  // allocator operation count when the block was handed out
+    
+    BuddyBlock(size_t addr = 0, size_t sz = 0, int block_id = -1, size_t time = 0)
+        : address(addr), size(sz), id(block_id), alloc_time(time) {}
+};
+
+class BuddyAllocator {
+public:
+    BuddyAllocator();
+    
+    void init(size_t total_size);
+    int allocate(size_t size);
+    void free(int block_id);
+    void dump() const;
+    void stats() const;
+    void writeStatsJson(std::ostream& out) const;
+    void setVerbose(bool on) { verbose = on; }
+    
+    // Write utilization and the free-list length of every order (order k
+    // holds 2^k-byte blocks) to a CSV or JSONL file every `interval`
+    // allocate/free calls
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+    
+    // Binary snapshot of the free lists, allocated blocks, counters and histograms
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    
+    // Lookup of an allocated block, SIZE_MAX if the id is not in use
+    size_t getBlockAddress(int block_id) const;
+    size_t getBlockSize(int block_id) const;
+    size_t getTotalMemory() const { return total_memory; }
+    size_t getUsedMemory() const { return used_memory; }
+    size_t calculateExternalFragmentation() const;
+    
+private:
+    std::map<size_t, std::list<size_t>> free_lists;  // free lists keyed by block size
+    std::map<int, BuddyBlock> allocated_blocks;      // track allocated blocks by ID
+    size_t total_memory;
+    size_t used_memory;
+    int next_id;
+    bool verbose;  // print per-operation messages
+    
+    // Statistics
+    size_t total_alloc_requests;
+    size_t failed_requests;
+    size_t internal_frag;
+    size_t op_clock;         // allocate and free calls since init, the lifetime clock
+    Histogram size_hist;     // requested allocation sizes
+    Histogram lifetime_hist; // operations between allocate and free of a block
+    
+    SampleWriter sampler;
+    std::vector<double> sample_row;
+    
+    // Helper methods
+    size_t nextPowerOfTwo(size_t n) const;
+    bool isPowerOfTwo(size_t n) const;
+    size_t getBuddyAddress(size_t address, size_t size) const;
+    void splitBlock(size_t address, size_t current_size, size_t target_size);
+    void beginOperation();
+    void takeSample();
+};
+
 #endif // BUDDY_ALLOCATOR_H
\ No newline at end of file
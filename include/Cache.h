@@ -1,52 +1,172 @@
-#ifndef CACHE_H
-#define CACHE_H
-
-#include <vector>
-#include <cstddef>
-#include <string>
-
-struct CacheLine {
-    bool valid;
-    size_t tag;
-    size_t timestamp;  // For LRU or FIFO
-    
-    CacheLine() : valid(false), tag(0), timestamp(0) {}
-};
-
-enum ReplacementPolicy {
-    FIFO,
-    LRU
-};
-
-class Cache {
-public:
-    Cache(const std::string& name, size_t cache_size, size_t block_size, 
-          size_t associativity, ReplacementPolicy policy = FIFO);
-    
-    bool access(size_t address);
-    void stats() const;
-    void reset();
-    std::string getName() const { return name; }
-    
-private:
-    std::string name;
-    size_t cache_size;
-    size_t block_size;
-    size_t associativity;
-    size_t num_sets;
-    ReplacementPolicy policy;
-    
-    std::vector<std::vector<CacheLine>> sets;
-    
-    size_t hits;
-    size_t misses;
-    size_t time_counter;
-    
-    // Helper methods
-    size_t getSetIndex(size_t address) const;
-    size_t getTag(size_t address) const;
-    int findLine(size_t set_index, size_t tag) const;
-    int findVictim(size_t set_index);
-};
-
-#endif // CACHE_H
\ No newline at end of file
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "ReuseDistance.h"
+#include "SampleWriter.h"
+#include "Snapshot.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+// 16 bytes with padding. Stamps are offsets below 2^31 from the owning
+// cache's stamp base, which leaves a bit beside the stamp for the valid flag.
+struct CacheLine {
+    uint64_t tag;
+    uint32_t timestamp : 31;   // For LRU or FIFO; other policies keep per-set bits
+    uint32_t valid : 1;
+
+    CacheLine() : tag(0), timestamp(0), valid(0) {}
+};
+
+static_assert(sizeof(CacheLine) == 16, "CacheLine should pack into 16 bytes");
+
+// Line stamps are rebased when they pass 31 bits, keeping this much history
+const size_t LINE_STAMP_KEEP = size_t(1) << 30;
+const size_t LINE_STAMP_MAX = (size_t(1) << 31) - 1;
+
+enum ReplacementPolicy {
+    FIFO,
+    LRU,
+    TREE_PLRU,           // binary tree pseudo-LRU, power-of-two ways up to 64
+    SRRIP,               // static re-reference interval prediction, up to 32 ways
+    BRRIP,               // bimodal RRIP: inserts distant, rarely long
+    DRRIP,               // set dueling between SRRIP and BRRIP
+    RANDOM_REPLACEMENT
+};
+
+const char* policyName(ReplacementPolicy policy);
+
+// Geometry, counters and reporting shared by every cache implementation.
+// Derived classes supply the lookup and replacement.
+class CacheBase {
+public:
+    // announce = false skips the "initialized" line, for wrappers
+    CacheBase(const std::string& name, size_t cache_size, size_t block_size,
+              size_t associativity, ReplacementPolicy policy, bool announce = true);
+    virtual ~CacheBase() {}
+
+    virtual bool access(size_t address) = 0;
+    virtual void reset() = 0;
+    // Drop the line holding address, for coherence (Coherence.h); false if
+    // it was not cached
+    virtual bool invalidate(size_t address) = 0;
+    // After a miss: block address of the line it replaced, or SIZE_MAX if
+    // it filled an empty way
+    virtual size_t lastEvicted() const { return last_evicted; }
+    // False when a sampled cache skipped the last access (SampledCache.h)
+    virtual bool lastAccessSimulated() const { return true; }
+    virtual void stats() const;
+    virtual void writeStatsJson(std::ostream& out) const;
+    std::string getName() const { return name; }
+    size_t getSize() const { return cache_size; }
+    size_t getBlockSize() const { return block_size; }
+    size_t getAssociativity() const { return associativity; }
+    ReplacementPolicy getPolicy() const { return policy; }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+    // Bytes of tag and replacement state, reported by stats
+    virtual size_t metadataBytes() const = 0;
+
+    // Write the hit ratio of the last `interval` accesses, and overall, to a
+    // CSV or JSONL file every `interval` accesses
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+
+    // Binary snapshot: geometry, counters, reuse distances, then every line
+    // in a layout shared by all implementations. loadCache (FixedCache.h)
+    // reads the geometry and rebuilds the cache through makeCache.
+    virtual bool save(const std::string& path) const;
+    bool loadState(SnapshotReader& in);
+
+protected:
+    std::string name;
+    size_t cache_size;
+    size_t block_size;
+    size_t associativity;
+    size_t num_sets;
+    ReplacementPolicy policy;
+
+    size_t hits;
+    size_t misses;
+    size_t last_evicted;
+
+    // Distinct blocks between consecutive accesses to a block, hit or miss,
+    // from a fixed-size sample of blocks
+    ReuseDistance reuse;
+
+    SampleWriter sampler;
+    size_t window_hits;    // hits at the previous sample
+    size_t window_misses;  // misses at the previous sample
+
+    // Called at the start of every access
+    void beginAccess() {
+        if (sampler.tick()) {
+            takeSample();
+        }
+    }
+    void takeSample();
+
+    // Per-line state in the shared layout: time counter, PSEL, RNG state,
+    // set count, ways, one replacement word per set, then one CacheLine
+    // record per line
+    virtual void saveLines(SnapshotWriter& out) const = 0;
+    virtual bool loadLines(SnapshotReader& in) = 0;
+    bool checkGeometry(SnapshotReader& in, uint64_t sets, uint64_t ways) const;
+
+    // Clear counters, histograms and the sampling window for reset()
+    void resetCounters();
+};
+
+// Generic cache: any geometry, associativity and policy chosen at runtime
+class Cache : public CacheBase {
+public:
+    Cache(const std::string& name, size_t cache_size, size_t block_size,
+          size_t associativity, ReplacementPolicy policy = FIFO, bool announce = true);
+
+    bool access(size_t address) override;
+    // O(1): sets are invalidated by moving to a new epoch and cleared on
+    // their next access
+    void reset() override;
+    bool invalidate(size_t address) override;
+    size_t metadataBytes() const override;
+
+protected:
+    void saveLines(SnapshotWriter& out) const override;
+    bool loadLines(SnapshotReader& in) override;
+
+private:
+    enum DuelRole { FOLLOWER, SRRIP_LEADER, BRRIP_LEADER };
+
+    // All sets in one array, set by set
+    std::vector<CacheLine> lines;
+    std::vector<uint64_t> set_bits;  // PLRU tree or packed RRPVs, one word per set
+    std::vector<uint16_t> set_epoch; // epoch each set was last cleared in
+    uint16_t epoch;                  // reset count, mod 2^16; sets of other epochs are stale
+
+    size_t time_counter;
+    size_t stamp_base;               // time_counter value line stamps count from
+    unsigned psel;                   // DRRIP policy selector, 10-bit saturating
+    uint64_t rng_state;              // BRRIP insertion and random replacement
+
+    // Helper methods
+    size_t getSetIndex(size_t address) const;
+    size_t getTag(size_t address) const;
+    CacheLine& line(size_t set_index, size_t way) { return lines[set_index * associativity + way]; }
+    const CacheLine& line(size_t set_index, size_t way) const {
+        return lines[set_index * associativity + way];
+    }
+    bool isStale(size_t set_index) const { return set_epoch[set_index] != epoch; }
+    void clearSet(size_t set_index);
+    uint32_t stamp() const { return time_counter - stamp_base; }
+    void rebaseStamps();
+    int findLine(size_t set_index, size_t tag) const;
+    int findVictim(size_t set_index);
+    void touchLine(size_t set_index, size_t line_index);
+    void fillLine(size_t set_index, size_t line_index);
+    DuelRole duelRole(size_t set_index) const;
+    bool isRrip() const { return policy == SRRIP || policy == BRRIP || policy == DRRIP; }
+};
+
+#endif // CACHE_H
@@ -0,0 +1,124 @@
+#ifndef CO_SIMULATION_H
+#define CO_SIMULATION_H
+
+#include "MemoryManager.h"
+#include "BuddyAllocator.h"
+#include "Cache.h"
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstddef>
+#include <ostream>
+
+// Allocator + cache co-simulation. A trace of allocations, frees and
+// accesses at offsets within objects is resolved to addresses by one of the
+// allocators and fed to a cache, so placements can be compared by the
+// misses they cause. The trace is recorded as it is entered and can be
+// replayed under every placement with the same cache.
+
+enum Placement {
+    PLACEMENT_FIRST_FIT,
+    PLACEMENT_BEST_FIT,
+    PLACEMENT_WORST_FIT,
+    PLACEMENT_NEXT_FIT,
+    PLACEMENT_BUDDY
+};
+
+const char* placementName(Placement placement);
+
+// One trace step. Objects are numbered from 1 in the order of their ALLOC.
+struct CoSimOp {
+    enum Type { ALLOC, FREE, TOUCH } type;
+    size_t object;
+    size_t offset;  // TOUCH: first byte, relative to the object
+    size_t bytes;   // ALLOC: requested size; TOUCH: bytes accessed
+};
+
+// Fully associative LRU cache of block numbers with the same capacity as
+// the real cache. A miss there is a capacity miss; a miss only in the real
+// cache is a conflict miss.
+class LruShadow {
+public:
+    explicit LruShadow(size_t lines) : capacity(lines) {}
+
+    bool access(size_t block);
+
+private:
+    size_t capacity;
+    std::list<size_t> order;  // most recent first
+    std::unordered_map<size_t, std::list<size_t>::iterator> where;
+};
+
+// An allocator and a cache replaying the trace under one placement
+struct PlacementRun {
+    Placement placement;
+    std::unique_ptr<MemoryManager> memory;
+    std::unique_ptr<BuddyAllocator> buddy;
+    std::unique_ptr<CacheBase> cache;
+    LruShadow shadow;
+    std::unordered_set<size_t> seen_blocks;  // for cold misses
+    std::vector<int> block_of;               // allocator block id per object, -1 if none
+    std::vector<size_t> address_of;
+
+    size_t allocations = 0;
+    size_t failed_allocations = 0;
+    size_t split_objects = 0;      // spanning more cache blocks than their size needs
+    size_t accesses = 0;           // cache block accesses
+    size_t skipped_accesses = 0;   // to objects that could not be placed
+    size_t hits = 0;
+    size_t cold_misses = 0;
+    size_t capacity_misses = 0;
+    size_t conflict_misses = 0;
+    size_t peak_used = 0;
+    size_t peak_fragmentation = 0; // external fragmentation, percent
+
+    explicit PlacementRun(size_t shadow_lines) : shadow(shadow_lines) {}
+    size_t misses() const { return cold_misses + capacity_misses + conflict_misses; }
+};
+
+class CoSimulator {
+public:
+    // memory_size must be a power of two so the buddy allocator can replay
+    // the same trace
+    CoSimulator(size_t memory_size, size_t cache_size, size_t block_size,
+                size_t associativity, ReplacementPolicy policy);
+
+    // Replays the recorded trace under the new placement
+    void setPlacement(Placement placement);
+    Placement getPlacement() const { return live->placement; }
+
+    // Each returns false, without recording, if the arguments are invalid.
+    // An allocation the allocator cannot place is still recorded.
+    bool allocate(size_t size);
+    bool release(size_t object);
+    bool touch(size_t object, size_t offset, size_t bytes);
+
+    void reset();
+    // Memory layout of the current placement's allocator
+    void dump() const;
+    void stats() const;
+    // Replay the trace under every placement and print one row each
+    void compare() const;
+    void writeStatsJson(std::ostream& out) const;
+
+private:
+    size_t memory_size;
+    size_t cache_size;
+    size_t block_size;
+    size_t associativity;
+    ReplacementPolicy policy;
+
+    std::vector<CoSimOp> trace;
+    std::vector<size_t> object_size;  // index object - 1
+    std::vector<bool> object_live;
+    std::unique_ptr<PlacementRun> live;
+
+    std::unique_ptr<PlacementRun> newRun(Placement placement) const;
+    void apply(PlacementRun& run, const CoSimOp& op) const;
+    std::unique_ptr<PlacementRun> replay(Placement placement) const;
+    static void writeRunJson(std::ostream& out, const PlacementRun& run);
+};
+
+#endif // CO_SIMULATION_H
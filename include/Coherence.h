@@ -0,0 +1,145 @@
+#ifndef COHERENCE_H
+#define COHERENCE_H
+
+#include "Cache.h"
+#include "SampleWriter.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// N private caches kept coherent over an optional shared level. Each core's
+// cache is an ordinary CacheBase for lookup and replacement; the coherence
+// state of every block lives in one table, keyed by block address, that
+// records which cores hold it and which core owns it. That table is the
+// directory in directory mode; in snooping mode it only stands in for the
+// state bits the caches would hold, and traffic is counted as bus broadcasts.
+
+enum CoherenceProtocol {
+    MESI,
+    MOESI   // a modified line is shared without writing it back (Owned)
+};
+
+enum Interconnect {
+    SNOOPING_BUS,  // every request is broadcast and snooped by all other caches
+    DIRECTORY      // requests go to the home node, which messages only the holders
+};
+
+enum LineState : uint8_t {
+    STATE_I,
+    STATE_S,
+    STATE_E,
+    STATE_O,
+    STATE_M
+};
+
+const char* lineStateName(LineState state);
+
+// Everything known about one block, across all cores
+struct CoherenceEntry {
+    uint64_t sharers = 0;        // cores holding a valid copy
+    int owner = -1;              // core in E, O or M; -1 when none
+    LineState owner_state = STATE_I;
+    uint64_t seen = 0;           // cores that have ever cached the block
+    uint64_t lost = 0;           // cores whose copy was invalidated and not refetched
+    std::vector<uint64_t> written;  // per core: words written by others since it lost the block
+
+    // Per-block event counts, for finding hot lines
+    size_t invalidations = 0;
+    size_t upgrades = 0;
+    size_t true_sharing = 0;
+    size_t false_sharing = 0;
+    uint64_t readers = 0;        // cores that have read the block
+    uint64_t writers = 0;        // cores that have written the block
+    uint64_t words_written = 0;  // words any core has written
+};
+
+struct CoreStats {
+    size_t reads;
+    size_t writes;
+    size_t hits;
+    size_t cold_misses;          // first reference to the block by this core
+    size_t replacement_misses;   // evicted by this core's own capacity or conflicts
+    size_t true_sharing_misses;  // invalidated, and the word was written by another core
+    size_t false_sharing_misses; // invalidated by writes to other words of the line
+    size_t upgrades;             // write to an S or O copy
+    size_t invalidations;        // copies this core lost to other cores' writes
+    size_t writebacks;
+};
+
+class CoherenceSimulator {
+public:
+    // Up to 64 cores, each with a private cache of the given geometry
+    CoherenceSimulator(size_t num_cores, size_t cache_size, size_t block_size,
+                       size_t associativity, ReplacementPolicy policy);
+
+    // Both reset the caches and statistics
+    void setProtocol(CoherenceProtocol protocol);
+    void setInterconnect(Interconnect interconnect);
+    // Shared level below the private caches; size 0 removes it
+    bool setSharedLevel(size_t size, size_t associativity);
+
+    // Returns true on a hit in the core's private cache
+    bool access(size_t core, size_t address, bool write);
+    // State of the block holding address in core's cache
+    LineState stateOf(size_t core, size_t address) const;
+    size_t getCores() const { return caches.size(); }
+
+    void reset();
+    void stats() const;
+    void writeStatsJson(std::ostream& out) const;
+
+    // Every `interval` accesses: misses and coherence misses per 1000
+    // accesses in the last interval, and bus transactions or messages
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+
+private:
+    // Lines listed by `stats`, ordered by false-sharing misses
+    static const size_t HOT_LINES = 10;
+
+    CoherenceProtocol protocol;
+    Interconnect interconnect;
+    size_t block_size;
+    size_t word_size;            // false-sharing granularity, at most 64 words per line
+
+    std::vector<std::unique_ptr<CacheBase>> caches;
+    std::unique_ptr<CacheBase> shared;
+    std::unordered_map<size_t, CoherenceEntry> blocks;
+    std::vector<CoreStats> cores;
+
+    size_t accesses;
+    size_t cache_transfers;      // misses served by another private cache
+    size_t memory_fetches;       // misses served by the shared level or memory
+    size_t writebacks;
+    // Snooping: bus transactions and the tag lookups they cause in other
+    // caches. Directory: point-to-point messages.
+    size_t bus_transactions;
+    size_t snoop_lookups;
+    size_t messages;
+
+    SampleWriter sampler;
+    size_t sample_accesses;
+    size_t sample_misses;
+    size_t sample_coherence;
+    size_t sample_traffic;
+
+    CoherenceEntry& entryFor(size_t block);
+    LineState stateIn(const CoherenceEntry& entry, size_t core) const;
+    void evict(size_t core, size_t block);
+    void invalidateOthers(size_t core, size_t address, CoherenceEntry& entry);
+    void fetch(size_t core, size_t address, CoherenceEntry& entry, bool write);
+    void classifyMiss(size_t core, size_t address, CoherenceEntry& entry);
+    // Traffic of one request that reaches `contacted` other caches
+    void countRequest(size_t contacted, bool needs_data, bool owner_supplies);
+    void countWriteback(size_t core);
+    size_t totalMisses() const;
+    size_t coherenceMisses() const;
+    size_t traffic() const { return interconnect == SNOOPING_BUS ? bus_transactions : messages; }
+    void takeSample();
+};
+
+#endif // COHERENCE_H
@@ -0,0 +1,75 @@
+#ifndef COMMAND_TOKENIZER_H
+#define COMMAND_TOKENIZER_H
+
+#include <string_view>
+#include <charconv>
+#include <system_error>
+#include <cstddef>
+
+// Splits a command line into words separated by spaces or tabs. Words are
+// views into the line, so the line must outlive them; nothing is copied or
+// allocated. Numbers are parsed with std::from_chars, which does not depend
+// on the locale.
+class CommandTokenizer {
+public:
+    explicit CommandTokenizer(std::string_view line) : rest(line) {}
+
+    // Next word, or an empty view at the end of the line
+    std::string_view next() {
+        size_t start = 0;
+        while (start < rest.size() && isSpace(rest[start])) start++;
+        size_t end = start;
+        while (end < rest.size() && !isSpace(rest[end])) end++;
+        std::string_view word = rest.substr(start, end - start);
+        rest.remove_prefix(end);
+        return word;
+    }
+
+    // Parse the next word as an integer in `base`; a 0x prefix always
+    // means hex. On a missing or malformed word, value is left unchanged
+    template <typename T>
+    bool next(T& value, int base = 10) {
+        return parse(next(), value, base);
+    }
+
+    bool next(double& value) {
+        return parse(next(), value);
+    }
+
+    // The whole word must be a number
+    template <typename T>
+    static bool parse(std::string_view word, T& value, int base = 10) {
+        if (word.size() > 2 && word[0] == '0' && (word[1] == 'x' || word[1] == 'X')) {
+            word.remove_prefix(2);
+            base = 16;
+        }
+        T parsed = 0;
+        const char* end = word.data() + word.size();
+        std::from_chars_result result = std::from_chars(word.data(), end, parsed, base);
+        if (word.empty() || result.ec != std::errc() || result.ptr != end) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    static bool parse(std::string_view word, double& value) {
+        double parsed = 0;
+        const char* end = word.data() + word.size();
+        std::from_chars_result result = std::from_chars(word.data(), end, parsed);
+        if (word.empty() || result.ec != std::errc() || result.ptr != end) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+private:
+    std::string_view rest;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+};
+
+#endif // COMMAND_TOKENIZER_H
@@ -0,0 +1,236 @@
+#ifndef FIXED_CACHE_H
+#define FIXED_CACHE_H
+
+#include "Cache.h"
+#include "ReplacementState.h"
+#include "Profile.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Ask the compiler to fully unroll the per-way loops
+#if defined(__GNUC__)
+#define CACHE_UNROLL _Pragma("GCC unroll 32")
+#else
+#define CACHE_UNROLL
+#endif
+
+// Cache specialized at compile time on associativity and policy. Requires a
+// power-of-two block size and set count so indexing is shift-and-mask. Hit
+// and miss behaviour is identical to the generic Cache with the same
+// parameters; only the simulator's own cost differs.
+template <size_t Ways, ReplacementPolicy Policy>
+class FixedCache : public CacheBase {
+    static_assert(Ways >= 1 && Ways <= 32, "valid bits are kept in a 32-bit mask");
+    static_assert(Policy == FIFO || Policy == LRU || Policy == TREE_PLRU,
+                  "no specialization for this policy");
+    static_assert(Policy != TREE_PLRU || (Ways & (Ways - 1)) == 0,
+                  "tree PLRU needs a power-of-two number of ways");
+
+    // Tree PLRU keeps its state in one word per set instead of stamps
+    static const size_t STAMPS = Policy == TREE_PLRU ? 0 : Ways;
+
+public:
+    FixedCache(const std::string& name, size_t cache_size, size_t block_size, bool announce = true)
+        : CacheBase(name, cache_size, block_size, Ways, Policy, announce),
+          block_shift(log2(block_size)), set_shift(log2(num_sets)),
+          set_mask(num_sets - 1), sets(num_sets), time_counter(0), epoch(0) {}
+
+    bool access(size_t address) override {
+        beginAccess();
+        time_counter++;
+
+        size_t block_number = address >> block_shift;
+        reuse.access(block_number);
+        Set& set = sets[block_number & set_mask];
+        size_t tag = block_number >> set_shift;
+        if (set.epoch != epoch) {
+            set = Set();
+            set.epoch = epoch;
+        }
+
+        CACHE_UNROLL
+        for (size_t i = 0; i < Ways; i++) {
+            if ((set.valid >> i & 1u) && set.tags[i] == tag) {
+                MEMSIM_PROBE(PROBE_CACHE_WAYS, i + 1);
+                hits++;
+                if constexpr (Policy == LRU) {
+                    set.stamps[i] = time_counter;
+                }
+                if constexpr (Policy == TREE_PLRU) {
+                    plruTouch(set.plru, i, Ways);
+                }
+                return true;
+            }
+        }
+
+        MEMSIM_PROBE(PROBE_CACHE_WAYS, Ways);
+        misses++;
+        size_t victim = findVictim(set);
+        last_evicted = (set.valid >> victim & 1u)
+            ? ((set.tags[victim] << set_shift | (block_number & set_mask)) << block_shift)
+            : SIZE_MAX;
+        set.valid |= 1u << victim;
+        set.tags[victim] = tag;
+        if constexpr (Policy == TREE_PLRU) {
+            plruTouch(set.plru, victim, Ways);
+        } else {
+            set.stamps[victim] = time_counter;
+        }
+        return false;
+    }
+
+    bool invalidate(size_t address) override {
+        size_t block_number = address >> block_shift;
+        Set& set = sets[block_number & set_mask];
+        size_t tag = block_number >> set_shift;
+        if (set.epoch != epoch) {
+            return false;
+        }
+        for (size_t i = 0; i < Ways; i++) {
+            if ((set.valid >> i & 1u) && set.tags[i] == tag) {
+                set.valid &= ~(1u << i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // O(1), as in Cache: a set from an older epoch is cleared on its next
+    // access. Only when the 16-bit epoch wraps are the sets cleared here.
+    void reset() override {
+        resetCounters();
+        time_counter = 0;
+        if (++epoch == 0) {
+            std::fill(sets.begin(), sets.end(), Set());
+        }
+    }
+
+    size_t metadataBytes() const override {
+        return sets.capacity() * sizeof(Set);
+    }
+
+protected:
+    // Lines are written as CacheLine records, like the generic Cache's.
+    // Stamps more than LINE_STAMP_KEEP accesses old clamp to the base.
+    void saveLines(SnapshotWriter& out) const override {
+        size_t base = time_counter > LINE_STAMP_KEEP ? time_counter - LINE_STAMP_KEEP : 0;
+        out.put(time_counter);
+        out.put(0);  // no DRRIP selector
+        out.put(0);  // no random state
+        out.put(base);
+        out.put(num_sets);
+        out.put(Ways);
+        // Stale sets are written as empty ones
+        const Set empty;
+        for (const Set& current : sets) {
+            out.put(current.epoch == epoch ? current.plru : 0);
+        }
+        std::vector<CacheLine> records(num_sets * Ways);
+        for (size_t s = 0; s < num_sets; s++) {
+            const Set& set = sets[s].epoch == epoch ? sets[s] : empty;
+            for (size_t i = 0; i < Ways; i++) {
+                size_t stamp = 0;
+                if constexpr (STAMPS > 0) stamp = set.stamps[i];
+                CacheLine& record = records[s * Ways + i];
+                record.valid = set.valid >> i & 1u;
+                record.tag = set.tags[i];
+                record.timestamp = stamp > base ? stamp - base : 0;
+            }
+        }
+        out.putRecords(records.data(), records.size());
+    }
+
+    bool loadLines(SnapshotReader& in) override {
+        const uint64_t* state = in.getArray(4);
+        if (!state || !checkGeometry(in, num_sets, Ways)) {
+            return false;
+        }
+        const uint64_t* bits = in.getArray(num_sets);
+        std::vector<CacheLine> records;
+        if (!bits || !in.getRecords(records)) {
+            return false;
+        }
+        if (records.size() != num_sets * Ways || state[3] > state[0]) {
+            in.fail("snapshot cache lines are inconsistent");
+            return false;
+        }
+
+        time_counter = state[0];
+        size_t base = state[3];
+        for (size_t s = 0; s < num_sets; s++) {
+            Set& set = sets[s];
+            set = Set();
+            set.epoch = epoch;
+            set.plru = bits[s];
+            for (size_t i = 0; i < Ways; i++) {
+                const CacheLine& record = records[s * Ways + i];
+                if (record.valid) set.valid |= 1u << i;
+                set.tags[i] = record.tag;
+                if constexpr (STAMPS > 0) set.stamps[i] = base + record.timestamp;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Set {
+        std::array<size_t, Ways> tags{};
+        std::array<size_t, STAMPS> stamps{};  // insertion (FIFO) or last use (LRU)
+        uint64_t plru = 0;                    // tree bits (TREE_PLRU)
+        uint32_t valid = 0;                   // bit i set when way i holds a line
+        uint16_t epoch = 0;                   // reset count when the set was last cleared
+    };
+
+    size_t block_shift;
+    size_t set_shift;
+    size_t set_mask;
+    std::vector<Set> sets;
+    size_t time_counter;
+    uint16_t epoch;                           // reset count, mod 2^16; sets of other epochs are stale
+
+    static size_t log2(size_t n) {
+        size_t shift = 0;
+        while ((size_t(1) << shift) < n) shift++;
+        return shift;
+    }
+
+    size_t findVictim(const Set& set) const {
+        // First, try to find an invalid line
+        CACHE_UNROLL
+        for (size_t i = 0; i < Ways; i++) {
+            if (!(set.valid >> i & 1u)) {
+                return i;
+            }
+        }
+
+        if constexpr (Policy == TREE_PLRU) {
+            return plruVictim(set.plru, Ways);
+        } else {
+            // Oldest stamp is the FIFO or LRU victim
+            size_t victim = 0;
+            CACHE_UNROLL
+            for (size_t i = 1; i < Ways; i++) {
+                if (set.stamps[i] < set.stamps[victim]) {
+                    victim = i;
+                }
+            }
+            return victim;
+        }
+    }
+};
+
+// Picks a FixedCache specialization when the geometry and policy have one
+// (1/2/4/8/16 ways with FIFO, LRU or tree PLRU, power-of-two block size and
+// set count), otherwise the generic Cache. announce = false skips the
+// "initialized" line, for caches built behind the scenes.
+std::unique_ptr<CacheBase> makeCache(const std::string& name, size_t cache_size,
+                                     size_t block_size, size_t associativity,
+                                     ReplacementPolicy policy, bool announce = true);
+
+// Rebuild a cache saved with CacheBase::save; nullptr if the file is rejected
+std::unique_ptr<CacheBase> loadCache(const std::string& path);
+
+#endif // FIXED_CACHE_H
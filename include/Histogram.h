@@ -0,0 +1,78 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Log-bucketed histogram in the style of HdrHistogram. Values below 16 get
+// their own bucket; above that every power of two is split into 16 linear
+// sub-buckets, so any recorded value is reported within 1/16 (6.25%) of its
+// true value. Memory is a fixed array of counters no matter how many values
+// are recorded, so it can stay enabled on arbitrarily long traces.
+class Histogram {
+public:
+    static const unsigned SUB_BUCKET_BITS = 4;
+    static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static const size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    Histogram();
+
+    void record(uint64_t value) {
+        counts[bucketIndex(value)]++;
+        count++;
+        sum += value;
+        if (value < min_value) min_value = value;
+        if (value > max_value) max_value = value;
+    }
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMin() const { return count > 0 ? min_value : 0; }
+    uint64_t getMax() const { return max_value; }
+    double getMean() const { return count > 0 ? (double)sum / count : 0.0; }
+
+    // Smallest bucket bound with at least fraction q of the values at or
+    // below it, clamped to the observed min and max. q is in [0, 1].
+    uint64_t percentile(double q) const;
+
+    // "<label>: count N, min .., p50 .., p99 .., p99.9 .., max .. <unit>"
+    void print(const std::string& label, const std::string& unit) const;
+
+    // {"count": N, "min": .., "mean": .., "p50": .., "p99": .., "p999": ..,
+    //  "max": .., "buckets": [[upper_bound, count], ...]} with empty buckets left out
+    void writeJson(std::ostream& out) const;
+
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+
+private:
+    std::array<uint64_t, NUM_BUCKETS> counts;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min_value;
+    uint64_t max_value;
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+#if defined(__GNUC__)
+        unsigned msb = 63 - __builtin_clzll(value);
+#else
+        unsigned msb = 0;
+        while (value >> (msb + 1)) msb++;
+#endif
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        size_t sub = (value >> shift) & (SUB_BUCKETS - 1);
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+    static uint64_t bucketUpperBound(size_t index);
+};
+
+#endif // HISTOGRAM_H
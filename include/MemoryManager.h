@@ -1,46 +1,124 @@
-#ifndef MEMORY_MANAGER_H
-#define MEMORY_MANAGER_H
-
-#include "Block.h"
-#include <vector>
-#include <string>
-
-enum AllocStrategy {
-    FIRST_FIT,
-    BEST_FIT,
-    WORST_FIT
-};
-
-class MemoryManager {
-public:
-    MemoryManager();
-    
-    void init(size_t total_size);
-    int malloc(size_t nbytes);
-    void free(int block_id);
-    void dump() const;
-    void stats() const;
-    void setStrategy(AllocStrategy strategy);
-    
-private:
-    std::vector<Block> blocks;
-    size_t total_memory;
-    size_t used_memory;
-    int next_id;
-    AllocStrategy current_strategy;
-    
-    // Statistics
-    size_t internal_frag;
-    size_t total_alloc_requests;
-    size_t failed_requests;
-    
-    // Helper methods
-    int firstFit(size_t size);
-    int bestFit(size_t size);
-    int worstFit(size_t size);
-    void coalesce(size_t index);
-    size_t calculateExternalFragmentation() const;
-    size_t getLargestFreeBlock() const;
-};
-
+#ifndef MEMORY_MANAGER_H
+#define MEMORY_MANAGER_H
+
+#include "Block.h"
+#include "Histogram.h"
+#include "SampleWriter.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+enum AllocStrategy {
+    FIRST_FIT,
+    BEST_FIT,
+    WORST_FIT,
+    NEXT_FIT
+};
+
+// One used block moved by compaction
+struct Relocation {
+    int id;
+    size_t old_address;
+    size_t new_address;
+    size_t size;
+};
+
+struct CompactionResult {
+    std::vector<Relocation> relocations;
+    size_t bytes_moved;
+    bool complete;  // false if the byte budget left a block in place
+};
+
+class MemoryManager {
+public:
+    MemoryManager();
+    
+    void init(size_t total_size);
+    int malloc(size_t nbytes);
+    void free(int block_id);
+    void dump() const;
+    void stats() const;
+    void writeStatsJson(std::ostream& out) const;
+    void setStrategy(AllocStrategy strategy);
+    void setVerbose(bool on) { verbose = on; }
+    
+    // Write utilization, external fragmentation and the largest free block
+    // to a CSV or JSONL file every `interval` malloc/free calls
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+    
+    // Binary snapshot of the block list, counters and histograms
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    
+    // Slide used blocks towards address 0, moving at most max_bytes
+    CompactionResult compact(size_t max_bytes = SIZE_MAX);
+    
+    // Lookup of an allocated block, SIZE_MAX if the id is not in use
+    size_t getBlockAddress(int block_id) const;
+    size_t getBlockSize(int block_id) const;
+    size_t getTotalMemory() const { return total_memory; }
+    size_t getUsedMemory() const { return used_memory; }
+    // Constant time, from the free-size index
+    size_t calculateExternalFragmentation() const;
+    size_t getLargestFreeBlock() const;
+    size_t getFreeBlockCount() const { return free_sizes.size(); }
+    size_t getFreeMemory() const { return free_bytes; }
+    size_t getGranule() const { return size_t(1) << granule_shift; }
+    // Block list, allocation times and free index, from their element counts
+    size_t metadataBytes() const;
+    
+private:
+    std::vector<Block> blocks;
+    // One entry per live block. Ids are handed out in increasing order, so
+    // appending keeps the table sorted by id.
+    std::vector<AllocTime> alloc_times;
+    // Blocks count in granules of 2^granule_shift bytes, so 32-bit offsets
+    // reach any memory size; below 4 GiB a granule is one byte
+    unsigned granule_shift;
+    size_t total_memory;
+    size_t used_memory;
+    int next_id;
+    AllocStrategy current_strategy;
+    bool verbose;            // print per-operation messages
+    
+    // Statistics
+    size_t internal_frag;
+    size_t total_alloc_requests;
+    size_t failed_requests;
+    size_t search_steps;     // blocks examined across all allocation searches
+    size_t compaction_bytes; // bytes moved by compaction since init
+    size_t op_clock;         // malloc and free calls since init, the lifetime clock
+    size_t epoch_base;       // op_clock value that AllocTime::time counts from
+    Histogram size_hist;     // requested allocation sizes
+    Histogram lifetime_hist; // operations between malloc and free of a block
+    
+    // Next fit rover: address, in granules, where the next search starts
+    size_t rover;
+    
+    // Sizes and addresses of all free blocks, kept in step with every split,
+    // coalesce and compaction so free statistics and next fit never walk
+    // the block list
+    std::vector<uint32_t> free_sizes;  // in granules, ascending
+    std::vector<uint32_t> free_list;   // addresses in granules, ascending
+    size_t free_bytes;
+    
+    SampleWriter sampler;
+    
+    // Helper methods
+    int firstFit(size_t size);
+    int bestFit(size_t size);
+    int worstFit(size_t size);
+    int nextFit(size_t size);
+    size_t toBytes(size_t granules) const { return granules << granule_shift; }
+    void rebaseEpoch();
+    size_t blockIndex(size_t address) const;
+    void coalesce(size_t index);
+    void addFreeBlock(const Block& block);
+    void removeFreeBlock(const Block& block);
+    void beginOperation();
+    void takeSample();
+};
+
 #endif // MEMORY_MANAGER_H
\ No newline at end of file
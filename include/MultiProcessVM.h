@@ -0,0 +1,123 @@
+#ifndef MULTI_PROCESS_VM_H
+#define MULTI_PROCESS_VM_H
+
+#include "VirtualMemory.h"
+#include "SampleWriter.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <utility>
+#include <ostream>
+
+// Several address spaces sharing one pool of physical frames. Every virtual
+// page is backed by a content id; fork copies the ids, so parent and child
+// share each page until one of them writes it (copy-on-write). A resident
+// frame holds one content id and may be mapped by many (asid, page) pairs.
+
+enum ReplacementScope {
+    SCOPE_GLOBAL,  // victim chosen among all frames
+    SCOPE_LOCAL    // victim chosen among the faulting process's own frames
+};
+
+struct ProcessPageEntry {
+    bool valid;
+    int frame;
+    size_t backing;  // content id, shared between pages until a COW write
+
+    ProcessPageEntry() : valid(false), frame(-1), backing(0) {}
+};
+
+struct Process {
+    int asid;
+    bool alive;
+    std::vector<ProcessPageEntry> page_table;
+    size_t resident;          // frames charged to this process
+    size_t accesses;
+    size_t major_faults;      // page loaded from backing store
+    size_t minor_faults;      // page already resident for another process
+    size_t cow_copies;
+    size_t window_accesses;   // accesses in the current thrashing window
+    size_t window_faults;
+    size_t thrashing_windows;
+    bool thrashing;
+};
+
+struct FrameEntry {
+    bool used;
+    size_t backing;
+    int owner;                // ASID charged for the frame
+    size_t loaded_at;         // access number, for FIFO
+    size_t last_use;          // access number, for LRU
+    std::vector<std::pair<int, size_t>> mappings;  // (asid, page) pairs
+};
+
+class MultiProcessVM {
+public:
+    MultiProcessVM(size_t page_size, size_t num_frames);
+
+    // Returns the new ASID, or -1 on error
+    int createProcess(size_t num_pages);
+    // Child shares every page of the parent copy-on-write
+    int forkProcess(int parent_asid);
+    bool exitProcess(int asid);
+
+    size_t translate(int asid, size_t virtual_address, bool write);
+    void setPolicy(PageReplacementPolicy policy);
+    void setScope(ReplacementScope scope);
+    // A window of `window` accesses counts as thrashing when at least
+    // fault_pct percent of its accesses fault
+    void setThrashing(size_t window, double fault_pct);
+    void setVerbose(bool on) { verbose = on; }
+    void reset();
+    void stats() const;
+    void writeStatsJson(std::ostream& out) const;
+
+    // Every `interval` accesses: fault rate of the last interval, frames in
+    // use, live processes and whether the last window was thrashing
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+
+private:
+    size_t page_size;
+    size_t num_frames;
+    PageReplacementPolicy policy;
+    ReplacementScope scope;
+    bool verbose;  // print fault, eviction and thrashing messages
+
+    std::vector<Process> processes;     // indexed by ASID - 1
+    std::vector<FrameEntry> frames;
+    size_t frames_used;
+    std::vector<int> backing_refs;      // page table entries per content id
+    std::vector<int> backing_frame;     // frame holding a content id, -1 if none
+
+    size_t access_counter;
+    size_t total_faults;
+    size_t cow_copies;
+
+    size_t thrash_window;
+    double thrash_fault_pct;
+    size_t window_accesses;
+    size_t window_faults;
+    size_t thrashing_windows;
+    size_t windows_evaluated;
+    bool system_thrashing;
+
+    SampleWriter sampler;
+    size_t sample_accesses;             // accesses at the previous sample
+    size_t sample_faults;               // faults at the previous sample
+
+    // Helper methods
+    Process* findProcess(int asid);
+    size_t newBacking();
+    size_t liveProcesses() const;
+    int allocateFrame(Process& process);
+    int selectVictim(int owner) const;
+    void evictFrame(int frame);
+    void unmap(int frame, int asid, size_t page);
+    void loadPage(Process& process, size_t page);
+    void copyOnWrite(Process& process, size_t page);
+    void endThrashingWindow();
+    void takeSample();
+};
+
+#endif // MULTI_PROCESS_VM_H
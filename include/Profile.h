@@ -0,0 +1,63 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "Histogram.h"
+#include <cstdint>
+#include <string>
+
+// Probes on the simulator's own hot paths, for finding where its cycles go.
+// They are compiled in only with `make PROFILE=1` (-DMEMSIM_PROFILE);
+// otherwise MEMSIM_PROBE and MEMSIM_PHASE expand to nothing and the hot
+// paths are the same code as before.
+
+enum ProbeId {
+    PROBE_MALLOC_SEARCH,    // blocks examined per malloc
+    PROBE_COALESCE_MERGES,  // neighbours merged per free
+    PROBE_BUDDY_SPLITS,     // halvings per buddy allocation
+    PROBE_BUDDY_MERGES,     // buddy merges per free
+    PROBE_CACHE_WAYS,       // ways compared per cache lookup
+    PROBE_PAGE_WALK,        // page-table entries read per translation
+    PROBE_VICTIM_SCAN,      // entries examined to choose a page to evict
+    NUM_PROBES
+};
+
+// True in a PROFILE=1 build
+bool profileCompiled();
+// Probe histograms, then wall time and hardware counters per phase
+void profileReport();
+void profileReset();
+
+#ifdef MEMSIM_PROFILE
+
+extern Histogram probe_histograms[NUM_PROBES];
+
+inline void profileRecord(ProbeId probe, uint64_t value) {
+    probe_histograms[probe].record(value);
+}
+
+// Measures the enclosing scope: wall time and, on Linux when the kernel
+// allows it, cycles, instructions, cache misses and branch mispredictions.
+// Phases with the same name accumulate; phases may nest.
+class ProfilePhase {
+public:
+    explicit ProfilePhase(const std::string& name);
+    ~ProfilePhase();
+    ProfilePhase(const ProfilePhase&) = delete;
+    ProfilePhase& operator=(const ProfilePhase&) = delete;
+
+private:
+    size_t index;
+    uint64_t start[5];  // wall ns, then the four counters
+};
+
+#define MEMSIM_PROBE(probe, value) profileRecord(probe, value)
+#define MEMSIM_PHASE(name) ProfilePhase memsim_phase_(name)
+
+#else
+
+#define MEMSIM_PROBE(probe, value) ((void)0)
+#define MEMSIM_PHASE(name) ((void)0)
+
+#endif // MEMSIM_PROFILE
+
+#endif // PROFILE_H
@@ -0,0 +1,94 @@
+#ifndef REPLACEMENT_STATE_H
+#define REPLACEMENT_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-set replacement metadata packed into one 64-bit word, shared by the
+// generic and the specialized caches.
+
+inline size_t countTrailingZeros(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    size_t n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// --- Tree pseudo-LRU ---------------------------------------------------
+// A binary tree over the ways (power of two, at most 64). Node 1 is the
+// root and node n has children 2n and 2n+1; bit n of the word says which
+// child holds the pseudo-LRU line (0 = left, 1 = right).
+
+inline size_t plruVictim(uint64_t bits, size_t ways) {
+    size_t node = 1;
+    while (node < ways) {
+        node = 2 * node + ((bits >> node) & 1);
+    }
+    return node - ways;
+}
+
+// Point every node on the way's path away from it: O(log ways)
+inline void plruTouch(uint64_t& bits, size_t way, size_t ways) {
+    size_t node = way + ways;
+    while (node > 1) {
+        size_t parent = node / 2;
+        if (node & 1) {
+            bits &= ~(uint64_t(1) << parent);  // used the right child, victim goes left
+        } else {
+            bits |= uint64_t(1) << parent;
+        }
+        node = parent;
+    }
+}
+
+// --- RRIP --------------------------------------------------------------
+// A 2-bit re-reference prediction value per way (at most 32 ways):
+// 0 = near-immediate re-use, 3 = distant. Word-parallel bit tricks make
+// victim selection and aging constant time.
+
+const unsigned RRPV_MAX = 3;
+const unsigned RRPV_LONG = 2;
+const uint64_t RRPV_LOW_BITS = 0x5555555555555555ULL;
+
+inline uint64_t rrpvLowBits(size_t ways) {
+    return ways >= 32 ? RRPV_LOW_BITS : RRPV_LOW_BITS & ((uint64_t(1) << (2 * ways)) - 1);
+}
+
+inline void rrpvSet(uint64_t& bits, size_t way, unsigned value) {
+    bits = (bits & ~(uint64_t(3) << (2 * way))) | (uint64_t(value) << (2 * way));
+}
+
+// First way predicted distant; if there is none, every way is aged by the
+// amount that brings the oldest to RRPV_MAX
+inline size_t rripVictim(uint64_t& bits, size_t ways) {
+    uint64_t low = rrpvLowBits(ways);
+    uint64_t hi = (bits >> 1) & low;
+    uint64_t lo = bits & low;
+    uint64_t distant = hi & lo;
+
+    if (!distant) {
+        unsigned oldest = hi ? 2 : (lo ? 1 : 0);
+        bits += (RRPV_MAX - oldest) * low;
+        hi = (bits >> 1) & low;
+        lo = bits & low;
+        distant = hi & lo;
+    }
+    return countTrailingZeros(distant) / 2;
+}
+
+// --- Random ------------------------------------------------------------
+
+inline uint64_t xorshift64(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+#endif // REPLACEMENT_STATE_H
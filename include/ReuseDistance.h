@@ -0,0 +1,119 @@
+#ifndef REUSE_DISTANCE_H
+#define REUSE_DISTANCE_H
+
+#include "Histogram.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Sampled reuse (stack) distance in the style of SHARDS: the number of
+// distinct blocks touched between two accesses to the same block, so a
+// fully associative LRU cache of C blocks hits exactly the reuses with
+// distance below C. Blocks are sampled by a hash of their number and a
+// sampled block is seen on every access, hit or miss.
+//
+// At most MAX_TRACKED blocks are kept. When one more is sampled, the hash
+// threshold drops to the largest tracked hash and that block is dropped,
+// so memory is fixed and the sampling rate adapts to the footprint.
+// Distances are counted among sampled blocks and scaled by the rate.
+class ReuseDistance {
+public:
+    static const size_t MAX_TRACKED = 2048;
+
+    ReuseDistance();
+
+    // One access to block number `block`
+    void access(uint64_t block) {
+        uint64_t h = hash(block);
+        if (h < threshold) {
+            sampledAccess(block, h);
+        }
+    }
+    // Tracked blocks are dropped by moving to a new generation; only the
+    // 1 KB of position bits are cleared
+    void reset();
+
+    const Histogram& distances() const { return hist; }
+    // Sampled accesses to a block for the first time
+    uint64_t getFirstTouches() const { return first_touches; }
+    // Fraction of blocks sampled; 1 until the table first overflows
+    double samplingRate() const { return 1.0 / scale; }
+
+    // "<label>: count N, min .., p50 .., p99 .., p99.9 .., max .. blocks"
+    // followed by the sampling rate and first touches
+    void print(const std::string& label) const;
+    // {"sampling_rate": .., "first_touches": .., "distance": <histogram>}
+    void writeJson(std::ostream& out) const;
+
+    // Threshold, counters, histogram, then the tracked blocks oldest first
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+
+private:
+    // Open-addressed table of twice MAX_TRACKED slots, and last-access
+    // positions up to four times MAX_TRACKED before they are renumbered
+    static const size_t TABLE_SIZE = 2 * MAX_TRACKED;
+    static const size_t POSITIONS = 4 * MAX_TRACKED;
+    static const size_t GROUP_BITS = 9;  // positions counted together, 512
+
+    // A slot of another generation is empty; generation 0 is never
+    // current, so zeroed slots are empty too
+    struct Slot {
+        uint64_t block;
+        uint32_t position;    // position of the block's last access
+        uint16_t generation;
+    };
+
+    uint64_t threshold;       // blocks whose hash is below this are sampled
+    double scale;             // 1 / sampling rate
+    std::vector<Slot> slots;  // allocated on the first sampled access
+    // Bit set at the last-access position of each tracked block, with a
+    // count per group of positions so counting skips whole groups
+    std::vector<uint64_t> last_bits;
+    std::vector<uint16_t> group_counts;
+    std::vector<uint16_t> owner;  // slot of the block last accessed at each position
+    std::vector<std::pair<uint64_t, uint64_t>> by_hash;  // max-heap of (hash, block)
+    size_t tracked;
+    uint32_t next_position;
+    uint16_t generation;
+    Histogram hist;
+    uint64_t first_touches;
+
+    static uint64_t hash(uint64_t block) {
+        // splitmix64 finalizer
+        block += 0x9E3779B97F4A7C15ULL;
+        block = (block ^ (block >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        block = (block ^ (block >> 27)) * 0x94D049BB133111EBULL;
+        return block ^ (block >> 31);
+    }
+
+    void allocate();
+    void sampledAccess(uint64_t block, uint64_t h);
+    bool live(size_t slot) const { return slots[slot].generation == generation; }
+    // Slot holding block, or the empty slot where it would go
+    size_t findSlot(uint64_t block, uint64_t h) const;
+    void eraseSlot(size_t slot);
+    void track(size_t slot, uint64_t block, uint64_t h);
+    void dropLargestHash();
+    void renumber();
+
+    void setLast(uint32_t position, uint16_t slot) {
+        last_bits[position >> 6] |= uint64_t(1) << (position & 63);
+        group_counts[position >> GROUP_BITS]++;
+        owner[position] = slot;
+    }
+    void clearLast(uint32_t position) {
+        last_bits[position >> 6] &= ~(uint64_t(1) << (position & 63));
+        group_counts[position >> GROUP_BITS]--;
+    }
+    // Tracked blocks last accessed after `position`
+    size_t countAfter(uint32_t position) const;
+};
+
+#endif // REUSE_DISTANCE_H
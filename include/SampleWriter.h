@@ -0,0 +1,59 @@
+#ifndef SAMPLE_WRITER_H
+#define SAMPLE_WRITER_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Buffered writer for periodic samples taken every `interval` operations.
+// A path ending in ".csv" gets a header line and comma-separated rows;
+// anything else gets one JSON object per line (JSONL). Rows are formatted
+// into an in-memory buffer and only reach the file once it holds
+// FLUSH_BYTES, so sampling costs no system call on the operation that
+// triggers it, and operations between samples pay a single countdown.
+// tick() runs at the start of each operation, so a sample is written
+// just after every interval-th operation completes.
+class SampleWriter {
+public:
+    static const size_t FLUSH_BYTES = 64 * 1024;
+
+    SampleWriter();
+    ~SampleWriter();
+
+    bool open(const std::string& path, const std::vector<std::string>& columns,
+              size_t interval);
+    // One value per column, in the order given to open()
+    void write(const double* values);
+    void close();
+
+    // Called once per operation; true when a sample is due
+    bool tick() {
+        if (interval == 0) return false;
+        if (countdown > 0) {
+            countdown--;
+            return false;
+        }
+        countdown = interval - 1;
+        return true;
+    }
+
+    bool isOpen() const { return file.is_open(); }
+    size_t getInterval() const { return interval; }
+    size_t getRows() const { return rows; }
+    const std::string& getPath() const { return path; }
+
+private:
+    std::ofstream file;
+    std::string path;
+    std::vector<std::string> columns;
+    std::string buffer;
+    bool csv;
+    size_t rows;
+    size_t interval;   // operations per sample, 0 when closed
+    size_t countdown;  // operations left before the next sample
+
+    void flush();
+};
+
+#endif // SAMPLE_WRITER_H
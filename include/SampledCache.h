@@ -0,0 +1,79 @@
+#ifndef SAMPLED_CACHE_H
+#define SAMPLED_CACHE_H
+
+#include "Cache.h"
+#include <memory>
+#include <vector>
+
+// Runs a cache on a sample of its trace and extrapolates the miss ratio.
+//
+// Set sampling simulates only the accesses that map to 1 in K sets, chosen
+// by a hash of the set index. Time sampling repeats a period of P accesses:
+// the first W are simulated to warm the cache up, the next M are simulated
+// and measured, and the rest are skipped. Both can be on at once.
+//
+// The miss ratio is a ratio estimate over sampling units: sampled sets, or
+// measurement intervals when time sampling is on. Its 95% confidence interval
+// comes from the spread between units.
+class SampledCache : public CacheBase {
+public:
+    explicit SampledCache(std::unique_ptr<CacheBase> inner);
+
+    // 1 in `ratio` sets; 1 simulates every set
+    void setSetSampling(size_t ratio);
+    // period 0 turns time sampling off
+    void setTimeSampling(size_t period, size_t warmup, size_t measure);
+    // The wrapped cache, reset, for `set sampling off`
+    std::unique_ptr<CacheBase> release();
+
+    bool access(size_t address) override;
+    void reset() override;
+    bool invalidate(size_t address) override { return inner->invalidate(address); }
+    size_t lastEvicted() const override { return inner->lastEvicted(); }
+    bool lastAccessSimulated() const override { return simulated; }
+    size_t metadataBytes() const override;
+    void stats() const override;
+    void writeStatsJson(std::ostream& out) const override;
+    bool save(const std::string& path) const override;
+
+    // Estimated miss ratio and the half-width of its 95% confidence
+    // interval, both as fractions; the half-width is -1 with under 2 units
+    double missRatio() const;
+    double missRatioHalfWidth() const;
+    size_t getSimulated() const { return simulated_accesses; }
+
+protected:
+    void saveLines(SnapshotWriter&) const override {}
+    bool loadLines(SnapshotReader&) override { return false; }
+
+private:
+    std::unique_ptr<CacheBase> inner;
+    bool simulated;                 // whether the last access reached the inner cache
+
+    size_t set_ratio;
+    std::vector<bool> sampled_set;
+    size_t sampled_sets;
+
+    size_t period;
+    size_t warmup;
+    size_t measure;
+    size_t phase;                   // position of the next access in its period
+
+    size_t total_accesses;
+    size_t simulated_accesses;
+
+    // Per-set measured counts, used as units without time sampling
+    std::vector<uint64_t> set_accesses;
+    std::vector<uint64_t> set_misses;
+
+    // Sums over closed measurement intervals, used as units with time sampling
+    size_t interval_accesses;
+    size_t interval_misses;
+    size_t intervals;
+    double sum_a, sum_m, sum_aa, sum_mm, sum_am;
+
+    void clear();
+    void closeInterval();
+};
+
+#endif // SAMPLED_CACHE_H
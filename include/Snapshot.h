@@ -0,0 +1,133 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary snapshot files for save/load. Fields are 64-bit words in host byte
+// order; tables of blocks, lines and page-table entries are packed records
+// laid out as the structs are in memory, padded to a whole word, so every
+// field and array is 8-byte aligned and a mapped file can be read in place:
+//
+//   word 0  magic "MEMSIMSN"
+//   word 1  format version
+//   word 2  SnapshotKind
+//   word 3  byte-order mark, 0x0102030405060708 as written
+//   ...     payload defined by each class's save()
+//
+// A snapshot is only loaded back by the same version and on a host with
+// the same byte order and record sizes; anything else is rejected rather
+// than converted.
+
+const uint64_t SNAPSHOT_MAGIC = 0x4E534D49534D454DULL;  // "MEMSIMSN" little-endian
+const uint64_t SNAPSHOT_VERSION = 8;
+const uint64_t SNAPSHOT_BYTE_ORDER = 0x0102030405060708ULL;
+
+enum SnapshotKind {
+    SNAPSHOT_MEMORY_MANAGER = 1,
+    SNAPSHOT_BUDDY_ALLOCATOR = 2,
+    SNAPSHOT_CACHE = 3,
+    SNAPSHOT_VIRTUAL_MEMORY = 4
+};
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(const std::string& path, SnapshotKind kind);
+
+    void put(uint64_t value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void putArray(const uint64_t* values, size_t count) {
+        out.write(reinterpret_cast<const char*>(values), count * sizeof(uint64_t));
+    }
+    // Doubles are stored as their bit pattern
+    void putDouble(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(bits);
+    }
+    // Length word, then the bytes padded with zeros to a whole word
+    void putString(const std::string& s);
+    // Record count and size, then the records byte for byte, padded with
+    // zeros to a whole word
+    template <typename T>
+    void putRecords(const T* records, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "records are copied as bytes");
+        put(count);
+        put(sizeof(T));
+        out.write(reinterpret_cast<const char*>(records), count * sizeof(T));
+        putPadding(count * sizeof(T));
+    }
+
+    // False if the file could not be created or a write failed
+    bool ok() const { return static_cast<bool>(out); }
+
+private:
+    std::ofstream out;
+
+    void putPadding(size_t bytes);
+};
+
+// Maps the whole file read-only (POSIX) or reads it into memory, checks
+// the header and hands out words and arrays from the mapping in order.
+class SnapshotReader {
+public:
+    SnapshotReader(const std::string& path, SnapshotKind kind);
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool get(uint64_t& value);
+    // Pointer into the mapping, valid while the reader lives; nullptr if
+    // the file is too short
+    const uint64_t* getArray(size_t count);
+    // `count` records of `width` words each, rejecting counts that overflow
+    const uint64_t* getRecords(uint64_t count, size_t width);
+    // Records written by putRecords, copied into `records`; false if the
+    // file is truncated or its records have a different size
+    template <typename T>
+    bool getRecords(std::vector<T>& records) {
+        static_assert(std::is_trivially_copyable<T>::value, "records are copied as bytes");
+        uint64_t count = 0, size = 0;
+        if (!get(count) || !get(size) || !checkRecords(count, size, sizeof(T))) {
+            return false;
+        }
+        const uint64_t* p = getArray((count * sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        if (!p) {
+            return false;
+        }
+        records.resize(count);
+        if (count > 0) {
+            std::memcpy(static_cast<void*>(records.data()), p, count * sizeof(T));
+        }
+        return true;
+    }
+    bool getString(std::string& s);
+    static double toDouble(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // False after any failed read; error() says why the file was rejected
+    bool ok() const { return error_message.empty(); }
+    const std::string& error() const { return error_message; }
+    // Rejects the file for a reason found by the caller; the first reason sticks
+    void fail(const std::string& message);
+
+private:
+    const uint64_t* words;
+    size_t num_words;
+    size_t position;
+    void* mapping;               // mmap'd region, if the file was mapped
+    size_t mapping_bytes;
+    std::vector<uint64_t> copy;  // file contents when it could not be mapped
+    std::string error_message;
+
+    bool checkRecords(uint64_t count, uint64_t size, size_t expected);
+};
+
+#endif // SNAPSHOT_H
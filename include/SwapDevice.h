@@ -0,0 +1,66 @@
+#ifndef SWAP_DEVICE_H
+#define SWAP_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Timing model of a local swap device. Requests are served one at a time in
+// arrival order; each takes latency + bytes / bandwidth. Reads are
+// synchronous: the caller waits for completion, including any writes queued
+// ahead of it. Writes and prefetch reads are asynchronous and only stall the
+// caller when queue_depth requests are already outstanding. All times are in
+// nanoseconds of simulated time.
+class SwapDevice {
+public:
+    SwapDevice();
+
+    // bandwidth in bytes per nanosecond (1 MB/s = 0.001)
+    void configure(double latency_ns, double bandwidth, size_t queue_depth);
+    void reset();
+
+    // Completion time of a demand read issued at `now`
+    double read(double now, size_t bytes);
+    // Time the issuer can continue; the write completes in the background
+    double write(double now, size_t bytes);
+    // Completion time of a background read; `now` is advanced past any
+    // stall for a full queue
+    double prefetch(double& now, size_t bytes);
+
+    double getLatency() const { return latency; }
+    double getBandwidth() const { return bandwidth; }
+    size_t getQueueDepth() const { return queue_depth; }
+    size_t getReads() const { return reads; }
+    size_t getWrites() const { return writes; }
+    size_t getPrefetches() const { return prefetches; }
+    uint64_t getBytesRead() const { return bytes_read; }
+    uint64_t getBytesWritten() const { return bytes_written; }
+    double getBusyTime() const { return busy_time; }
+    double getQueueStall() const { return queue_stall; }
+
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+
+private:
+    double latency;
+    double bandwidth;
+    size_t queue_depth;
+
+    double busy_until;           // when the request at the tail of the queue finishes
+    std::deque<double> pending;  // completion times of outstanding async requests
+    size_t reads;
+    size_t writes;
+    size_t prefetches;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    double busy_time;
+    double queue_stall;          // time callers waited for a queue slot
+
+    double serve(double now, size_t bytes);
+    double waitForSlot(double now);
+};
+
+#endif // SWAP_DEVICE_H
@@ -1,51 +1,226 @@
-#ifndef VIRTUAL_MEMORY_H
-#define VIRTUAL_MEMORY_H
-
-#include <vector>
-#include <queue>
-#include <cstddef>
-
-struct PageTableEntry {
-    bool valid;
-    int frame;
-    size_t timestamp;  // For LRU
-    
-    PageTableEntry() : valid(false), frame(-1), timestamp(0) {}
-};
-
-enum PageReplacementPolicy {
-    PAGE_FIFO,
-    PAGE_LRU
-};
-
-class VirtualMemory {
-public:
-    VirtualMemory(size_t num_pages, size_t page_size, size_t num_frames,
-                  PageReplacementPolicy policy = PAGE_FIFO);
-    
-    size_t translate(size_t virtual_address);
-    void stats() const;
-    void reset();
-    void setPolicy(PageReplacementPolicy policy);
-    
-private:
-    size_t num_pages;
-    size_t page_size;
-    size_t num_frames;
-    PageReplacementPolicy policy;
-    
-    std::vector<PageTableEntry> page_table;
-    std::vector<bool> frame_used;
-    std::queue<int> fifo_queue;
-    size_t time_counter;
-    
-    size_t page_faults;
-    size_t page_hits;
-    
-    // Helper methods
-    int findFreeFrame();
-    int selectVictimPage();
-    bool handlePageFault(size_t page_num);
-};
-
+#ifndef VIRTUAL_MEMORY_H
+#define VIRTUAL_MEMORY_H
+
+#include "Histogram.h"
+#include "SampleWriter.h"
+#include "SwapDevice.h"
+#include <vector>
+#include <set>
+#include <deque>
+#include <unordered_map>
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <ostream>
+
+// A mapping covers 2^order base pages starting at an aligned head page and
+// is backed by as many contiguous frames. Every base page of a huge mapping
+// has its own entry with the mapping's order and its frame; replacement,
+// stamps and PFF state are kept on the head entry.
+// 12 bytes. The stamp is a 32-bit access number counted from access_base;
+// LRU evicts the mapping whose stamp is oldest. An entry written before
+// the latest reset has an older epoch and counts as unmapped.
+struct PageTableEntry {
+    uint8_t valid : 1;
+    uint8_t touched : 1;    // referenced since the mapping was loaded
+    uint8_t dirty : 1;      // written since the mapping was loaded
+    uint8_t order;          // log2 of the mapping size in base pages
+    uint16_t epoch;         // reset count, mod 2^16, when the entry was written
+    int32_t frame;
+    uint32_t last_used;     // access number of the latest load or reference
+    
+    PageTableEntry() : valid(0), touched(0), dirty(0), order(0), epoch(0), frame(-1),
+                       last_used(0) {}
+};
+
+static_assert(sizeof(PageTableEntry) == 12, "PageTableEntry should pack into 12 bytes");
+
+enum PageReplacementPolicy {
+    PAGE_FIFO,
+    PAGE_LRU
+};
+
+enum HugePagePolicy {
+    HUGE_NEVER,    // base pages only
+    HUGE_ALWAYS,   // map the largest free huge page on the first fault in a region
+    HUGE_PROMOTE   // collapse a region once enough of its base pages are resident
+};
+
+class VirtualMemory {
+public:
+    // Working-set windows longer than the stamps keep are not supported
+    static const size_t MAX_WS_WINDOW = size_t(1) << 31;
+    
+    VirtualMemory(size_t num_pages, size_t page_size, size_t num_frames,
+                  PageReplacementPolicy policy = PAGE_FIFO);
+    
+    // A write marks the page dirty; evicting a dirty page costs a writeback
+    size_t translate(size_t virtual_address, bool write = false);
+    void stats() const;
+    void writeStatsJson(std::ostream& out) const;
+    // Bytes held by the page table, frame map and working-set tracker
+    size_t metadataBytes() const;
+    // O(frames + working set): page-table entries are invalidated by moving
+    // to a new epoch, not cleared
+    void reset();
+    void setPolicy(PageReplacementPolicy policy);
+    void setVerbose(bool on) { verbose = on; }
+    size_t getPageHits() const { return page_hits; }
+    size_t getPageFaults() const { return page_faults; }
+    
+    // Working set W(t, delta): distinct pages referenced in the last delta
+    // accesses. Changing delta restarts the tracker.
+    void setWorkingSetWindow(size_t delta);
+    size_t getWorkingSetSize() const { return ws_size; }
+    
+    // Page-fault-frequency control. With a critical inter-fault interval
+    // T > 0, a fault less than T accesses after the previous one grows the
+    // resident set by a frame (up to num_frames, the memory budget); a later
+    // fault releases every page not referenced since the previous fault.
+    // T = 0 turns control off and restores the full budget.
+    void setPffThreshold(size_t threshold);
+    size_t getResidentLimit() const { return resident_limit; }
+    
+    // Huge page sizes as orders of the base page (9 and 18 give 2 MiB and
+    // 1 GiB over 4 KiB pages). Only changes while nothing is resident.
+    bool setPageSizes(const std::vector<unsigned>& orders);
+    // promote_pct: share of a region's base pages that must be resident
+    // before HUGE_PROMOTE collapses it
+    void setHugePagePolicy(HugePagePolicy policy, size_t promote_pct = 50);
+    
+    // Cost model: every access takes memory_time; a fault also waits for
+    // its read from the swap device, and dirty evictions queue writebacks.
+    // Prefetch reads the next `pages` pages in the background after a fault.
+    void setSwapDevice(double latency_us, double bandwidth_mbps, size_t queue_depth);
+    void setMemoryAccessTime(double ns);
+    void setPrefetch(size_t pages);
+    
+    // Write the hit ratio and fault count of the last `interval` accesses,
+    // and the overall hit ratio, to a CSV or JSONL file every `interval`
+    // translations
+    bool startSampling(const std::string& path, size_t interval);
+    void stopSampling();
+    
+    // Binary snapshot of the page table, FIFO order, working set, PFF state,
+    // counters and histograms. load() builds a new instance with the saved geometry;
+    // nullptr if the file is rejected.
+    bool save(const std::string& path) const;
+    static std::unique_ptr<VirtualMemory> load(const std::string& path);
+    
+private:
+    size_t num_pages;
+    size_t page_size;
+    size_t num_frames;
+    PageReplacementPolicy policy;
+    bool verbose;  // print page fault and eviction messages
+    
+    std::vector<PageTableEntry> page_table;
+    uint16_t epoch;                           // entries of other epochs are stale
+    std::vector<int> frame_page;              // page held by each frame, -1 if free
+    std::deque<int> fifo_queue;               // under FIFO, every resident mapping head, oldest first
+    size_t access_base;              // access number the stamps count from
+    
+    size_t page_faults;
+    size_t page_hits;
+    size_t last_fault_access;        // access number of the previous fault
+    Histogram fault_interval_hist;   // accesses between consecutive faults
+    
+    SampleWriter sampler;
+    size_t window_hits;              // page hits at the previous sample
+    size_t window_faults;            // page faults at the previous sample
+    
+    // Working set: the pages referenced in the last ws_window accesses, in
+    // a list ordered by their latest reference. A reference moves its page
+    // to the tail and pages whose reference left the window drop off the
+    // head, so each access is O(1) amortized. Node num_pages is the list
+    // head; a page outside the window has stamp 0.
+    struct WorkingSetNode {
+        uint32_t prev;
+        uint32_t next;
+        uint32_t last_reference;     // access stamp, from access_base
+    };
+    size_t ws_window;
+    std::vector<WorkingSetNode> ws_nodes;
+    size_t ws_size;                  // |W(t, delta)|
+    Histogram ws_hist;               // |W| after every access
+    
+    // Resident set and page-fault-frequency control
+    size_t pff_threshold;            // critical inter-fault interval, 0 = off
+    size_t resident_limit;           // frames the process may hold
+    size_t resident_count;           // frames holding a page
+    size_t resident_sum;             // resident_count summed over accesses
+    size_t pff_grows;
+    size_t pff_shrinks;
+    size_t pff_released;             // frames released by shrinks
+    
+    // Physical frames are handed out by a buddy allocator over frame
+    // numbers, so a 2^k-page mapping gets 2^k contiguous, aligned frames
+    std::vector<std::set<size_t>> free_blocks;  // free block heads per order
+    std::vector<int8_t> free_order;             // order of the free block at a frame, -1 if none
+    unsigned max_block_order;
+    
+    // Huge pages
+    std::vector<unsigned> huge_orders;          // ascending
+    HugePagePolicy huge_policy;
+    size_t promote_pct;
+    std::vector<std::vector<uint32_t>> region_resident;  // resident base pages per aligned region, per huge order
+    std::vector<size_t> huge_faults;            // faults mapped with each huge size
+    size_t promotions;
+    size_t demotions;
+    size_t demoted_freed;            // untouched base pages freed by demotion
+    size_t huge_fallbacks;           // huge faults that fell back to a base page
+    size_t bloat_evicted;            // untouched base pages of evicted huge mappings
+    
+    // Swap I/O cost model, in nanoseconds of simulated time
+    SwapDevice swap;
+    double memory_time;              // one memory access
+    double sim_time;                 // elapsed simulated time
+    double fault_service;            // time spent waiting in page faults
+    double window_time;              // sim_time at the previous sample
+    size_t writebacks;               // dirty pages written to swap on eviction
+    size_t clean_evictions;          // pages dropped without I/O
+    size_t prefetch_pages;
+    std::unordered_map<size_t, double> prefetched;  // page -> time its read completes
+    std::deque<std::pair<size_t, double>> prefetch_order;  // oldest prefetch first
+    static const size_t PREFETCH_BUFFER = 256;      // prefetched pages remembered
+    size_t prefetch_hits;
+    
+    // Helper methods
+    void initFramePool();
+    int allocFrames(unsigned order);
+    void freeFrames(size_t frame, unsigned order);
+    int obtainFrames(unsigned order);
+    void mapRegion(size_t head, unsigned order, size_t frame, size_t now);
+    void countResident(size_t head, unsigned order, int delta);
+    void promote(size_t page_num);
+    void reclaim(size_t head);
+    size_t writeBack(size_t head);
+    void readIn(size_t page_num, size_t head, unsigned order);
+    size_t untouchedPages(size_t head) const;
+    bool isMapped(size_t page_num) const {
+        return page_table[page_num].valid && page_table[page_num].epoch == epoch;
+    }
+    size_t headOf(size_t page_num) const {
+        const PageTableEntry& entry = page_table[page_num];
+        return entry.epoch == epoch ? page_num & ~((size_t(1) << entry.order) - 1) : page_num;
+    }
+    uint32_t accessStamp(size_t access) const {
+        return access > access_base ? access - access_base : 0;
+    }
+    size_t accessOf(uint32_t stamp) const { return access_base + stamp; }
+    void rebaseStamps();
+    int selectVictimPage();
+    bool handlePageFault(size_t page_num);
+    void recordReference(size_t page_num);
+    void evictPage(size_t page_num);
+    void controlResidentSet(size_t previous_fault, size_t now);
+    void dropStaleQueued();
+    void clearWorkingSet();
+    void unlinkWorkingSet(size_t page_num);
+    void appendWorkingSet(size_t page_num, uint32_t stamp);
+    void takeSample();
+};
+
 #endif // VIRTUAL_MEMORY_H
\ No newline at end of file
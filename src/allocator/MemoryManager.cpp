@@ -1,210 +1,577 @@
-#include "MemoryManager.h"
-#include <iostream>
-#include <iomanip>
-#include <algorithm>
-
-MemoryManager::MemoryManager()
-    : total_memory(0), used_memory(0), next_id(1),
-      current_strategy(FIRST_FIT), internal_frag(0),
-      total_alloc_requests(0), failed_requests(0) {}
-
-void MemoryManager::init(size_t total_size) {
-    blocks.clear();
-    blocks.push_back(Block(0, total_size, true, -1));
-    total_memory = total_size;
-    used_memory = 0;
-    next_id = 1;
-    internal_frag = 0;
-    total_alloc_requests = 0;
-    failed_requests = 0;
-    std::cout << "Memory initialized: " << total_size << " bytes\n";
-}
-
-void MemoryManager::setStrategy(AllocStrategy strategy) {
-    current_strategy = strategy;
-    std::string stratName;
-    switch(strategy) {
-        case FIRST_FIT: stratName = "First Fit"; break;
-        case BEST_FIT: stratName = "Best Fit"; break;
-        case WORST_FIT: stratName = "Worst Fit"; break;
-    }
-    std::cout << "Allocation strategy set to: " << stratName << "\n";
-}
-
-int MemoryManager::malloc(size_t nbytes) {
-    total_alloc_requests++;
-    
-    if (nbytes == 0) {
-        std::cout << "Error: Cannot allocate 0 bytes\n";
-        failed_requests++;
-        return -1;
-    }
-    
-    int block_index = -1;
-    switch(current_strategy) {
-        case FIRST_FIT:
-            block_index = firstFit(nbytes);
-            break;
-        case BEST_FIT:
-            block_index = bestFit(nbytes);
-            break;
-        case WORST_FIT:
-            block_index = worstFit(nbytes);
-            break;
-    }
-    
-    if (block_index == -1) {
-        std::cout << "Error: Allocation failed - not enough memory\n";
-        failed_requests++;
-        return -1;
-    }
-    
-    // Split block if there's enough space for a new block
-    if (blocks[block_index].size > nbytes) {
-        Block new_block(blocks[block_index].address + nbytes, blocks[block_index].size - nbytes, true, -1);
-        blocks[block_index].size = nbytes;
-        blocks.insert(blocks.begin() + block_index + 1, new_block);
-    }
-    
-    // Allocate the block
-    Block& allocated_block = blocks[block_index];
-    allocated_block.is_free = false;
-    allocated_block.id = next_id++;
-    used_memory += allocated_block.size;
-    
-    std::cout << "Allocated block id=" << allocated_block.id 
-              << " at address=0x" << std::hex << std::setfill('0') 
-              << std::setw(4) << allocated_block.address << std::dec << "\n";
-    
-    return allocated_block.id;
-}
-
-void MemoryManager::free(int block_id) {
-    for (size_t i = 0; i < blocks.size(); i++) {
-        if (blocks[i].id == block_id && !blocks[i].is_free) {
-            blocks[i].is_free = true;
-            blocks[i].id = -1;
-            used_memory -= blocks[i].size;
-            
-            // Coalesce with adjacent free blocks
-            coalesce(i);
-            
-            std::cout << "Block " << block_id << " freed and merged\n";
-            return;
-        }
-    }
-    std::cout << "Error: Block " << block_id << " not found or already free\n";
-}
-
-void MemoryManager::coalesce(size_t index) {
-    // Merge with next block if it's free
-    while (index + 1 < blocks.size() && blocks[index + 1].is_free) {
-        blocks[index].size += blocks[index + 1].size;
-        blocks.erase(blocks.begin() + index + 1);
-    }
-    
-    // Merge with previous block if it's free
-    while (index > 0 && blocks[index - 1].is_free) {
-        blocks[index - 1].size += blocks[index].size;
-        blocks.erase(blocks.begin() + index);
-        index--;
-    }
-}
-
-int MemoryManager::firstFit(size_t size) {
-    for (size_t i = 0; i < blocks.size(); i++) {
-        if (blocks[i].is_free && blocks[i].size >= size) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int MemoryManager::bestFit(size_t size) {
-    int best_index = -1;
-    size_t best_size = SIZE_MAX;
-    
-    for (size_t i = 0; i < blocks.size(); i++) {
-        if (blocks[i].is_free && blocks[i].size >= size) {
-            if (blocks[i].size < best_size) {
-                best_size = blocks[i].size;
-                best_index = i;
-            }
-        }
-    }
-    return best_index;
-}
-
-int MemoryManager::worstFit(size_t size) {
-    int worst_index = -1;
-    size_t worst_size = 0;
-    
-    for (size_t i = 0; i < blocks.size(); i++) {
-        if (blocks[i].is_free && blocks[i].size >= size) {
-            if (blocks[i].size > worst_size) {
-                worst_size = blocks[i].size;
-                worst_index = i;
-            }
-        }
-    }
-    return worst_index;
-}
-
-void MemoryManager::dump() const {
-    std::cout << "\n=== Memory Dump ===\n";
-    for (const auto& block : blocks) {
-        std::cout << "[0x" << std::hex << std::setfill('0') << std::setw(4) 
-                  << block.address << " - 0x" << std::setw(4) 
-                  << (block.address + block.size - 1) << std::dec << "] ";
-        
-        if (block.is_free) {
-            std::cout << "FREE";
-        } else {
-            std::cout << "USED (id=" << block.id << ")";
-        }
-        std::cout << " [" << block.size << " bytes]\n";
-    }
-    std::cout << "===================\n\n";
-}
-
-size_t MemoryManager::getLargestFreeBlock() const {
-    size_t largest = 0;
-    for (const auto& block : blocks) {
-        if (block.is_free && block.size > largest) {
-            largest = block.size;
-        }
-    }
-    return largest;
-}
-
-size_t MemoryManager::calculateExternalFragmentation() const {
-    size_t total_free = 0;
-    for (const auto& block : blocks) {
-        if (block.is_free) {
-            total_free += block.size;
-        }
-    }
-    
-    size_t largest_free = getLargestFreeBlock();
-    if (total_free == 0) return 0;
-    
-    return ((total_free - largest_free) * 100) / total_free;
-}
-
-void MemoryManager::stats() const {
-    std::cout << "\n=== Memory Statistics ===\n";
-    std::cout << "Total memory: " << total_memory << " bytes\n";
-    std::cout << "Used memory: " << used_memory << " bytes\n";
-    std::cout << "Free memory: " << (total_memory - used_memory) << " bytes\n";
-    std::cout << "Memory utilization: " 
-              << (total_memory > 0 ? (used_memory * 100) / total_memory : 0) << "%\n";
-    std::cout << "Internal fragmentation: " << internal_frag << " bytes\n";
-    std::cout << "External fragmentation: " << calculateExternalFragmentation() << "%\n";
-    std::cout << "Allocation requests: " << total_alloc_requests << "\n";
-    std::cout << "Failed requests: " << failed_requests << "\n";
-    std::cout << "Success rate: " 
-              << (total_alloc_requests > 0 ? 
-                  ((total_alloc_requests - failed_requests) * 100) / total_alloc_requests : 0)
-              << "%\n";
-    std::cout << "========================\n\n";
+#include "MemoryManager.h"
+#include "Snapshot.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Epoch offsets are rebased when they reach 32 bits, keeping this much history
+static const size_t EPOCH_KEEP = size_t(1) << 31;
+
+MemoryManager::MemoryManager()
+    : granule_shift(0), total_memory(0), used_memory(0), next_id(1),
+      current_strategy(FIRST_FIT), verbose(true), internal_frag(0),
+      total_alloc_requests(0), failed_requests(0), search_steps(0),
+      compaction_bytes(0), op_clock(0), epoch_base(0), rover(0), free_bytes(0) {}
+
+void MemoryManager::init(size_t total_size) {
+    // Smallest granule that keeps every offset within 32 bits; any tail
+    // shorter than a granule is not managed
+    granule_shift = 0;
+    while ((total_size >> granule_shift) > UINT32_MAX) {
+        granule_shift++;
+    }
+    size_t granules = total_size >> granule_shift;
+    
+    blocks.clear();
+    blocks.push_back(Block(0, granules, -1));
+    alloc_times.clear();
+    total_memory = toBytes(granules);
+    used_memory = 0;
+    next_id = 1;
+    internal_frag = 0;
+    total_alloc_requests = 0;
+    failed_requests = 0;
+    search_steps = 0;
+    compaction_bytes = 0;
+    op_clock = 0;
+    epoch_base = 0;
+    size_hist.reset();
+    lifetime_hist.reset();
+    rover = 0;
+    free_sizes.clear();
+    free_list.clear();
+    free_bytes = 0;
+    addFreeBlock(blocks[0]);
+    sampler.close();
+    if (verbose) {
+        std::cout << "Memory initialized: " << total_memory << " bytes";
+        if (granule_shift > 0) {
+            std::cout << " in " << getGranule() << " byte granules";
+        }
+        std::cout << "\n";
+    }
+}
+
+void MemoryManager::setStrategy(AllocStrategy strategy) {
+    current_strategy = strategy;
+    std::string stratName;
+    switch(strategy) {
+        case FIRST_FIT: stratName = "First Fit"; break;
+        case BEST_FIT: stratName = "Best Fit"; break;
+        case WORST_FIT: stratName = "Worst Fit"; break;
+        case NEXT_FIT: stratName = "Next Fit"; break;
+    }
+    if (verbose) {
+        std::cout << "Allocation strategy set to: " << stratName << "\n";
+    }
+}
+
+int MemoryManager::malloc(size_t nbytes) {
+    total_alloc_requests++;
+    beginOperation();
+    
+    if (nbytes == 0) {
+        if (verbose) std::cout << "Error: Cannot allocate 0 bytes\n";
+        failed_requests++;
+        return -1;
+    }
+    size_hist.record(nbytes);
+    // Reject oversized requests before rounding so the sum cannot wrap
+    if (nbytes > total_memory) {
+        if (verbose) std::cout << "Error: Allocation failed - not enough memory\n";
+        failed_requests++;
+        return -1;
+    }
+    size_t granules = (nbytes + getGranule() - 1) >> granule_shift;
+    
+    [[maybe_unused]] size_t steps_before = search_steps;
+    int block_index = -1;
+    switch(current_strategy) {
+        case FIRST_FIT:
+            block_index = firstFit(granules);
+            break;
+        case BEST_FIT:
+            block_index = bestFit(granules);
+            break;
+        case WORST_FIT:
+            block_index = worstFit(granules);
+            break;
+        case NEXT_FIT:
+            block_index = nextFit(granules);
+            break;
+    }
+    MEMSIM_PROBE(PROBE_MALLOC_SEARCH, search_steps - steps_before);
+    
+    if (block_index == -1) {
+        if (verbose) std::cout << "Error: Allocation failed - not enough memory\n";
+        failed_requests++;
+        return -1;
+    }
+    
+    removeFreeBlock(blocks[block_index]);
+    
+    // Split block if there's enough space for a new block
+    if (blocks[block_index].size > granules) {
+        Block new_block(blocks[block_index].address + granules, blocks[block_index].size - granules, -1);
+        blocks[block_index].size = granules;
+        blocks.insert(blocks.begin() + block_index + 1, new_block);
+        addFreeBlock(new_block);
+    }
+    
+    // Next fit resumes just past the block it handed out
+    rover = blocks[block_index].address + granules;
+    
+    // Allocate the block
+    Block& allocated_block = blocks[block_index];
+    allocated_block.id = next_id++;
+    alloc_times.push_back({allocated_block.id, (uint32_t)(op_clock - epoch_base)});
+    used_memory += toBytes(allocated_block.size);
+    internal_frag += toBytes(granules) - nbytes;
+    
+    if (verbose) {
+        std::cout << "Allocated block id=" << allocated_block.id 
+                  << " at address=0x" << std::hex << std::setfill('0') 
+                  << std::setw(4) << toBytes(allocated_block.address) << std::dec << "\n";
+    }
+    
+    return allocated_block.id;
+}
+
+void MemoryManager::free(int block_id) {
+    beginOperation();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].id == block_id && !blocks[i].isFree()) {
+            std::vector<AllocTime>::iterator allocated = std::lower_bound(
+                alloc_times.begin(), alloc_times.end(), block_id,
+                [](const AllocTime& entry, int id) { return entry.id < id; });
+            lifetime_hist.record(op_clock - (epoch_base + allocated->time));
+            alloc_times.erase(allocated);
+            blocks[i].id = -1;
+            used_memory -= toBytes(blocks[i].size);
+            
+            // Coalesce with adjacent free blocks
+            coalesce(i);
+            
+            if (verbose) {
+                std::cout << "Block " << block_id << " freed and merged\n";
+            }
+            return;
+        }
+    }
+    if (verbose) {
+        std::cout << "Error: Block " << block_id << " not found or already free\n";
+    }
+}
+
+size_t MemoryManager::getBlockAddress(int block_id) const {
+    for (const auto& block : blocks) {
+        if (!block.isFree() && block.id == block_id) {
+            return toBytes(block.address);
+        }
+    }
+    return SIZE_MAX;
+}
+
+size_t MemoryManager::getBlockSize(int block_id) const {
+    for (const auto& block : blocks) {
+        if (!block.isFree() && block.id == block_id) {
+            return toBytes(block.size);
+        }
+    }
+    return SIZE_MAX;
+}
+
+// Index of the block starting at address, which must be a block boundary
+size_t MemoryManager::blockIndex(size_t address) const {
+    return std::lower_bound(blocks.begin(), blocks.end(), address,
+                            [](const Block& block, size_t a) { return block.address < a; }) - blocks.begin();
+}
+
+void MemoryManager::addFreeBlock(const Block& block) {
+    free_sizes.insert(std::upper_bound(free_sizes.begin(), free_sizes.end(), block.size), block.size);
+    free_list.insert(std::lower_bound(free_list.begin(), free_list.end(), block.address), block.address);
+    free_bytes += toBytes(block.size);
+}
+
+void MemoryManager::removeFreeBlock(const Block& block) {
+    free_sizes.erase(std::lower_bound(free_sizes.begin(), free_sizes.end(), block.size));
+    free_list.erase(std::lower_bound(free_list.begin(), free_list.end(), block.address));
+    free_bytes -= toBytes(block.size);
+}
+
+// blocks[index] has just been freed and is not yet in the free index
+void MemoryManager::coalesce(size_t index) {
+    [[maybe_unused]] size_t blocks_before = blocks.size();
+    
+    // Merge with next block if it's free
+    while (index + 1 < blocks.size() && blocks[index + 1].isFree()) {
+        removeFreeBlock(blocks[index + 1]);
+        blocks[index].size += blocks[index + 1].size;
+        blocks.erase(blocks.begin() + index + 1);
+    }
+    
+    // Merge with previous block if it's free
+    while (index > 0 && blocks[index - 1].isFree()) {
+        removeFreeBlock(blocks[index - 1]);
+        blocks[index - 1].size += blocks[index].size;
+        blocks.erase(blocks.begin() + index);
+        index--;
+    }
+    MEMSIM_PROBE(PROBE_COALESCE_MERGES, blocks_before - blocks.size());
+    
+    addFreeBlock(blocks[index]);
+}
+
+CompactionResult MemoryManager::compact(size_t max_bytes) {
+    CompactionResult result;
+    result.bytes_moved = 0;
+    result.complete = true;
+    
+    // Rebuild the block list in one pass. Used blocks slide down to
+    // next_address while the budget allows; a block that stays leaves the
+    // gap in front of it as a free block.
+    std::vector<Block> compacted;
+    compacted.reserve(blocks.size());
+    size_t next_address = 0;  // in granules
+    size_t total_granules = total_memory >> granule_shift;
+    for (const Block& block : blocks) {
+        if (block.isFree()) {
+            continue;
+        }
+        
+        // A block larger than what is left of the budget stays put, and the
+        // smaller blocks after it still slide down behind it
+        Block moved = block;
+        if (block.address != next_address) {
+            size_t bytes = toBytes(block.size);
+            if (result.bytes_moved + bytes > max_bytes) {
+                result.complete = false;
+            } else {
+                result.relocations.push_back({block.id, toBytes(block.address), toBytes(next_address), bytes});
+                result.bytes_moved += bytes;
+                moved.address = next_address;
+            }
+        }
+        
+        if (moved.address > next_address) {
+            compacted.push_back(Block(next_address, moved.address - next_address, -1));
+        }
+        compacted.push_back(moved);
+        next_address = moved.address + moved.size;
+    }
+    
+    // All remaining free space becomes one tail block
+    if (next_address < total_granules) {
+        compacted.push_back(Block(next_address, total_granules - next_address, -1));
+    }
+    
+    blocks.swap(compacted);
+    compaction_bytes += result.bytes_moved;
+    
+    free_sizes.clear();
+    free_list.clear();
+    free_bytes = 0;
+    for (const Block& block : blocks) {
+        if (block.isFree()) {
+            addFreeBlock(block);
+        }
+    }
+    
+    // Resume next fit at the first hole
+    rover = 0;
+    
+    return result;
+}
+
+int MemoryManager::firstFit(size_t size) {
+    for (size_t i = 0; i < blocks.size(); i++) {
+        search_steps++;
+        if (blocks[i].isFree() && blocks[i].size >= size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int MemoryManager::nextFit(size_t size) {
+    // Walk the free list from the rover to the end, then wrap around to it;
+    // used blocks are never examined. A merge can leave the rover inside a
+    // free block, and the search starts with that block.
+    size_t n = free_list.size();
+    size_t start = std::lower_bound(free_list.begin(), free_list.end(), rover) - free_list.begin();
+    if (start > 0) {
+        const Block& before = blocks[blockIndex(free_list[start - 1])];
+        if (before.address + before.size > rover) {
+            start--;
+        }
+    }
+    for (size_t k = 0; k < n; k++) {
+        size_t i = blockIndex(free_list[(start + k) % n]);
+        search_steps++;
+        if (blocks[i].size >= size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int MemoryManager::bestFit(size_t size) {
+    int best_index = -1;
+    size_t best_size = SIZE_MAX;
+    
+    for (size_t i = 0; i < blocks.size(); i++) {
+        search_steps++;
+        if (blocks[i].isFree() && blocks[i].size >= size) {
+            if (blocks[i].size < best_size) {
+                best_size = blocks[i].size;
+                best_index = i;
+            }
+        }
+    }
+    return best_index;
+}
+
+int MemoryManager::worstFit(size_t size) {
+    int worst_index = -1;
+    size_t worst_size = 0;
+    
+    for (size_t i = 0; i < blocks.size(); i++) {
+        search_steps++;
+        if (blocks[i].isFree() && blocks[i].size >= size) {
+            if (blocks[i].size > worst_size) {
+                worst_size = blocks[i].size;
+                worst_index = i;
+            }
+        }
+    }
+    return worst_index;
+}
+
+void MemoryManager::dump() const {
+    std::cout << "\n=== Memory Dump ===\n";
+    for (const auto& block : blocks) {
+        std::cout << "[0x" << std::hex << std::setfill('0') << std::setw(4) 
+                  << toBytes(block.address) << " - 0x" << std::setw(4) 
+                  << (toBytes(block.address + block.size) - 1) << std::dec << "] ";
+        
+        if (block.isFree()) {
+            std::cout << "FREE";
+        } else {
+            std::cout << "USED (id=" << block.id << ")";
+        }
+        std::cout << " [" << toBytes(block.size) << " bytes]\n";
+    }
+    std::cout << "===================\n\n";
+}
+
+size_t MemoryManager::getLargestFreeBlock() const {
+    return free_sizes.empty() ? 0 : toBytes(free_sizes.back());
+}
+
+size_t MemoryManager::calculateExternalFragmentation() const {
+    if (free_bytes == 0) return 0;
+    
+    return ((free_bytes - getLargestFreeBlock()) * 100) / free_bytes;
+}
+
+void MemoryManager::beginOperation() {
+    if (sampler.tick()) {
+        takeSample();
+    }
+    op_clock++;
+    if (op_clock - epoch_base > UINT32_MAX) {
+        rebaseEpoch();
+    }
+}
+
+// Move the epoch up so allocation times stay within 32 bits. Blocks
+// allocated more than EPOCH_KEEP operations ago clamp to the new base, so
+// only lifetimes longer than that are shortened.
+void MemoryManager::rebaseEpoch() {
+    size_t shift = op_clock - epoch_base - EPOCH_KEEP;
+    for (AllocTime& entry : alloc_times) {
+        entry.time = entry.time > shift ? entry.time - shift : 0;
+    }
+    epoch_base += shift;
+}
+
+size_t MemoryManager::metadataBytes() const {
+    return blocks.size() * sizeof(Block) + alloc_times.size() * sizeof(AllocTime) +
+           (free_sizes.size() + free_list.size()) * sizeof(uint32_t);
+}
+
+bool MemoryManager::startSampling(const std::string& path, size_t interval) {
+    return sampler.open(path, {"op", "utilization_pct", "external_fragmentation_pct",
+                               "largest_free_block", "free_bytes", "free_blocks"}, interval);
+}
+
+void MemoryManager::stopSampling() {
+    // Record the state at the end of the run before closing
+    if (sampler.isOpen()) {
+        takeSample();
+        sampler.close();
+    }
+}
+
+void MemoryManager::takeSample() {
+    double row[] = {
+        (double)op_clock,
+        total_memory > 0 ? 100.0 * used_memory / total_memory : 0.0,
+        (double)calculateExternalFragmentation(),
+        (double)getLargestFreeBlock(),
+        (double)free_bytes,
+        (double)free_sizes.size(),
+    };
+    sampler.write(row);
+}
+
+void MemoryManager::stats() const {
+    std::cout << "\n=== Memory Statistics ===\n";
+    std::cout << "Total memory: " << total_memory << " bytes\n";
+    std::cout << "Used memory: " << used_memory << " bytes\n";
+    std::cout << "Free memory: " << free_bytes << " bytes\n";
+    std::cout << "Free blocks: " << free_sizes.size()
+              << " (largest " << getLargestFreeBlock() << " bytes)\n";
+    std::cout << "Memory utilization: " 
+              << (total_memory > 0 ? (used_memory * 100) / total_memory : 0) << "%\n";
+    std::cout << "Internal fragmentation: " << internal_frag << " bytes\n";
+    std::cout << "External fragmentation: " << calculateExternalFragmentation() << "%\n";
+    std::cout << "Allocation requests: " << total_alloc_requests << "\n";
+    std::cout << "Failed requests: " << failed_requests << "\n";
+    std::cout << "Success rate: " 
+              << (total_alloc_requests > 0 ? 
+                  ((total_alloc_requests - failed_requests) * 100) / total_alloc_requests : 0)
+              << "%\n";
+    std::cout << "Average search length: " << std::fixed << std::setprecision(2)
+              << (total_alloc_requests > 0 ? (double)search_steps / total_alloc_requests : 0.0)
+              << " blocks\n";
+    std::cout << "Bytes moved by compaction: " << compaction_bytes << "\n";
+    std::cout << "Metadata: " << metadataBytes() << " bytes for " << blocks.size() << " blocks ("
+              << (blocks.empty() ? 0.0 : (double)metadataBytes() / blocks.size()) << " bytes per block, "
+              << getGranule() << " byte granule)\n";
+    size_hist.print("Allocation size", "bytes");
+    lifetime_hist.print("Block lifetime", "ops");
+    std::cout << "========================\n\n";
+}
+
+void MemoryManager::writeStatsJson(std::ostream& out) const {
+    out << "{\"total_memory\": " << total_memory << ", \"used_memory\": " << used_memory
+        << ", \"allocation_requests\": " << total_alloc_requests
+        << ", \"failed_requests\": " << failed_requests
+        << ", \"external_fragmentation_pct\": " << calculateExternalFragmentation()
+        << ", \"blocks\": " << blocks.size() << ", \"metadata_bytes\": " << metadataBytes()
+        << ",\n    \"allocation_size\": ";
+    size_hist.writeJson(out);
+    out << ",\n    \"block_lifetime\": ";
+    lifetime_hist.writeJson(out);
+    out << "}";
+}
+
+bool MemoryManager::save(const std::string& path) const {
+    SnapshotWriter out(path, SNAPSHOT_MEMORY_MANAGER);
+    out.put(total_memory);
+    out.put(used_memory);
+    out.put(next_id);
+    out.put(current_strategy);
+    out.put(internal_frag);
+    out.put(total_alloc_requests);
+    out.put(failed_requests);
+    out.put(search_steps);
+    out.put(compaction_bytes);
+    out.put(op_clock);
+    out.put(toBytes(rover));
+    out.put(epoch_base);
+    
+    // Blocks as they are in memory, in address order, with offsets in
+    // granules, then the allocation times from epoch_base
+    out.putRecords(blocks.data(), blocks.size());
+    out.putRecords(alloc_times.data(), alloc_times.size());
+    
+    size_hist.save(out);
+    lifetime_hist.save(out);
+    
+    if (!out.ok()) {
+        std::cout << "Error: Cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool MemoryManager::load(const std::string& path) {
+    SnapshotReader in(path, SNAPSHOT_MEMORY_MANAGER);
+    const uint64_t* header = in.getArray(12);
+    std::vector<Block> loaded;
+    std::vector<AllocTime> times;
+    if (!header || !in.getRecords(loaded) || !in.getRecords(times)) {
+        std::cout << "Error: " << in.error() << "\n";
+        return false;
+    }
+    
+    // The blocks must tile [0, total_memory) in whole granules before
+    // anything is replaced
+    unsigned shift = 0;
+    while ((header[0] >> shift) > UINT32_MAX) {
+        shift++;
+    }
+    uint64_t granule_mask = (uint64_t(1) << shift) - 1;
+    // Every used block needs one allocation time, in increasing id order
+    uint64_t expected_address = 0;
+    std::vector<int32_t> ids;
+    for (const Block& block : loaded) {
+        if (block.address != expected_address || block.size == 0) {
+            std::cout << "Error: " << path << " has an inconsistent block list\n";
+            return false;
+        }
+        expected_address += block.size;
+        if (!block.isFree()) {
+            ids.push_back(block.id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    bool times_ok = ids.size() == times.size();
+    for (size_t i = 0; i < ids.size() && times_ok; i++) {
+        times_ok = times[i].id == ids[i] && (i == 0 || ids[i] > ids[i - 1]);
+    }
+    if (!times_ok || (header[0] & granule_mask) != 0 || expected_address != header[0] >> shift ||
+        header[3] > NEXT_FIT || header[11] > header[9]) {
+        std::cout << "Error: " << path << " has an inconsistent block list\n";
+        return false;
+    }
+    
+    Histogram sizes, lifetimes;
+    if (!sizes.load(in) || !lifetimes.load(in)) {
+        std::cout << "Error: " << in.error() << "\n";
+        return false;
+    }
+    
+    sampler.close();
+    granule_shift = shift;
+    total_memory = header[0];
+    used_memory = header[1];
+    next_id = (int)header[2];
+    current_strategy = (AllocStrategy)header[3];
+    internal_frag = header[4];
+    total_alloc_requests = header[5];
+    failed_requests = header[6];
+    search_steps = header[7];
+    compaction_bytes = header[8];
+    op_clock = header[9];
+    epoch_base = header[11];
+    rover = header[10] >> shift;
+    blocks.swap(loaded);
+    alloc_times.swap(times);
+    size_hist = sizes;
+    lifetime_hist = lifetimes;
+    
+    // The free index is derived state
+    free_sizes.clear();
+    free_list.clear();
+    free_bytes = 0;
+    for (const Block& block : blocks) {
+        if (block.isFree()) {
+            addFreeBlock(block);
+        }
+    }
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "Arena.h"
+#include "MemoryManager.h"
+#include "BuddyAllocator.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+// Bump the region's pointer; SIZE_MAX when the region is exhausted
+static size_t bumpAllocate(Arena& arena, size_t size) {
+    size_t aligned = (arena.offset + ArenaManager::ALIGNMENT - 1) & ~(ArenaManager::ALIGNMENT - 1);
+    if (aligned > arena.capacity || size > arena.capacity - aligned) {
+        arena.failed_allocs++;
+        return SIZE_MAX;
+    }
+
+    arena.padding_bytes += aligned - arena.offset;
+    arena.requested_bytes += size;
+    arena.offset = aligned + size;
+    arena.alloc_count++;
+    if (arena.offset > arena.peak_offset) {
+        arena.peak_offset = arena.offset;
+    }
+    return arena.base + aligned;
+}
+
+ArenaManager::ArenaManager(MemoryManager& manager)
+    : memory_manager(&manager), buddy_allocator(nullptr), next_id(1) {}
+
+ArenaManager::ArenaManager(BuddyAllocator& allocator)
+    : memory_manager(nullptr), buddy_allocator(&allocator), next_id(1) {}
+
+int ArenaManager::backingAllocate(size_t size) {
+    return memory_manager ? memory_manager->malloc(size) : buddy_allocator->allocate(size);
+}
+
+void ArenaManager::backingFree(int block_id) {
+    if (memory_manager) {
+        memory_manager->free(block_id);
+    } else {
+        buddy_allocator->free(block_id);
+    }
+}
+
+size_t ArenaManager::backingAddress(int block_id) const {
+    return memory_manager ? memory_manager->getBlockAddress(block_id)
+                          : buddy_allocator->getBlockAddress(block_id);
+}
+
+size_t ArenaManager::backingSize(int block_id) const {
+    return memory_manager ? memory_manager->getBlockSize(block_id)
+                          : buddy_allocator->getBlockSize(block_id);
+}
+
+int ArenaManager::create(size_t size) {
+    if (size == 0) {
+        std::cout << "Error: Cannot create an empty arena\n";
+        return -1;
+    }
+
+    int block_id = backingAllocate(size);
+    if (block_id == -1) {
+        std::cout << "Error: Arena creation failed - backing allocation failed\n";
+        return -1;
+    }
+
+    // The buddy allocator may round the region up; the arena uses all of it
+    int id = next_id++;
+    arenas[id] = Arena(id, block_id, backingAddress(block_id), backingSize(block_id));
+
+    std::cout << "Arena " << id << " created: " << arenas[id].capacity
+              << " bytes at address=0x" << std::hex << std::setfill('0')
+              << std::setw(4) << arenas[id].base << std::dec
+              << " (backing block id=" << block_id << ")\n";
+    return id;
+}
+
+size_t ArenaManager::allocate(int arena_id, size_t size) {
+    auto it = arenas.find(arena_id);
+    if (it == arenas.end()) {
+        std::cout << "Error: Arena " << arena_id << " not found\n";
+        return SIZE_MAX;
+    }
+    if (size == 0) {
+        std::cout << "Error: Cannot allocate 0 bytes\n";
+        return SIZE_MAX;
+    }
+
+    Arena& arena = it->second;
+    size_t address = bumpAllocate(arena, size);
+    if (address == SIZE_MAX) {
+        std::cout << "Error: Arena " << arena_id << " exhausted ("
+                  << (arena.capacity - arena.offset) << " bytes left)\n";
+        return SIZE_MAX;
+    }
+    if (arena.trace.size() < TRACE_LIMIT) {
+        arena.trace.push_back(size);
+    }
+
+    std::cout << "Arena " << arena_id << ": allocated " << size
+              << " bytes at address=0x" << std::hex << std::setfill('0')
+              << std::setw(4) << address << std::dec << "\n";
+    return address;
+}
+
+void ArenaManager::reset(int arena_id) {
+    auto it = arenas.find(arena_id);
+    if (it == arenas.end()) {
+        std::cout << "Error: Arena " << arena_id << " not found\n";
+        return;
+    }
+
+    // Releasing every object is a single pointer reset
+    Arena& arena = it->second;
+    size_t released = arena.alloc_count;
+    if (!arena.trace.empty()) {
+        arena.last_trace.swap(arena.trace);
+        arena.trace.clear();
+        arena.last_alloc_count = arena.alloc_count;
+    }
+    arena.offset = 0;
+    arena.requested_bytes = 0;
+    arena.padding_bytes = 0;
+    arena.alloc_count = 0;
+    arena.reset_count++;
+
+    std::cout << "Arena " << arena_id << " reset (" << released << " objects released)\n";
+}
+
+void ArenaManager::destroy(int arena_id) {
+    auto it = arenas.find(arena_id);
+    if (it == arenas.end()) {
+        std::cout << "Error: Arena " << arena_id << " not found\n";
+        return;
+    }
+
+    backingFree(it->second.backing_id);
+    arenas.erase(it);
+    std::cout << "Arena " << arena_id << " destroyed\n";
+}
+
+void ArenaManager::relocate(const std::vector<Relocation>& relocations) {
+    for (const Relocation& r : relocations) {
+        for (auto& pair : arenas) {
+            if (pair.second.backing_id == r.id) {
+                pair.second.base = r.new_address;
+                std::cout << "Arena " << pair.first << " moved to address=0x" << std::hex
+                          << std::setfill('0') << std::setw(4) << r.new_address << std::dec << "\n";
+            }
+        }
+    }
+}
+
+int ArenaManager::ownerOf(int block_id) const {
+    for (const auto& pair : arenas) {
+        if (pair.second.backing_id == block_id) {
+            return pair.first;
+        }
+    }
+    return -1;
+}
+
+void ArenaManager::clear() {
+    arenas.clear();
+    next_id = 1;
+}
+
+void ArenaManager::compareWithMalloc(const Arena& arena) const {
+    const std::vector<size_t>& trace = arena.trace.empty() ? arena.last_trace : arena.trace;
+    size_t allocations = arena.trace.empty() ? arena.last_alloc_count : arena.alloc_count;
+    if (trace.empty()) {
+        std::cout << "No allocations to compare against malloc/free\n";
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    size_t ops = trace.size();
+
+    // Replay on a scratch region of the same capacity
+    Arena scratch(0, -1, 0, arena.capacity);
+    size_t sink = 0;
+    auto t0 = Clock::now();
+    for (size_t size : trace) {
+        sink += bumpAllocate(scratch, size);
+    }
+    auto t1 = Clock::now();
+    size_t arena_used = scratch.offset;
+    scratch.offset = 0;
+    auto t2 = Clock::now();
+
+    // Replay on a fresh allocator of the same kind: malloc everything, then
+    // free every object individually
+    std::vector<int> ids;
+    ids.reserve(ops);
+    Clock::duration malloc_time, free_time;
+    size_t malloc_used = 0;
+    size_t malloc_failed = 0;
+    if (memory_manager) {
+        MemoryManager heap;
+        heap.setVerbose(false);
+        heap.init(arena.capacity);
+        auto start = Clock::now();
+        for (size_t size : trace) {
+            ids.push_back(heap.malloc(size));
+        }
+        malloc_time = Clock::now() - start;
+        for (int id : ids) {
+            if (id != -1) malloc_used += heap.getBlockSize(id);
+        }
+        start = Clock::now();
+        for (int id : ids) {
+            if (id != -1) heap.free(id);
+        }
+        free_time = Clock::now() - start;
+    } else {
+        BuddyAllocator heap;
+        heap.setVerbose(false);
+        heap.init(arena.capacity);
+        auto start = Clock::now();
+        for (size_t size : trace) {
+            ids.push_back(heap.allocate(size));
+        }
+        malloc_time = Clock::now() - start;
+        for (int id : ids) {
+            if (id != -1) malloc_used += heap.getBlockSize(id);
+        }
+        start = Clock::now();
+        for (int id : ids) {
+            if (id != -1) heap.free(id);
+        }
+        free_time = Clock::now() - start;
+    }
+    for (int id : ids) {
+        if (id == -1) malloc_failed++;
+    }
+
+    auto ns = [](Clock::duration d) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    };
+    size_t requested = 0;
+    for (size_t size : trace) requested += size;
+
+    std::cout << "Comparison on ";
+    if (allocations > ops) {
+        std::cout << "the first " << ops << " of ";
+    }
+    std::cout << allocations << " allocations (" << requested << " bytes requested):\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Arena:  " << ns(t1 - t0) / ops << " ns/alloc, reset "
+              << ns(t2 - t1) << " ns, " << arena_used << " bytes reserved, utilization "
+              << (arena_used > 0 ? (double)requested * 100.0 / arena_used : 0.0) << "%\n";
+    std::cout << "  Malloc: " << ns(malloc_time) / ops << " ns/alloc, "
+              << ns(free_time) / ops << " ns/free, " << malloc_used << " bytes reserved, utilization "
+              << (malloc_used > 0 ? (double)requested * 100.0 / malloc_used : 0.0) << "%";
+    if (malloc_failed > 0) {
+        std::cout << ", " << malloc_failed << " failed";
+    }
+    std::cout << "\n";
+    (void)sink;
+}
+
+void ArenaManager::stats(int arena_id) const {
+    auto it = arenas.find(arena_id);
+    if (it == arenas.end()) {
+        std::cout << "Error: Arena " << arena_id << " not found\n";
+        return;
+    }
+
+    const Arena& arena = it->second;
+    std::cout << "\n=== Arena " << arena.id << " Statistics ===\n";
+    std::cout << "Base address: 0x" << std::hex << std::setfill('0') << std::setw(4)
+              << arena.base << std::dec << " (backing block id=" << arena.backing_id << ")\n";
+    std::cout << "Capacity: " << arena.capacity << " bytes\n";
+    std::cout << "Bump offset: " << arena.offset << " bytes\n";
+    std::cout << "Peak offset: " << arena.peak_offset << " bytes\n";
+    std::cout << "Live objects: " << arena.alloc_count << "\n";
+    std::cout << "Requested bytes: " << arena.requested_bytes << "\n";
+    std::cout << "Alignment padding: " << arena.padding_bytes << " bytes\n";
+    std::cout << "Region utilization: "
+              << (arena.capacity > 0 ? (arena.requested_bytes * 100) / arena.capacity : 0) << "%\n";
+    std::cout << "Failed allocations: " << arena.failed_allocs << "\n";
+    std::cout << "Resets: " << arena.reset_count << "\n";
+    compareWithMalloc(arena);
+    std::cout << "===============================\n\n";
+}
+
+void ArenaManager::stats() const {
+    if (arenas.empty()) {
+        std::cout << "No arenas\n";
+        return;
+    }
+    for (const auto& pair : arenas) {
+        stats(pair.first);
+    }
+}
@@ -1,188 +1,397 @@
-#include "BuddyAllocator.h"
-#include <iostream>
-#include <iomanip>
-#include <cmath>
-#include <algorithm>
-
-BuddyAllocator::BuddyAllocator()
-    : total_memory(0), used_memory(0), next_id(1),
-      total_alloc_requests(0), failed_requests(0), internal_frag(0) {}
-
-bool BuddyAllocator::isPowerOfTwo(size_t n) const {
-    return n > 0 && (n & (n - 1)) == 0;
-}
-
-size_t BuddyAllocator::nextPowerOfTwo(size_t n) const {
-    if (n == 0) return 1;
-    if (isPowerOfTwo(n)) return n;
-    
-    size_t power = 1;
-    while (power < n) {
-        power *= 2;
-    }
-    return power;
-}
-
-void BuddyAllocator::init(size_t total_size) {
-    if (!isPowerOfTwo(total_size)) {
-        std::cout << "Error: Total size must be a power of 2\n";
-        return;
-    }
-    
-    free_lists.clear();
-    allocated_blocks.clear();
-    total_memory = total_size;
-    used_memory = 0;
-    next_id = 1;
-    total_alloc_requests = 0;
-    failed_requests = 0;
-    internal_frag = 0;
-    
-    // Add the entire memory as one free block
-    free_lists[total_size].push_back(0);
-    
-    std::cout << "Buddy allocator initialized: " << total_size << " bytes\n";
-}
-
-size_t BuddyAllocator::getBuddyAddress(size_t address, size_t size) const {
-    return address ^ size;
-}
-
-void BuddyAllocator::splitBlock(size_t address, size_t current_size, size_t target_size) {
-    while (current_size > target_size) {
-        current_size /= 2;
-        size_t buddy_addr = address + current_size;
-        free_lists[current_size].push_back(buddy_addr);
-    }
-}
-
-int BuddyAllocator::allocate(size_t size) {
-    total_alloc_requests++;
-    
-    if (size == 0) {
-        std::cout << "Error: Cannot allocate 0 bytes\n";
-        failed_requests++;
-        return -1;
-    }
-    
-    // Round up to next power of two
-    size_t actual_size = nextPowerOfTwo(size);
-    
-    // Track internal fragmentation
-    internal_frag += (actual_size - size);
-    
-    // Find the smallest available block that fits
-    size_t block_size = actual_size;
-    while (block_size <= total_memory && free_lists[block_size].empty()) {
-        block_size *= 2;
-    }
-    
-    if (block_size > total_memory) {
-        std::cout << "Error: Allocation failed - not enough memory\n";
-        failed_requests++;
-        return -1;
-    }
-    
-    // Get a block of the found size
-    size_t address = free_lists[block_size].front();
-    free_lists[block_size].pop_front();
-    
-    // Split the block down to the required size
-    splitBlock(address, block_size, actual_size);
-    
-    // Allocate the block
-    int id = next_id++;
-    allocated_blocks[id] = BuddyBlock(address, actual_size, id);
-    used_memory += actual_size;
-    
-    std::cout << "Allocated block id=" << id 
-              << " at address=0x" << std::hex << std::setfill('0') 
-              << std::setw(4) << address << std::dec 
-              << " (requested: " << size << ", actual: " << actual_size << " bytes)\n";
-    
-    return id;
-}
-
-void BuddyAllocator::free(int block_id) {
-    auto it = allocated_blocks.find(block_id);
-    if (it == allocated_blocks.end()) {
-        std::cout << "Error: Block " << block_id << " not found\n";
-        return;
-    }
-    
-    BuddyBlock block = it->second;
-    allocated_blocks.erase(it);
-    used_memory -= block.size;
-    
-    size_t address = block.address;
-    size_t size = block.size;
-    
-    // Try to merge with buddy repeatedly
-    while (size < total_memory) {
-        size_t buddy_addr = getBuddyAddress(address, size);
-        
-        // Check if buddy is free
-        auto& free_list = free_lists[size];
-        auto buddy_it = std::find(free_list.begin(), free_list.end(), buddy_addr);
-        
-        if (buddy_it != free_list.end()) {
-            // Buddy is free, merge
-            free_list.erase(buddy_it);
-            address = std::min(address, buddy_addr);
-            size *= 2;
-        } else {
-            // Buddy is not free, stop merging
-            break;
-        }
-    }
-    
-    // Add the merged block to free list
-    free_lists[size].push_back(address);
-    
-    std::cout << "Block " << block_id << " freed and merged\n";
-}
-
-void BuddyAllocator::dump() const {
-    std::cout << "\n=== Buddy Allocator Memory Dump ===\n";
-    
-    // Show allocated blocks
-    std::cout << "Allocated blocks:\n";
-    for (const auto& pair : allocated_blocks) {
-        const BuddyBlock& block = pair.second;
-        std::cout << "  [0x" << std::hex << std::setfill('0') << std::setw(4) 
-                  << block.address << " - 0x" << std::setw(4) 
-                  << (block.address + block.size - 1) << std::dec 
-                  << "] USED (id=" << block.id << ", " << block.size << " bytes)\n";
-    }
-    
-    // Show free blocks
-    std::cout << "Free blocks:\n";
-    for (const auto& pair : free_lists) {
-        size_t size = pair.first;
-        const auto& list = pair.second;
-        for (size_t addr : list) {
-            std::cout << "  [0x" << std::hex << std::setfill('0') << std::setw(4) 
-                      << addr << " - 0x" << std::setw(4) 
-                      << (addr + size - 1) << std::dec 
-                      << "] FREE (" << size << " bytes)\n";
-        }
-    }
-    std::cout << "===================================\n\n";
-}
-
-void BuddyAllocator::stats() const {
-    std::cout << "\n=== Buddy Allocator Statistics ===\n";
-    std::cout << "Total memory: " << total_memory << " bytes\n";
-    std::cout << "Used memory: " << used_memory << " bytes\n";
-    std::cout << "Free memory: " << (total_memory - used_memory) << " bytes\n";
-    std::cout << "Memory utilization: " 
-              << (total_memory > 0 ? (used_memory * 100) / total_memory : 0) << "%\n";
-    std::cout << "Internal fragmentation: " << internal_frag << " bytes\n";
-    std::cout << "Allocation requests: " << total_alloc_requests << "\n";
-    std::cout << "Failed requests: " << failed_requests << "\n";
-    std::cout << "Success rate: " 
-              << (total_alloc_requests > 0 ? 
-                  ((total_alloc_requests - failed_requests) * 100) / total_alloc_requests : 0)
-              << "%\n";
-    std::cout << "==================================\n\n";
+#include "BuddyAllocator.h"
+#include "Snapshot.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+BuddyAllocator::BuddyAllocator()
+    : total_memory(0), used_memory(0), next_id(1), verbose(true),
+      total_alloc_requests(0), failed_requests(0), internal_frag(0),
+      op_clock(0) {}
+
+bool BuddyAllocator::isPowerOfTwo(size_t n) const {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+size_t BuddyAllocator::nextPowerOfTwo(size_t n) const {
+    if (n == 0) return 1;
+    if (isPowerOfTwo(n)) return n;
+    
+    size_t power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
+void BuddyAllocator::init(size_t total_size) {
+    if (!isPowerOfTwo(total_size)) {
+        std::cout << "Error: Total size must be a power of 2\n";
+        return;
+    }
+    
+    free_lists.clear();
+    allocated_blocks.clear();
+    total_memory = total_size;
+    used_memory = 0;
+    next_id = 1;
+    total_alloc_requests = 0;
+    failed_requests = 0;
+    internal_frag = 0;
+    op_clock = 0;
+    size_hist.reset();
+    lifetime_hist.reset();
+    sampler.close();
+    
+    // Add the entire memory as one free block
+    free_lists[total_size].push_back(0);
+    
+    if (verbose) {
+        std::cout << "Buddy allocator initialized: " << total_size << " bytes\n";
+    }
+}
+
+size_t BuddyAllocator::getBuddyAddress(size_t address, size_t size) const {
+    return address ^ size;
+}
+
+void BuddyAllocator::splitBlock(size_t address, size_t current_size, size_t target_size) {
+    [[maybe_unused]] size_t splits = 0;
+    while (current_size > target_size) {
+        current_size /= 2;
+        size_t buddy_addr = address + current_size;
+        free_lists[current_size].push_back(buddy_addr);
+        splits++;
+    }
+    MEMSIM_PROBE(PROBE_BUDDY_SPLITS, splits);
+}
+
+int BuddyAllocator::allocate(size_t size) {
+    total_alloc_requests++;
+    beginOperation();
+    
+    if (size == 0) {
+        if (verbose) std::cout << "Error: Cannot allocate 0 bytes\n";
+        failed_requests++;
+        return -1;
+    }
+    size_hist.record(size);
+    
+    // Round up to next power of two
+    size_t actual_size = nextPowerOfTwo(size);
+    
+    // Track internal fragmentation
+    internal_frag += (actual_size - size);
+    
+    // Find the smallest available block that fits
+    size_t block_size = actual_size;
+    while (block_size <= total_memory && free_lists[block_size].empty()) {
+        block_size *= 2;
+    }
+    
+    if (block_size > total_memory) {
+        if (verbose) std::cout << "Error: Allocation failed - not enough memory\n";
+        failed_requests++;
+        return -1;
+    }
+    
+    // Get a block of the found size
+    size_t address = free_lists[block_size].front();
+    free_lists[block_size].pop_front();
+    
+    // Split the block down to the required size
+    splitBlock(address, block_size, actual_size);
+    
+    // Allocate the block
+    int id = next_id++;
+    allocated_blocks[id] = BuddyBlock(address, actual_size, id, op_clock);
+    used_memory += actual_size;
+    
+    if (verbose) {
+        std::cout << "Allocated block id=" << id 
+                  << " at address=0x" << std::hex << std::setfill('0') 
+                  << std::setw(4) << address << std::dec 
+                  << " (requested: " << size << ", actual: " << actual_size << " bytes)\n";
+    }
+    
+    return id;
+}
+
+void BuddyAllocator::free(int block_id) {
+    beginOperation();
+    auto it = allocated_blocks.find(block_id);
+    if (it == allocated_blocks.end()) {
+        if (verbose) std::cout << "Error: Block " << block_id << " not found\n";
+        return;
+    }
+    
+    BuddyBlock block = it->second;
+    allocated_blocks.erase(it);
+    lifetime_hist.record(op_clock - block.alloc_time);
+    used_memory -= block.size;
+    
+    size_t address = block.address;
+    size_t size = block.size;
+    [[maybe_unused]] size_t merges = 0;
+    
+    // Try to merge with buddy repeatedly
+    while (size < total_memory) {
+        size_t buddy_addr = getBuddyAddress(address, size);
+        
+        // Check if buddy is free
+        auto& free_list = free_lists[size];
+        auto buddy_it = std::find(free_list.begin(), free_list.end(), buddy_addr);
+        
+        if (buddy_it != free_list.end()) {
+            // Buddy is free, merge
+            free_list.erase(buddy_it);
+            address = std::min(address, buddy_addr);
+            size *= 2;
+            merges++;
+        } else {
+            // Buddy is not free, stop merging
+            break;
+        }
+    }
+    
+    MEMSIM_PROBE(PROBE_BUDDY_MERGES, merges);
+    
+    // Add the merged block to free list
+    free_lists[size].push_back(address);
+    
+    if (verbose) {
+        std::cout << "Block " << block_id << " freed and merged\n";
+    }
+}
+
+size_t BuddyAllocator::getBlockAddress(int block_id) const {
+    auto it = allocated_blocks.find(block_id);
+    return it != allocated_blocks.end() ? it->second.address : SIZE_MAX;
+}
+
+size_t BuddyAllocator::getBlockSize(int block_id) const {
+    auto it = allocated_blocks.find(block_id);
+    return it != allocated_blocks.end() ? it->second.size : SIZE_MAX;
+}
+
+size_t BuddyAllocator::calculateExternalFragmentation() const {
+    size_t total_free = 0;
+    size_t largest_free = 0;
+    for (const auto& pair : free_lists) {
+        if (!pair.second.empty()) {
+            total_free += pair.first * pair.second.size();
+            largest_free = std::max(largest_free, pair.first);
+        }
+    }
+    if (total_free == 0) return 0;
+    
+    return ((total_free - largest_free) * 100) / total_free;
+}
+
+void BuddyAllocator::beginOperation() {
+    if (sampler.tick()) {
+        takeSample();
+    }
+    op_clock++;
+}
+
+bool BuddyAllocator::startSampling(const std::string& path, size_t interval) {
+    if (total_memory == 0) {
+        return false;
+    }
+    std::vector<std::string> columns = {"op", "utilization_pct", "external_fragmentation_pct"};
+    for (size_t size = 1, order = 0; size <= total_memory; size *= 2, order++) {
+        columns.push_back("order_" + std::to_string(order));
+    }
+    sample_row.assign(columns.size(), 0.0);
+    return sampler.open(path, columns, interval);
+}
+
+void BuddyAllocator::stopSampling() {
+    // Record the state at the end of the run before closing
+    if (sampler.isOpen()) {
+        takeSample();
+        sampler.close();
+    }
+}
+
+void BuddyAllocator::takeSample() {
+    sample_row[0] = (double)op_clock;
+    sample_row[1] = total_memory > 0 ? 100.0 * used_memory / total_memory : 0.0;
+    sample_row[2] = (double)calculateExternalFragmentation();
+    
+    size_t column = 3;
+    for (size_t size = 1; size <= total_memory; size *= 2) {
+        auto it = free_lists.find(size);
+        sample_row[column++] = it != free_lists.end() ? (double)it->second.size() : 0.0;
+    }
+    sampler.write(sample_row.data());
+}
+
+void BuddyAllocator::dump() const {
+    std::cout << "\n=== Buddy Allocator Memory Dump ===\n";
+    
+    // Show allocated blocks
+    std::cout << "Allocated blocks:\n";
+    for (const auto& pair : allocated_blocks) {
+        const BuddyBlock& block = pair.second;
+        std::cout << "  [0x" << std::hex << std::setfill('0') << std::setw(4) 
+                  << block.address << " - 0x" << std::setw(4) 
+                  << (block.address + block.size - 1) << std::dec 
+                  << "] USED (id=" << block.id << ", " << block.size << " bytes)\n";
+    }
+    
+    // Show free blocks
+    std::cout << "Free blocks:\n";
+    for (const auto& pair : free_lists) {
+        size_t size = pair.first;
+        const auto& list = pair.second;
+        for (size_t addr : list) {
+            std::cout << "  [0x" << std::hex << std::setfill('0') << std::setw(4) 
+                      << addr << " - 0x" << std::setw(4) 
+                      << (addr + size - 1) << std::dec 
+                      << "] FREE (" << size << " bytes)\n";
+        }
+    }
+    std::cout << "===================================\n\n";
+}
+
+void BuddyAllocator::stats() const {
+    std::cout << "\n=== Buddy Allocator Statistics ===\n";
+    std::cout << "Total memory: " << total_memory << " bytes\n";
+    std::cout << "Used memory: " << used_memory << " bytes\n";
+    std::cout << "Free memory: " << (total_memory - used_memory) << " bytes\n";
+    std::cout << "Memory utilization: " 
+              << (total_memory > 0 ? (used_memory * 100) / total_memory : 0) << "%\n";
+    std::cout << "Internal fragmentation: " << internal_frag << " bytes\n";
+    std::cout << "External fragmentation: " << calculateExternalFragmentation() << "%\n";
+    std::cout << "Allocation requests: " << total_alloc_requests << "\n";
+    std::cout << "Failed requests: " << failed_requests << "\n";
+    std::cout << "Success rate: " 
+              << (total_alloc_requests > 0 ? 
+                  ((total_alloc_requests - failed_requests) * 100) / total_alloc_requests : 0)
+              << "%\n";
+    size_hist.print("Allocation size", "bytes");
+    lifetime_hist.print("Block lifetime", "ops");
+    std::cout << "==================================\n\n";
+}
+
+void BuddyAllocator::writeStatsJson(std::ostream& out) const {
+    out << "{\"total_memory\": " << total_memory << ", \"used_memory\": " << used_memory
+        << ", \"allocation_requests\": " << total_alloc_requests
+        << ", \"failed_requests\": " << failed_requests
+        << ", \"internal_fragmentation\": " << internal_frag
+        << ", \"external_fragmentation_pct\": " << calculateExternalFragmentation()
+        << ",\n    \"allocation_size\": ";
+    size_hist.writeJson(out);
+    out << ",\n    \"block_lifetime\": ";
+    lifetime_hist.writeJson(out);
+    out << "}";
+}
+
+bool BuddyAllocator::save(const std::string& path) const {
+    SnapshotWriter out(path, SNAPSHOT_BUDDY_ALLOCATOR);
+    out.put(total_memory);
+    out.put(used_memory);
+    out.put(next_id);
+    out.put(total_alloc_requests);
+    out.put(failed_requests);
+    out.put(internal_frag);
+    out.put(op_clock);
+    
+    // Each free list: block size, length, then addresses in list order
+    size_t lists = 0;
+    for (const auto& pair : free_lists) {
+        if (!pair.second.empty()) lists++;
+    }
+    out.put(lists);
+    for (const auto& pair : free_lists) {
+        if (pair.second.empty()) continue;
+        out.put(pair.first);
+        out.put(pair.second.size());
+        std::vector<uint64_t> addresses(pair.second.begin(), pair.second.end());
+        out.putArray(addresses.data(), addresses.size());
+    }
+    
+    // Allocated blocks as BuddyBlock records, in id order. The records are
+    // zeroed first so the padding after id is written as zeros.
+    std::vector<BuddyBlock> records(allocated_blocks.size());
+    if (!records.empty()) {
+        std::memset(static_cast<void*>(records.data()), 0, records.size() * sizeof(BuddyBlock));
+    }
+    size_t i = 0;
+    for (const auto& pair : allocated_blocks) {
+        records[i].address = pair.second.address;
+        records[i].size = pair.second.size;
+        records[i].id = pair.second.id;
+        records[i].alloc_time = pair.second.alloc_time;
+        i++;
+    }
+    out.putRecords(records.data(), records.size());
+    
+    size_hist.save(out);
+    lifetime_hist.save(out);
+    
+    if (!out.ok()) {
+        std::cout << "Error: Cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool BuddyAllocator::load(const std::string& path) {
+    SnapshotReader in(path, SNAPSHOT_BUDDY_ALLOCATOR);
+    const uint64_t* header = in.getArray(7);
+    
+    std::map<size_t, std::list<size_t>> lists;
+    uint64_t num_lists = 0;
+    size_t free_bytes = 0;
+    in.get(num_lists);
+    for (uint64_t i = 0; i < num_lists && in.ok(); i++) {
+        uint64_t size = 0, length = 0;
+        in.get(size);
+        in.get(length);
+        const uint64_t* addresses = in.getRecords(length, 1);
+        if (addresses) {
+            lists[size].assign(addresses, addresses + length);
+            free_bytes += size * length;
+        }
+    }
+    
+    std::vector<BuddyBlock> records;
+    std::map<int, BuddyBlock> blocks;
+    size_t allocated_bytes = 0;
+    bool have_blocks = in.getRecords(records);
+    for (const BuddyBlock& block : records) {
+        blocks[block.id] = block;
+        allocated_bytes += block.size;
+    }
+    
+    Histogram sizes, lifetimes;
+    if (!header || !have_blocks || !sizes.load(in) || !lifetimes.load(in)) {
+        std::cout << "Error: " << in.error() << "\n";
+        return false;
+    }
+    if (!isPowerOfTwo(header[0]) || free_bytes + allocated_bytes != header[0] ||
+        allocated_bytes != header[1]) {
+        std::cout << "Error: " << path << " does not account for all of memory\n";
+        return false;
+    }
+    
+    sampler.close();
+    total_memory = header[0];
+    used_memory = header[1];
+    next_id = (int)header[2];
+    total_alloc_requests = header[3];
+    failed_requests = header[4];
+    internal_frag = header[5];
+    op_clock = header[6];
+    free_lists.swap(lists);
+    allocated_blocks.swap(blocks);
+    size_hist = sizes;
+    lifetime_hist = lifetimes;
+    return true;
 }
\ No newline at end of file
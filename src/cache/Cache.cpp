@@ -1,131 +1,429 @@
-#include "Cache.h"
-#include <iostream>
-#include <iomanip>
-
-Cache::Cache(const std::string& name, size_t cache_size, size_t block_size, 
-             size_t associativity, ReplacementPolicy policy)
-    : name(name), cache_size(cache_size), block_size(block_size),
-      associativity(associativity), policy(policy),
-      hits(0), misses(0), time_counter(0) {
-    
-    // Calculate number of sets
-    size_t total_lines = cache_size / block_size;
-    num_sets = total_lines / associativity;
-    
-    // Initialize sets
-    sets.resize(num_sets);
-    for (auto& set : sets) {
-        set.resize(associativity);
-    }
-    
-    std::cout << name << " initialized: " << cache_size << " bytes, "
-              << block_size << " byte blocks, " 
-              << associativity << "-way associative, "
-              << num_sets << " sets\n";
-}
-
-size_t Cache::getSetIndex(size_t address) const {
-    size_t block_number = address / block_size;
-    return block_number % num_sets;
-}
-
-size_t Cache::getTag(size_t address) const {
-    size_t block_number = address / block_size;
-    return block_number / num_sets;
-}
-
-int Cache::findLine(size_t set_index, size_t tag) const {
-    for (size_t i = 0; i < associativity; i++) {
-        if (sets[set_index][i].valid && sets[set_index][i].tag == tag) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int Cache::findVictim(size_t set_index) {
-    // First, try to find an invalid line
-    for (size_t i = 0; i < associativity; i++) {
-        if (!sets[set_index][i].valid) {
-            return i;
-        }
-    }
-    
-    // All lines are valid, use replacement policy
-    if (policy == FIFO || policy == LRU) {
-        // Find line with smallest timestamp
-        size_t victim = 0;
-        size_t min_time = sets[set_index][0].timestamp;
-        
-        for (size_t i = 1; i < associativity; i++) {
-            if (sets[set_index][i].timestamp < min_time) {
-                min_time = sets[set_index][i].timestamp;
-                victim = i;
-            }
-        }
-        return victim;
-    }
-    
-    return 0;
-}
-
-bool Cache::access(size_t address) {
-    time_counter++;
-    
-    size_t set_index = getSetIndex(address);
-    size_t tag = getTag(address);
-    
-    // Check for hit
-    int line_index = findLine(set_index, tag);
-    if (line_index != -1) {
-        // Cache hit
-        hits++;
-        
-        // Update timestamp for LRU
-        if (policy == LRU) {
-            sets[set_index][line_index].timestamp = time_counter;
-        }
-        
-        return true;
-    }
-    
-    // Cache miss
-    misses++;
-    
-    // Find victim and replace
-    int victim = findVictim(set_index);
-    sets[set_index][victim].valid = true;
-    sets[set_index][victim].tag = tag;
-    sets[set_index][victim].timestamp = time_counter;
-    
-    return false;
-}
-
-void Cache::reset() {
-    hits = 0;
-    misses = 0;
-    time_counter = 0;
-    
-    for (auto& set : sets) {
-        for (auto& line : set) {
-            line.valid = false;
-            line.tag = 0;
-            line.timestamp = 0;
-        }
-    }
-}
-
-void Cache::stats() const {
-    size_t total_accesses = hits + misses;
-    double hit_ratio = total_accesses > 0 ? (double)hits / total_accesses * 100.0 : 0.0;
-    
-    std::cout << "\n=== " << name << " Statistics ===\n";
-    std::cout << "Total accesses: " << total_accesses << "\n";
-    std::cout << "Hits: " << hits << "\n";
-    std::cout << "Misses: " << misses << "\n";
-    std::cout << "Hit ratio: " << std::fixed << std::setprecision(2) 
-              << hit_ratio << "%\n";
-    std::cout << "Miss ratio: " << std::fixed << std::setprecision(2) 
-              << (100.0 - hit_ratio) << "%\n";
-    std::cout << "============================\n\n";
+#include "Cache.h"
+#include "ReplacementState.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+static const unsigned PSEL_MAX = 1023;
+static const unsigned PSEL_INIT = 512;
+static const uint64_t RNG_SEED = 0x9E3779B97F4A7C15ULL;
+
+const char* policyName(ReplacementPolicy policy) {
+    switch (policy) {
+        case FIFO: return "FIFO";
+        case LRU: return "LRU";
+        case TREE_PLRU: return "Tree-PLRU";
+        case SRRIP: return "SRRIP";
+        case BRRIP: return "BRRIP";
+        case DRRIP: return "DRRIP";
+        case RANDOM_REPLACEMENT: return "Random";
+    }
+    return "Unknown";
+}
+
+CacheBase::CacheBase(const std::string& name, size_t cache_size, size_t block_size,
+                     size_t associativity, ReplacementPolicy policy, bool announce)
+    : name(name), cache_size(cache_size), block_size(block_size),
+      associativity(associativity), policy(policy), hits(0), misses(0),
+      last_evicted(SIZE_MAX), window_hits(0), window_misses(0) {
+    
+    // Calculate number of sets
+    size_t total_lines = cache_size / block_size;
+    num_sets = total_lines / associativity;
+    
+    if (announce) {
+        std::cout << name << " initialized: " << cache_size << " bytes, "
+                  << block_size << " byte blocks, " 
+                  << associativity << "-way associative, "
+                  << num_sets << " sets\n";
+    }
+}
+
+Cache::Cache(const std::string& name, size_t cache_size, size_t block_size, 
+             size_t associativity, ReplacementPolicy policy, bool announce)
+    : CacheBase(name, cache_size, block_size, associativity, policy, announce),
+      epoch(0), time_counter(0), stamp_base(0), psel(PSEL_INIT), rng_state(RNG_SEED) {
+    
+    // The packed per-set policies only fit so many ways
+    bool pow2 = associativity > 0 && (associativity & (associativity - 1)) == 0;
+    if ((policy == TREE_PLRU && (!pow2 || associativity > 64)) ||
+        (isRrip() && associativity > 32)) {
+        std::cout << "Note: " << policyName(policy) << " does not support "
+                  << associativity << " ways, using LRU\n";
+        this->policy = LRU;
+    }
+    
+    lines.resize(num_sets * associativity);
+    set_bits.assign(num_sets, 0);
+    set_epoch.assign(num_sets, 0);
+}
+
+size_t Cache::metadataBytes() const {
+    return lines.capacity() * sizeof(CacheLine) + set_bits.capacity() * sizeof(uint64_t) +
+           set_epoch.capacity() * sizeof(uint16_t);
+}
+
+void Cache::clearSet(size_t set_index) {
+    std::fill(lines.begin() + set_index * associativity,
+              lines.begin() + (set_index + 1) * associativity, CacheLine());
+    set_bits[set_index] = 0;
+    set_epoch[set_index] = epoch;
+}
+
+// Move the stamp base up so stamps stay within 31 bits. Lines untouched for
+// more than LINE_STAMP_KEEP accesses clamp to the new base and tie as the
+// oldest.
+void Cache::rebaseStamps() {
+    size_t shift = time_counter - stamp_base - LINE_STAMP_KEEP;
+    for (CacheLine& cache_line : lines) {
+        cache_line.timestamp = cache_line.timestamp > shift ? cache_line.timestamp - shift : 0;
+    }
+    stamp_base += shift;
+}
+
+size_t Cache::getSetIndex(size_t address) const {
+    size_t block_number = address / block_size;
+    return block_number % num_sets;
+}
+
+size_t Cache::getTag(size_t address) const {
+    size_t block_number = address / block_size;
+    return block_number / num_sets;
+}
+
+int Cache::findLine(size_t set_index, size_t tag) const {
+    for (size_t i = 0; i < associativity; i++) {
+        if (line(set_index, i).valid && line(set_index, i).tag == tag) {
+            MEMSIM_PROBE(PROBE_CACHE_WAYS, i + 1);
+            return i;
+        }
+    }
+    MEMSIM_PROBE(PROBE_CACHE_WAYS, associativity);
+    return -1;
+}
+
+Cache::DuelRole Cache::duelRole(size_t set_index) const {
+    // One SRRIP and one BRRIP leader in every group of up to 32 sets
+    size_t period = std::min<size_t>(32, num_sets);
+    size_t slot = set_index % period;
+    if (slot == 0) return SRRIP_LEADER;
+    if (slot == period - 1) return BRRIP_LEADER;
+    return FOLLOWER;
+}
+
+int Cache::findVictim(size_t set_index) {
+    // First, try to find an invalid line
+    for (size_t i = 0; i < associativity; i++) {
+        if (!line(set_index, i).valid) {
+            return i;
+        }
+    }
+    
+    // All lines are valid, use replacement policy
+    switch (policy) {
+        case FIFO:
+        case LRU: {
+            // Find line with smallest timestamp
+            size_t victim = 0;
+            uint32_t min_time = line(set_index, 0).timestamp;
+            
+            for (size_t i = 1; i < associativity; i++) {
+                if (line(set_index, i).timestamp < min_time) {
+                    min_time = line(set_index, i).timestamp;
+                    victim = i;
+                }
+            }
+            return victim;
+        }
+        case TREE_PLRU:
+            return plruVictim(set_bits[set_index], associativity);
+        case SRRIP:
+        case BRRIP:
+        case DRRIP:
+            return rripVictim(set_bits[set_index], associativity);
+        case RANDOM_REPLACEMENT:
+            return xorshift64(rng_state) % associativity;
+    }
+    
+    return 0;
+}
+
+// Update replacement state for a hit
+void Cache::touchLine(size_t set_index, size_t line_index) {
+    switch (policy) {
+        case LRU:
+            line(set_index, line_index).timestamp = stamp();
+            break;
+        case TREE_PLRU:
+            plruTouch(set_bits[set_index], line_index, associativity);
+            break;
+        case SRRIP:
+        case BRRIP:
+        case DRRIP:
+            rrpvSet(set_bits[set_index], line_index, 0);
+            break;
+        case FIFO:
+        case RANDOM_REPLACEMENT:
+            break;
+    }
+}
+
+// Update replacement state for a newly inserted line
+void Cache::fillLine(size_t set_index, size_t line_index) {
+    line(set_index, line_index).timestamp = stamp();
+    
+    bool bimodal = policy == BRRIP;
+    if (policy == DRRIP) {
+        // Misses in leader sets vote for the other policy
+        DuelRole role = duelRole(set_index);
+        if (role == SRRIP_LEADER && psel < PSEL_MAX) psel++;
+        if (role == BRRIP_LEADER && psel > 0) psel--;
+        bimodal = role == BRRIP_LEADER || (role == FOLLOWER && psel >= PSEL_INIT);
+    }
+    
+    switch (policy) {
+        case TREE_PLRU:
+            plruTouch(set_bits[set_index], line_index, associativity);
+            break;
+        case SRRIP:
+        case BRRIP:
+        case DRRIP: {
+            // Bimodal insertion predicts distant re-use except once in 32 fills
+            unsigned rrpv = RRPV_LONG;
+            if (bimodal && (xorshift64(rng_state) & 31) != 0) {
+                rrpv = RRPV_MAX;
+            }
+            rrpvSet(set_bits[set_index], line_index, rrpv);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool Cache::access(size_t address) {
+    beginAccess();
+    time_counter++;
+    if (time_counter - stamp_base > LINE_STAMP_MAX) {
+        rebaseStamps();
+    }
+    
+    reuse.access(address / block_size);
+    
+    size_t set_index = getSetIndex(address);
+    size_t tag = getTag(address);
+    if (isStale(set_index)) {
+        clearSet(set_index);
+    }
+    
+    // Check for hit
+    int line_index = findLine(set_index, tag);
+    if (line_index != -1) {
+        // Cache hit
+        hits++;
+        touchLine(set_index, line_index);
+        return true;
+    }
+    
+    // Cache miss
+    misses++;
+    
+    // Find victim and replace
+    int victim = findVictim(set_index);
+    const CacheLine& old = line(set_index, victim);
+    last_evicted = old.valid ? (old.tag * num_sets + set_index) * block_size : SIZE_MAX;
+    line(set_index, victim).valid = true;
+    line(set_index, victim).tag = tag;
+    fillLine(set_index, victim);
+    
+    return false;
+}
+
+bool Cache::invalidate(size_t address) {
+    size_t set_index = getSetIndex(address);
+    if (isStale(set_index)) {
+        return false;
+    }
+    int line_index = findLine(set_index, getTag(address));
+    if (line_index == -1) {
+        return false;
+    }
+    // The way is refilled first; its replacement bits are rewritten on fill
+    line(set_index, line_index).valid = false;
+    return true;
+}
+
+void Cache::reset() {
+    resetCounters();
+    time_counter = 0;
+    stamp_base = 0;
+    psel = PSEL_INIT;
+    rng_state = RNG_SEED;
+    
+    // Only when the 16-bit epoch wraps are the lines cleared here
+    if (++epoch == 0) {
+        std::fill(lines.begin(), lines.end(), CacheLine());
+        std::fill(set_bits.begin(), set_bits.end(), 0);
+        std::fill(set_epoch.begin(), set_epoch.end(), 0);
+    }
+}
+
+void CacheBase::resetCounters() {
+    hits = 0;
+    misses = 0;
+    last_evicted = SIZE_MAX;
+    window_hits = 0;
+    window_misses = 0;
+    reuse.reset();
+}
+
+bool CacheBase::startSampling(const std::string& path, size_t interval) {
+    window_hits = hits;
+    window_misses = misses;
+    return sampler.open(path, {"access", "window_hit_ratio_pct", "hit_ratio_pct"}, interval);
+}
+
+void CacheBase::stopSampling() {
+    // Record the partial last window before closing
+    if (sampler.isOpen()) {
+        if (hits + misses > window_hits + window_misses) {
+            takeSample();
+        }
+        sampler.close();
+    }
+}
+
+void CacheBase::takeSample() {
+    size_t window_accesses = (hits - window_hits) + (misses - window_misses);
+    size_t total_accesses = hits + misses;
+    double row[] = {
+        (double)total_accesses,
+        window_accesses > 0 ? 100.0 * (hits - window_hits) / window_accesses : 0.0,
+        total_accesses > 0 ? 100.0 * hits / total_accesses : 0.0,
+    };
+    sampler.write(row);
+    window_hits = hits;
+    window_misses = misses;
+}
+
+bool CacheBase::save(const std::string& path) const {
+    SnapshotWriter out(path, SNAPSHOT_CACHE);
+    out.putString(name);
+    out.put(cache_size);
+    out.put(block_size);
+    out.put(associativity);
+    out.put(policy);
+    out.put(hits);
+    out.put(misses);
+    reuse.save(out);
+    saveLines(out);
+    
+    if (!out.ok()) {
+        std::cout << "Error: Cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool CacheBase::loadState(SnapshotReader& in) {
+    const uint64_t* counters = in.getArray(2);
+    ReuseDistance distances;
+    if (!counters || !distances.load(in) || !loadLines(in)) {
+        std::cout << "Error: " << in.error() << "\n";
+        return false;
+    }
+    hits = counters[0];
+    misses = counters[1];
+    window_hits = hits;
+    window_misses = misses;
+    reuse = distances;
+    return true;
+}
+
+bool CacheBase::checkGeometry(SnapshotReader& in, uint64_t sets, uint64_t ways) const {
+    uint64_t saved_sets = 0, saved_ways = 0;
+    in.get(saved_sets);
+    in.get(saved_ways);
+    if (in.ok() && (saved_sets != sets || saved_ways != ways)) {
+        in.fail("snapshot cache geometry does not match");
+    }
+    return in.ok();
+}
+
+void Cache::saveLines(SnapshotWriter& out) const {
+    out.put(time_counter);
+    out.put(psel);
+    out.put(rng_state);
+    out.put(stamp_base);
+    out.put(num_sets);
+    out.put(associativity);
+    
+    // Stale sets are written as empty ones
+    std::vector<uint64_t> bits(set_bits.begin(), set_bits.end());
+    std::vector<CacheLine> records(lines);
+    for (size_t set_index = 0; set_index < num_sets; set_index++) {
+        if (isStale(set_index)) {
+            bits[set_index] = 0;
+            std::fill(records.begin() + set_index * associativity,
+                      records.begin() + (set_index + 1) * associativity, CacheLine());
+        }
+    }
+    out.putArray(bits.data(), bits.size());
+    out.putRecords(records.data(), records.size());
+}
+
+bool Cache::loadLines(SnapshotReader& in) {
+    const uint64_t* state = in.getArray(4);
+    if (!state || !checkGeometry(in, num_sets, associativity)) {
+        return false;
+    }
+    const uint64_t* bits = in.getArray(num_sets);
+    std::vector<CacheLine> records;
+    if (!bits || !in.getRecords(records)) {
+        return false;
+    }
+    if (records.size() != lines.size() || state[3] > state[0] || state[0] - state[3] > LINE_STAMP_MAX) {
+        in.fail("snapshot cache lines are inconsistent");
+        return false;
+    }
+    
+    time_counter = state[0];
+    stamp_base = state[3];
+    psel = std::min<uint64_t>(state[1], PSEL_MAX);
+    rng_state = state[2] != 0 ? state[2] : RNG_SEED;  // xorshift must not start at 0
+    set_bits.assign(bits, bits + num_sets);
+    std::fill(set_epoch.begin(), set_epoch.end(), epoch);
+    lines.swap(records);
+    return true;
+}
+
+void CacheBase::stats() const {
+    size_t total_accesses = hits + misses;
+    double hit_ratio = total_accesses > 0 ? (double)hits / total_accesses * 100.0 : 0.0;
+    
+    std::cout << "\n=== " << name << " Statistics ===\n";
+    std::cout << "Replacement policy: " << policyName(policy) << "\n";
+    std::cout << "Total accesses: " << total_accesses << "\n";
+    std::cout << "Hits: " << hits << "\n";
+    std::cout << "Misses: " << misses << "\n";
+    std::cout << "Hit ratio: " << std::fixed << std::setprecision(2) 
+              << hit_ratio << "%\n";
+    std::cout << "Miss ratio: " << std::fixed << std::setprecision(2) 
+              << (100.0 - hit_ratio) << "%\n";
+    reuse.print("Reuse distance");
+    std::cout << "Metadata: " << metadataBytes() << " bytes ("
+              << (double)metadataBytes() / (num_sets * associativity) << " bytes per line)\n";
+    std::cout << "============================\n\n";
+}
+
+void CacheBase::writeStatsJson(std::ostream& out) const {
+    out << "{\"name\": \"" << name << "\", \"policy\": \"" << policyName(policy)
+        << "\", \"size\": " << cache_size << ", \"block_size\": " << block_size
+        << ", \"associativity\": " << associativity
+        << ", \"hits\": " << hits << ", \"misses\": " << misses
+        << ", \"metadata_bytes\": " << metadataBytes()
+        << ",\n    \"reuse_distance\": ";
+    reuse.writeJson(out);
+    out << "}";
 }
\ No newline at end of file
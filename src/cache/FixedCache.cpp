@@ -0,0 +1,64 @@
+#include "FixedCache.h"
+#include <iostream>
+
+static bool isPowerOfTwo(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+template <ReplacementPolicy Policy>
+static std::unique_ptr<CacheBase> makeFixed(const std::string& name, size_t cache_size,
+                                            size_t block_size, size_t associativity, bool announce) {
+    switch (associativity) {
+        case 1: return std::make_unique<FixedCache<1, Policy>>(name, cache_size, block_size, announce);
+        case 2: return std::make_unique<FixedCache<2, Policy>>(name, cache_size, block_size, announce);
+        case 4: return std::make_unique<FixedCache<4, Policy>>(name, cache_size, block_size, announce);
+        case 8: return std::make_unique<FixedCache<8, Policy>>(name, cache_size, block_size, announce);
+        case 16: return std::make_unique<FixedCache<16, Policy>>(name, cache_size, block_size, announce);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<CacheBase> makeCache(const std::string& name, size_t cache_size,
+                                     size_t block_size, size_t associativity,
+                                     ReplacementPolicy policy, bool announce) {
+    size_t num_sets = (block_size > 0 && associativity > 0)
+                      ? cache_size / block_size / associativity : 0;
+
+    if (isPowerOfTwo(block_size) && isPowerOfTwo(num_sets)) {
+        std::unique_ptr<CacheBase> fixed;
+        switch (policy) {
+            case FIFO: fixed = makeFixed<FIFO>(name, cache_size, block_size, associativity, announce); break;
+            case LRU: fixed = makeFixed<LRU>(name, cache_size, block_size, associativity, announce); break;
+            case TREE_PLRU:
+                fixed = makeFixed<TREE_PLRU>(name, cache_size, block_size, associativity, announce);
+                break;
+            default: break;
+        }
+        if (fixed) {
+            return fixed;
+        }
+    }
+    return std::make_unique<Cache>(name, cache_size, block_size, associativity, policy, announce);
+}
+
+std::unique_ptr<CacheBase> loadCache(const std::string& path) {
+    SnapshotReader in(path, SNAPSHOT_CACHE);
+    std::string name;
+    in.getString(name);
+    const uint64_t* geometry = in.getArray(4);
+    if (!geometry) {
+        std::cout << "Error: " << in.error() << "\n";
+        return nullptr;
+    }
+    if (geometry[1] == 0 || geometry[2] == 0 || geometry[3] > RANDOM_REPLACEMENT) {
+        std::cout << "Error: " << path << " has an invalid cache geometry\n";
+        return nullptr;
+    }
+
+    std::unique_ptr<CacheBase> cache = makeCache(name, geometry[0], geometry[1], geometry[2],
+                                                 (ReplacementPolicy)geometry[3]);
+    if (!cache->loadState(in)) {
+        return nullptr;
+    }
+    return cache;
+}
@@ -0,0 +1,236 @@
+#include "SampledCache.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+// Two-sided 95% quantile of the normal distribution
+static const double Z_95 = 1.96;
+
+// splitmix64 finalizer: spreads consecutive set indices over the sample
+static uint64_t mixSet(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+SampledCache::SampledCache(std::unique_ptr<CacheBase> cache)
+    : CacheBase(cache->getName(), cache->getSize(), cache->getBlockSize(),
+                cache->getAssociativity(), cache->getPolicy(), false),
+      inner(std::move(cache)), simulated(true), set_ratio(1),
+      sampled_set(num_sets, true), sampled_sets(num_sets), period(0), warmup(0),
+      measure(0) {
+    clear();
+}
+
+void SampledCache::setSetSampling(size_t ratio) {
+    // Take the num_sets / ratio sets with the smallest hashes, so the sample
+    // has an exact size but no stride that could alias with the trace
+    std::vector<size_t> order(num_sets);
+    for (size_t s = 0; s < num_sets; s++) order[s] = s;
+    std::sort(order.begin(), order.end(),
+              [](size_t a, size_t b) { return mixSet(a) < mixSet(b); });
+
+    set_ratio = ratio;
+    sampled_sets = std::max<size_t>(1, num_sets / ratio);
+    sampled_set.assign(num_sets, false);
+    for (size_t i = 0; i < sampled_sets; i++) {
+        sampled_set[order[i]] = true;
+    }
+    reset();
+    std::cout << name << ": simulating " << sampled_sets << " of " << num_sets
+              << " sets (1 in " << ratio << "), statistics reset\n";
+}
+
+void SampledCache::setTimeSampling(size_t new_period, size_t new_warmup, size_t new_measure) {
+    period = new_period;
+    warmup = new_warmup;
+    measure = new_measure;
+    reset();
+    if (period == 0) {
+        std::cout << name << ": time sampling off, statistics reset\n";
+    } else {
+        std::cout << name << ": every " << period << " accesses, simulating " << warmup
+                  << " to warm up and measuring the next " << measure << ", statistics reset\n";
+    }
+}
+
+std::unique_ptr<CacheBase> SampledCache::release() {
+    inner->reset();
+    return std::move(inner);
+}
+
+void SampledCache::clear() {
+    simulated = true;
+    phase = 0;
+    total_accesses = 0;
+    simulated_accesses = 0;
+    set_accesses.assign(num_sets, 0);
+    set_misses.assign(num_sets, 0);
+    interval_accesses = 0;
+    interval_misses = 0;
+    intervals = 0;
+    sum_a = sum_m = sum_aa = sum_mm = sum_am = 0;
+}
+
+void SampledCache::reset() {
+    resetCounters();
+    inner->reset();
+    clear();
+}
+
+bool SampledCache::access(size_t address) {
+    beginAccess();
+    total_accesses++;
+
+    // Position in the time-sampling period: warm-up, measured or skipped
+    bool measuring = true;
+    bool closing = false;
+    if (period > 0) {
+        size_t position = phase;
+        if (++phase == period) phase = 0;
+        if (position >= warmup + measure) {
+            simulated = false;
+            return false;
+        }
+        measuring = position >= warmup;
+        closing = position + 1 == warmup + measure;
+    }
+
+    size_t set_index = (address / block_size) % num_sets;
+    simulated = sampled_set[set_index];
+    bool hit = false;
+    if (simulated) {
+        simulated_accesses++;
+        hit = inner->access(address);
+        if (measuring) {
+            if (hit) hits++;
+            else misses++;
+            set_accesses[set_index]++;
+            set_misses[set_index] += !hit;
+            interval_accesses++;
+            interval_misses += !hit;
+        }
+    }
+    if (closing) {
+        closeInterval();
+    }
+    return hit;
+}
+
+size_t SampledCache::metadataBytes() const {
+    return inner->metadataBytes() + sampled_set.capacity() / 8 +
+           (set_accesses.capacity() + set_misses.capacity()) * sizeof(uint64_t);
+}
+
+void SampledCache::closeInterval() {
+    double a = (double)interval_accesses;
+    double m = (double)interval_misses;
+    intervals++;
+    sum_a += a;
+    sum_m += m;
+    sum_aa += a * a;
+    sum_mm += m * m;
+    sum_am += a * m;
+    interval_accesses = 0;
+    interval_misses = 0;
+}
+
+double SampledCache::missRatio() const {
+    return hits + misses > 0 ? (double)misses / (hits + misses) : 0.0;
+}
+
+double SampledCache::missRatioHalfWidth() const {
+    // Units are measurement intervals with time sampling, else sampled sets
+    double n, a, m, aa, mm, am;
+    double unsampled = 1.0;  // finite population correction
+    if (period > 0) {
+        n = intervals;
+        a = sum_a;
+        m = sum_m;
+        aa = sum_aa;
+        mm = sum_mm;
+        am = sum_am;
+    } else {
+        n = sampled_sets;
+        a = m = aa = mm = am = 0;
+        for (size_t s = 0; s < num_sets; s++) {
+            if (!sampled_set[s]) continue;
+            double sa = set_accesses[s], sm = set_misses[s];
+            a += sa;
+            m += sm;
+            aa += sa * sa;
+            mm += sm * sm;
+            am += sa * sm;
+        }
+        unsampled = 1.0 - n / num_sets;
+    }
+    if (n < 2 || a == 0) {
+        return -1;
+    }
+
+    // Variance of the ratio estimator r = sum(m) / sum(a)
+    double r = m / a;
+    double spread = std::max(0.0, (mm - 2 * r * am + r * r * aa) / (n - 1));
+    double mean_a = a / n;
+    return Z_95 * std::sqrt(unsampled * spread / n) / mean_a;
+}
+
+void SampledCache::stats() const {
+    double ratio = missRatio();
+    double half = missRatioHalfWidth();
+    size_t units = period > 0 ? intervals : sampled_sets;
+
+    std::cout << "\n=== " << name << " Statistics (sampled) ===\n";
+    std::cout << "Replacement policy: " << policyName(policy) << "\n";
+    std::cout << "Set sampling: " << sampled_sets << " of " << num_sets << " sets (1 in "
+              << set_ratio << ")\n";
+    if (period > 0) {
+        std::cout << "Time sampling: " << warmup << " warm-up + " << measure
+                  << " measured accesses every " << period << "\n";
+    } else {
+        std::cout << "Time sampling: off\n";
+    }
+    std::cout << "Total accesses: " << total_accesses << "\n";
+    std::cout << "Simulated: " << simulated_accesses << " (" << std::fixed << std::setprecision(2)
+              << (total_accesses > 0 ? 100.0 * simulated_accesses / total_accesses : 0.0)
+              << "%), measured: " << hits + misses << "\n";
+    std::cout << "Measured hits: " << hits << ", misses: " << misses << "\n";
+    if (half >= 0) {
+        std::cout << "Miss ratio: " << 100.0 * ratio << "% +/- " << 100.0 * half
+                  << "% (95% confidence over " << units << (period > 0 ? " intervals" : " sets") << ")\n";
+        std::cout << "Hit ratio: " << 100.0 * (1.0 - ratio) << "% +/- " << 100.0 * half << "%\n";
+        std::cout << "Estimated misses: " << std::setprecision(0) << ratio * total_accesses
+                  << " +/- " << half * total_accesses << std::setprecision(2) << "\n";
+    } else {
+        std::cout << "Miss ratio: " << 100.0 * ratio << "% (too few units for a confidence interval)\n";
+    }
+    std::cout << "============================\n\n";
+}
+
+void SampledCache::writeStatsJson(std::ostream& out) const {
+    double half = missRatioHalfWidth();
+    out << "{\"name\": \"" << name << "\", \"policy\": \"" << policyName(policy)
+        << "\", \"size\": " << cache_size << ", \"block_size\": " << block_size
+        << ", \"associativity\": " << associativity
+        << ",\n    \"sampling\": {\"set_ratio\": " << set_ratio << ", \"sampled_sets\": "
+        << sampled_sets << ", \"sets\": " << num_sets << ", \"period\": " << period
+        << ", \"warmup\": " << warmup << ", \"measure\": " << measure << "}"
+        << ",\n    \"accesses\": " << total_accesses << ", \"simulated\": " << simulated_accesses
+        << ", \"measured_hits\": " << hits << ", \"measured_misses\": " << misses
+        << ", \"miss_ratio\": " << missRatio() << ", \"miss_ratio_ci95\": ";
+    if (half >= 0) {
+        out << half;
+    } else {
+        out << "null";
+    }
+    out << ", \"units\": " << (period > 0 ? intervals : sampled_sets) << "}";
+}
+
+bool SampledCache::save(const std::string&) const {
+    std::cout << "Error: Snapshots of a sampled cache are not supported (set sampling off first)\n";
+    return false;
+}
@@ -0,0 +1,491 @@
+#include "Coherence.h"
+#include "FixedCache.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+const char* lineStateName(LineState state) {
+    switch (state) {
+        case STATE_I: return "I";
+        case STATE_S: return "S";
+        case STATE_E: return "E";
+        case STATE_O: return "O";
+        case STATE_M: return "M";
+    }
+    return "?";
+}
+
+static uint64_t coreBit(size_t core) {
+    return uint64_t(1) << core;
+}
+
+CoherenceSimulator::CoherenceSimulator(size_t num_cores, size_t cache_size, size_t block_size,
+                                       size_t associativity, ReplacementPolicy policy)
+    : protocol(MESI), interconnect(SNOOPING_BUS), block_size(block_size),
+      word_size(std::max<size_t>(8, block_size / 64)), accesses(0), cache_transfers(0),
+      memory_fetches(0), writebacks(0), bus_transactions(0), snoop_lookups(0), messages(0),
+      sample_accesses(0), sample_misses(0), sample_coherence(0), sample_traffic(0) {
+
+    for (size_t i = 0; i < num_cores; i++) {
+        caches.push_back(makeCache("Core" + std::to_string(i), cache_size, block_size,
+                                   associativity, policy));
+    }
+    cores.assign(num_cores, CoreStats());
+
+    std::cout << "Coherence simulator initialized: " << num_cores << " cores, MESI over a snooping bus\n";
+}
+
+void CoherenceSimulator::setProtocol(CoherenceProtocol new_protocol) {
+    protocol = new_protocol;
+    reset();
+    std::cout << "Protocol set to " << (protocol == MESI ? "MESI" : "MOESI") << ", caches reset\n";
+}
+
+void CoherenceSimulator::setInterconnect(Interconnect new_interconnect) {
+    interconnect = new_interconnect;
+    reset();
+    std::cout << "Interconnect set to " << (interconnect == SNOOPING_BUS ? "snooping bus" : "directory")
+              << ", caches reset\n";
+}
+
+bool CoherenceSimulator::setSharedLevel(size_t size, size_t associativity) {
+    if (size == 0) {
+        shared.reset();
+        std::cout << "Shared level removed\n";
+        return true;
+    }
+    if (associativity == 0 || size < block_size * associativity) {
+        std::cout << "Error: Shared level needs at least " << associativity << " blocks of "
+                  << block_size << " bytes\n";
+        return false;
+    }
+    shared = makeCache("Shared", size, block_size, associativity, caches[0]->getPolicy());
+    return true;
+}
+
+CoherenceEntry& CoherenceSimulator::entryFor(size_t block) {
+    return blocks[block];
+}
+
+LineState CoherenceSimulator::stateIn(const CoherenceEntry& entry, size_t core) const {
+    if (entry.owner == (int)core) return entry.owner_state;
+    if (entry.sharers & coreBit(core)) return STATE_S;
+    return STATE_I;
+}
+
+LineState CoherenceSimulator::stateOf(size_t core, size_t address) const {
+    auto it = blocks.find(address / block_size * block_size);
+    return it == blocks.end() ? STATE_I : stateIn(it->second, core);
+}
+
+void CoherenceSimulator::countRequest(size_t contacted, bool needs_data, bool owner_supplies) {
+    if (interconnect == SNOOPING_BUS) {
+        // One broadcast, looked up in every other cache's tags
+        bus_transactions++;
+        snoop_lookups += caches.size() - 1;
+        return;
+    }
+    // Request to the home node, then an invalidation or forward to each
+    // holder and its reply. The owner's reply carries the data; otherwise
+    // the home sends the data, or a grant for an upgrade.
+    messages += 1 + 2 * contacted;
+    if (!needs_data || !owner_supplies) {
+        messages++;
+    }
+}
+
+void CoherenceSimulator::countWriteback(size_t core) {
+    cores[core].writebacks++;
+    writebacks++;
+    if (interconnect == SNOOPING_BUS) {
+        bus_transactions++;
+    } else {
+        messages++;
+    }
+}
+
+void CoherenceSimulator::evict(size_t core, size_t block) {
+    CoherenceEntry& entry = entryFor(block);
+    entry.sharers &= ~coreBit(core);
+    if (entry.owner == (int)core) {
+        if (entry.owner_state == STATE_M || entry.owner_state == STATE_O) {
+            countWriteback(core);
+        } else if (interconnect == DIRECTORY) {
+            messages++;  // eviction notice keeps the sharer list exact
+        }
+        // Sharers of an Owned line keep their copies as S
+        entry.owner = -1;
+        entry.owner_state = STATE_I;
+    } else if (interconnect == DIRECTORY) {
+        messages++;
+    }
+}
+
+void CoherenceSimulator::invalidateOthers(size_t core, size_t address, CoherenceEntry& entry) {
+    uint64_t others = entry.sharers & ~coreBit(core);
+    if (others && entry.written.empty()) {
+        entry.written.assign(caches.size(), 0);
+    }
+    for (size_t k = 0; others; k++, others >>= 1) {
+        if (!(others & 1)) continue;
+        caches[k]->invalidate(address);
+        cores[k].invalidations++;
+        entry.invalidations++;
+        entry.lost |= coreBit(k);
+        entry.written[k] = 0;
+    }
+    entry.sharers &= coreBit(core);
+}
+
+void CoherenceSimulator::classifyMiss(size_t core, size_t address, CoherenceEntry& entry) {
+    uint64_t bit = coreBit(core);
+    CoreStats& stats = cores[core];
+    if (entry.lost & bit) {
+        // Coherence miss: true sharing if another core wrote this word
+        // since the copy was invalidated, false sharing otherwise
+        uint64_t word = uint64_t(1) << (address % block_size / word_size);
+        if (entry.written[core] & word) {
+            stats.true_sharing_misses++;
+            entry.true_sharing++;
+        } else {
+            stats.false_sharing_misses++;
+            entry.false_sharing++;
+        }
+        entry.lost &= ~bit;
+    }
+    else if (entry.seen & bit) {
+        stats.replacement_misses++;
+    }
+    else {
+        stats.cold_misses++;
+    }
+    entry.seen |= bit;
+}
+
+void CoherenceSimulator::fetch(size_t core, size_t address, CoherenceEntry& entry, bool write) {
+    int owner = entry.owner;
+    if (owner >= 0) {
+        cache_transfers++;
+    } else {
+        memory_fetches++;
+        if (shared) shared->access(address);
+    }
+
+    if (write) {
+        // Read-for-ownership: the owner's dirty data moves with ownership
+        size_t holders = __builtin_popcountll(entry.sharers);
+        invalidateOthers(core, address, entry);
+        countRequest(holders, true, owner >= 0);
+        entry.sharers = coreBit(core);
+        entry.owner = core;
+        entry.owner_state = STATE_M;
+        return;
+    }
+
+    if (owner >= 0) {
+        if (entry.owner_state == STATE_M && protocol == MOESI) {
+            entry.owner_state = STATE_O;
+        } else if (entry.owner_state != STATE_O) {
+            if (entry.owner_state == STATE_M) {
+                countWriteback(owner);  // MESI: the line goes back to memory as it is shared
+            }
+            entry.owner = -1;
+            entry.owner_state = STATE_I;
+        }
+    }
+    countRequest(owner >= 0 ? 1 : 0, true, owner >= 0);
+
+    if (entry.sharers == 0) {
+        entry.owner = core;
+        entry.owner_state = STATE_E;
+    }
+    entry.sharers |= coreBit(core);
+}
+
+bool CoherenceSimulator::access(size_t core, size_t address, bool write) {
+    if (sampler.tick()) {
+        takeSample();
+    }
+    accesses++;
+    CoreStats& stats = cores[core];
+    if (write) stats.writes++;
+    else stats.reads++;
+
+    bool hit = caches[core]->access(address);
+    if (!hit) {
+        size_t victim = caches[core]->lastEvicted();
+        if (victim != SIZE_MAX) {
+            evict(core, victim);
+        }
+    }
+
+    CoherenceEntry& entry = entryFor(address / block_size * block_size);
+    uint64_t bit = coreBit(core);
+    if (hit) {
+        stats.hits++;
+        LineState state = stateIn(entry, core);
+        if (write && state == STATE_E) {
+            entry.owner_state = STATE_M;  // silent upgrade
+        } else if (write && (state == STATE_S || state == STATE_O)) {
+            size_t holders = __builtin_popcountll(entry.sharers & ~bit);
+            invalidateOthers(core, address, entry);
+            countRequest(holders, false, false);
+            stats.upgrades++;
+            entry.upgrades++;
+            entry.owner = core;
+            entry.owner_state = STATE_M;
+        }
+    } else {
+        classifyMiss(core, address, entry);
+        fetch(core, address, entry, write);
+    }
+
+    if (write) {
+        uint64_t word = uint64_t(1) << (address % block_size / word_size);
+        entry.writers |= bit;
+        entry.words_written |= word;
+        // Cores that lost the block see this word as changed
+        uint64_t lost = entry.lost;
+        for (size_t k = 0; lost; k++, lost >>= 1) {
+            if (lost & 1) entry.written[k] |= word;
+        }
+    } else {
+        entry.readers |= bit;
+    }
+    return hit;
+}
+
+void CoherenceSimulator::reset() {
+    for (auto& cache : caches) {
+        cache->reset();
+    }
+    if (shared) shared->reset();
+    blocks.clear();
+    cores.assign(caches.size(), CoreStats());
+    accesses = 0;
+    cache_transfers = 0;
+    memory_fetches = 0;
+    writebacks = 0;
+    bus_transactions = 0;
+    snoop_lookups = 0;
+    messages = 0;
+    sample_accesses = 0;
+    sample_misses = 0;
+    sample_coherence = 0;
+    sample_traffic = 0;
+}
+
+size_t CoherenceSimulator::totalMisses() const {
+    size_t misses = 0;
+    for (const CoreStats& core : cores) {
+        misses += core.cold_misses + core.replacement_misses + core.true_sharing_misses +
+                  core.false_sharing_misses;
+    }
+    return misses;
+}
+
+size_t CoherenceSimulator::coherenceMisses() const {
+    size_t misses = 0;
+    for (const CoreStats& core : cores) {
+        misses += core.true_sharing_misses + core.false_sharing_misses;
+    }
+    return misses;
+}
+
+bool CoherenceSimulator::startSampling(const std::string& path, size_t interval) {
+    sample_accesses = accesses;
+    sample_misses = totalMisses();
+    sample_coherence = coherenceMisses();
+    sample_traffic = traffic();
+    return sampler.open(path, {"access", "misses_per_1k", "coherence_misses_per_1k",
+                               "traffic_per_access"}, interval);
+}
+
+void CoherenceSimulator::stopSampling() {
+    if (sampler.isOpen()) {
+        if (accesses > sample_accesses) {
+            takeSample();
+        }
+        sampler.close();
+    }
+}
+
+void CoherenceSimulator::takeSample() {
+    size_t window = accesses - sample_accesses;
+    size_t misses = totalMisses();
+    size_t coherence = coherenceMisses();
+    size_t sent = traffic();
+    double row[] = {
+        (double)accesses,
+        window > 0 ? 1000.0 * (misses - sample_misses) / window : 0.0,
+        window > 0 ? 1000.0 * (coherence - sample_coherence) / window : 0.0,
+        window > 0 ? (double)(sent - sample_traffic) / window : 0.0,
+    };
+    sampler.write(row);
+    sample_accesses = accesses;
+    sample_misses = misses;
+    sample_coherence = coherence;
+    sample_traffic = sent;
+}
+
+// Blocks with any sharing activity, most false-sharing misses first
+static std::vector<std::pair<size_t, const CoherenceEntry*>>
+hotLines(const std::unordered_map<size_t, CoherenceEntry>& blocks, size_t limit) {
+    std::vector<std::pair<size_t, const CoherenceEntry*>> lines;
+    for (const auto& kv : blocks) {
+        const CoherenceEntry& entry = kv.second;
+        if (entry.invalidations + entry.upgrades + entry.false_sharing + entry.true_sharing > 0) {
+            lines.emplace_back(kv.first, &entry);
+        }
+    }
+    auto hotter = [](const std::pair<size_t, const CoherenceEntry*>& a,
+                     const std::pair<size_t, const CoherenceEntry*>& b) {
+        if (a.second->false_sharing != b.second->false_sharing) {
+            return a.second->false_sharing > b.second->false_sharing;
+        }
+        if (a.second->invalidations != b.second->invalidations) {
+            return a.second->invalidations > b.second->invalidations;
+        }
+        return a.first < b.first;
+    };
+    size_t shown = std::min(limit, lines.size());
+    std::partial_sort(lines.begin(), lines.begin() + shown, lines.end(), hotter);
+    lines.resize(shown);
+    return lines;
+}
+
+void CoherenceSimulator::stats() const {
+    size_t hits = 0, cold = 0, replacement = 0, true_sharing = 0, false_sharing = 0;
+    size_t upgrades = 0, invalidations = 0;
+    for (const CoreStats& core : cores) {
+        hits += core.hits;
+        cold += core.cold_misses;
+        replacement += core.replacement_misses;
+        true_sharing += core.true_sharing_misses;
+        false_sharing += core.false_sharing_misses;
+        upgrades += core.upgrades;
+        invalidations += core.invalidations;
+    }
+    const CacheBase& first = *caches[0];
+
+    std::cout << "\n=== Coherence Statistics ===\n";
+    std::cout << "Protocol: " << (protocol == MESI ? "MESI" : "MOESI") << " over a "
+              << (interconnect == SNOOPING_BUS ? "snooping bus" : "directory") << "\n";
+    std::cout << "Cores: " << caches.size() << ", private caches of " << first.getSize() << " bytes, "
+              << block_size << " byte blocks, " << first.getAssociativity() << "-way "
+              << policyName(first.getPolicy()) << "\n";
+    std::cout << "False-sharing granularity: " << word_size << " byte words\n";
+    std::cout << "Total accesses: " << accesses << "\n";
+    std::cout << "Private hit ratio: " << std::fixed << std::setprecision(2)
+              << (accesses > 0 ? 100.0 * hits / accesses : 0.0) << "%\n";
+    std::cout << "Misses: " << accesses - hits << " (cold " << cold << ", replacement " << replacement
+              << ", true sharing " << true_sharing << ", false sharing " << false_sharing << ")\n";
+    std::cout << "Upgrades: " << upgrades << ", invalidations: " << invalidations
+              << ", writebacks: " << writebacks << "\n";
+    std::cout << "Misses served by another cache: " << cache_transfers
+              << ", by " << (shared ? "the shared level" : "memory") << ": " << memory_fetches << "\n";
+    if (shared) {
+        std::cout << "Shared level: " << shared->getSize() << " bytes, " << shared->getAssociativity()
+                  << "-way, hit ratio "
+                  << (memory_fetches > 0 ? 100.0 * shared->getHits() / memory_fetches : 0.0) << "%\n";
+    }
+    if (interconnect == SNOOPING_BUS) {
+        std::cout << "Bus transactions: " << bus_transactions << " ("
+                  << (accesses > 0 ? (double)bus_transactions / accesses : 0.0)
+                  << " per access), snoop lookups: " << snoop_lookups << "\n";
+    } else {
+        std::cout << "Directory messages: " << messages << " ("
+                  << (accesses > 0 ? (double)messages / accesses : 0.0) << " per access), "
+                  << blocks.size() << " directory entries\n";
+    }
+
+    std::cout << "\nCore     Reads    Writes    Hit%    Cold    Repl    True   False  Upgrades  Invals  Writebacks\n";
+    for (size_t i = 0; i < cores.size(); i++) {
+        const CoreStats& core = cores[i];
+        size_t total = core.reads + core.writes;
+        std::cout << std::setw(4) << i
+                  << std::setw(10) << core.reads
+                  << std::setw(10) << core.writes
+                  << std::setw(8) << (total > 0 ? 100.0 * core.hits / total : 0.0)
+                  << std::setw(8) << core.cold_misses
+                  << std::setw(8) << core.replacement_misses
+                  << std::setw(8) << core.true_sharing_misses
+                  << std::setw(8) << core.false_sharing_misses
+                  << std::setw(10) << core.upgrades
+                  << std::setw(8) << core.invalidations
+                  << std::setw(12) << core.writebacks << "\n";
+    }
+
+    std::vector<std::pair<size_t, const CoherenceEntry*>> lines = hotLines(blocks, HOT_LINES);
+    if (lines.empty()) {
+        std::cout << "\nNo invalidations or sharing misses\n";
+    } else {
+        std::cout << "\nHot lines (most false sharing first)\n";
+        std::cout << "Line address        Invals  Upgrades    True   False  Readers   Writers   Words written\n";
+        for (const auto& line : lines) {
+            const CoherenceEntry& entry = *line.second;
+            std::cout << "0x" << std::hex << std::setfill('0') << std::setw(16) << line.first
+                      << std::setfill(' ') << std::dec
+                      << std::setw(8) << entry.invalidations
+                      << std::setw(10) << entry.upgrades
+                      << std::setw(8) << entry.true_sharing
+                      << std::setw(8) << entry.false_sharing
+                      << std::hex << "  0x" << std::setfill('0') << std::setw(6) << entry.readers
+                      << "  0x" << std::setw(6) << entry.writers
+                      << "  0x" << std::setw(12) << entry.words_written
+                      << std::setfill(' ') << std::dec << "\n";
+        }
+        std::cout << "(readers, writers: bit per core; words written: bit per "
+                  << word_size << "-byte word of the line)\n";
+    }
+    std::cout << "============================\n\n";
+}
+
+void CoherenceSimulator::writeStatsJson(std::ostream& out) const {
+    size_t hits = 0;
+    for (const CoreStats& core : cores) {
+        hits += core.hits;
+    }
+
+    out << "{\"protocol\": \"" << (protocol == MESI ? "MESI" : "MOESI")
+        << "\", \"interconnect\": \"" << (interconnect == SNOOPING_BUS ? "snooping" : "directory")
+        << "\", \"cores\": " << caches.size() << ", \"cache_size\": " << caches[0]->getSize()
+        << ", \"block_size\": " << block_size << ", \"associativity\": " << caches[0]->getAssociativity()
+        << ", \"word_size\": " << word_size
+        << ",\n    \"accesses\": " << accesses << ", \"hits\": " << hits
+        << ", \"misses\": " << accesses - hits << ", \"writebacks\": " << writebacks
+        << ", \"cache_transfers\": " << cache_transfers << ", \"memory_fetches\": " << memory_fetches
+        << ", \"bus_transactions\": " << bus_transactions << ", \"snoop_lookups\": " << snoop_lookups
+        << ", \"messages\": " << messages << ", \"shared\": ";
+    if (shared) {
+        out << "{\"size\": " << shared->getSize() << ", \"associativity\": " << shared->getAssociativity()
+            << ", \"hits\": " << shared->getHits() << ", \"misses\": " << shared->getMisses() << "}";
+    } else {
+        out << "null";
+    }
+
+    out << ",\n    \"per_core\": [";
+    for (size_t i = 0; i < cores.size(); i++) {
+        const CoreStats& core = cores[i];
+        out << (i > 0 ? ",\n        " : "\n        ")
+            << "{\"core\": " << i << ", \"reads\": " << core.reads << ", \"writes\": " << core.writes
+            << ", \"hits\": " << core.hits << ", \"cold_misses\": " << core.cold_misses
+            << ", \"replacement_misses\": " << core.replacement_misses
+            << ", \"true_sharing_misses\": " << core.true_sharing_misses
+            << ", \"false_sharing_misses\": " << core.false_sharing_misses
+            << ", \"upgrades\": " << core.upgrades << ", \"invalidations\": " << core.invalidations
+            << ", \"writebacks\": " << core.writebacks << "}";
+    }
+
+    out << "],\n    \"hot_lines\": [";
+    std::vector<std::pair<size_t, const CoherenceEntry*>> lines = hotLines(blocks, HOT_LINES);
+    for (size_t i = 0; i < lines.size(); i++) {
+        const CoherenceEntry& entry = *lines[i].second;
+        out << (i > 0 ? ",\n        " : "\n        ")
+            << "{\"address\": " << lines[i].first << ", \"invalidations\": " << entry.invalidations
+            << ", \"upgrades\": " << entry.upgrades << ", \"true_sharing\": " << entry.true_sharing
+            << ", \"false_sharing\": " << entry.false_sharing << ", \"readers\": " << entry.readers
+            << ", \"writers\": " << entry.writers << ", \"words_written\": " << entry.words_written << "}";
+    }
+    out << "]}";
+}
@@ -0,0 +1,314 @@
+#include "CoSimulation.h"
+#include "FixedCache.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+const char* placementName(Placement placement) {
+    switch (placement) {
+        case PLACEMENT_FIRST_FIT: return "first fit";
+        case PLACEMENT_BEST_FIT: return "best fit";
+        case PLACEMENT_WORST_FIT: return "worst fit";
+        case PLACEMENT_NEXT_FIT: return "next fit";
+        case PLACEMENT_BUDDY: return "buddy";
+    }
+    return "unknown";
+}
+
+static const Placement ALL_PLACEMENTS[] = {PLACEMENT_FIRST_FIT, PLACEMENT_BEST_FIT, PLACEMENT_WORST_FIT,
+                                           PLACEMENT_NEXT_FIT, PLACEMENT_BUDDY};
+
+bool LruShadow::access(size_t block) {
+    auto it = where.find(block);
+    if (it != where.end()) {
+        order.splice(order.begin(), order, it->second);
+        return true;
+    }
+    if (order.size() == capacity) {
+        where.erase(order.back());
+        order.pop_back();
+    }
+    order.push_front(block);
+    where[block] = order.begin();
+    return false;
+}
+
+CoSimulator::CoSimulator(size_t memory_size, size_t cache_size, size_t block_size,
+                         size_t associativity, ReplacementPolicy policy)
+    : memory_size(memory_size), cache_size(cache_size), block_size(block_size),
+      associativity(associativity), policy(policy) {
+    live = newRun(PLACEMENT_FIRST_FIT);
+    std::cout << "Co-simulation initialized: " << memory_size << " bytes of memory, "
+              << cache_size << " byte " << associativity << "-way " << policyName(policy)
+              << " cache with " << block_size << " byte blocks, " << placementName(live->placement)
+              << " placement\n";
+}
+
+std::unique_ptr<PlacementRun> CoSimulator::newRun(Placement placement) const {
+    std::unique_ptr<PlacementRun> run = std::make_unique<PlacementRun>(cache_size / block_size);
+    run->placement = placement;
+    if (placement == PLACEMENT_BUDDY) {
+        run->buddy = std::make_unique<BuddyAllocator>();
+        run->buddy->setVerbose(false);
+        run->buddy->init(memory_size);
+    } else {
+        run->memory = std::make_unique<MemoryManager>();
+        run->memory->setVerbose(false);
+        run->memory->init(memory_size);
+        AllocStrategy strategy = placement == PLACEMENT_BEST_FIT ? BEST_FIT :
+                                 placement == PLACEMENT_WORST_FIT ? WORST_FIT :
+                                 placement == PLACEMENT_NEXT_FIT ? NEXT_FIT : FIRST_FIT;
+        run->memory->setStrategy(strategy);
+    }
+    run->cache = makeCache(placementName(placement), cache_size, block_size, associativity,
+                           policy, false);
+    return run;
+}
+
+void CoSimulator::apply(PlacementRun& run, const CoSimOp& op) const {
+    switch (op.type) {
+        case CoSimOp::ALLOC: {
+            int id = run.memory ? run.memory->malloc(op.bytes) : run.buddy->allocate(op.bytes);
+            run.allocations++;
+            run.block_of.push_back(id);
+            run.address_of.push_back(SIZE_MAX);
+            if (id == -1) {
+                run.failed_allocations++;
+                break;
+            }
+            size_t address = run.memory ? run.memory->getBlockAddress(id) : run.buddy->getBlockAddress(id);
+            run.address_of.back() = address;
+
+            // An object needs ceil(size / block) cache blocks at best
+            size_t spanned = (address + op.bytes - 1) / block_size - address / block_size + 1;
+            if (spanned > (op.bytes + block_size - 1) / block_size) {
+                run.split_objects++;
+            }
+            size_t used = run.memory ? run.memory->getUsedMemory() : run.buddy->getUsedMemory();
+            size_t fragmentation = run.memory ? run.memory->calculateExternalFragmentation()
+                                              : run.buddy->calculateExternalFragmentation();
+            run.peak_used = std::max(run.peak_used, used);
+            run.peak_fragmentation = std::max(run.peak_fragmentation, fragmentation);
+            break;
+        }
+        case CoSimOp::FREE: {
+            int& id = run.block_of[op.object - 1];
+            if (id != -1) {
+                if (run.memory) run.memory->free(id);
+                else run.buddy->free(id);
+                id = -1;
+            }
+            break;
+        }
+        case CoSimOp::TOUCH: {
+            size_t first = op.offset / block_size;
+            size_t last = (op.offset + op.bytes - 1) / block_size;
+            size_t base = run.address_of[op.object - 1];
+            if (base == SIZE_MAX) {
+                run.skipped_accesses += last - first + 1;
+                break;
+            }
+            // One access per cache block the byte range covers
+            size_t start = base + op.offset;
+            size_t end = start + op.bytes - 1;
+            for (size_t block = start / block_size; block <= end / block_size; block++) {
+                run.accesses++;
+                bool hit = run.cache->access(block * block_size);
+                bool shadow_hit = run.shadow.access(block);
+                if (hit) {
+                    run.hits++;
+                } else if (run.seen_blocks.insert(block).second) {
+                    run.cold_misses++;
+                } else if (!shadow_hit) {
+                    run.capacity_misses++;
+                } else {
+                    run.conflict_misses++;
+                }
+            }
+            break;
+        }
+    }
+}
+
+std::unique_ptr<PlacementRun> CoSimulator::replay(Placement placement) const {
+    MEMSIM_PHASE(std::string("cosim replay ") + placementName(placement));
+    std::unique_ptr<PlacementRun> run = newRun(placement);
+    for (const CoSimOp& op : trace) {
+        apply(*run, op);
+    }
+    return run;
+}
+
+void CoSimulator::setPlacement(Placement placement) {
+    live = replay(placement);
+    std::cout << "Placement set to " << placementName(placement) << ", replayed "
+              << trace.size() << " operations\n";
+}
+
+bool CoSimulator::allocate(size_t size) {
+    if (size == 0) {
+        std::cout << "Error: Cannot allocate 0 bytes\n";
+        return false;
+    }
+    CoSimOp op = {CoSimOp::ALLOC, object_size.size() + 1, 0, size};
+    trace.push_back(op);
+    object_size.push_back(size);
+    object_live.push_back(true);
+    apply(*live, op);
+
+    size_t address = live->address_of.back();
+    std::cout << "Object " << op.object << ": " << size << " bytes ";
+    if (address == SIZE_MAX) {
+        std::cout << "could not be placed (" << placementName(live->placement) << ")\n";
+    } else {
+        std::cout << "at 0x" << std::hex << std::setfill('0') << std::setw(4) << address
+                  << std::setfill(' ') << std::dec << " (cache blocks " << address / block_size
+                  << "-" << (address + size - 1) / block_size << ")\n";
+    }
+    return true;
+}
+
+bool CoSimulator::release(size_t object) {
+    if (object == 0 || object > object_size.size() || !object_live[object - 1]) {
+        std::cout << "Error: Object " << object << " is not live\n";
+        return false;
+    }
+    CoSimOp op = {CoSimOp::FREE, object, 0, 0};
+    trace.push_back(op);
+    object_live[object - 1] = false;
+    apply(*live, op);
+    std::cout << "Object " << object << " freed\n";
+    return true;
+}
+
+bool CoSimulator::touch(size_t object, size_t offset, size_t bytes) {
+    if (object == 0 || object > object_size.size() || !object_live[object - 1]) {
+        std::cout << "Error: Object " << object << " is not live\n";
+        return false;
+    }
+    if (bytes == 0) {
+        std::cout << "Error: Cannot touch 0 bytes\n";
+        return false;
+    }
+    if (offset + bytes > object_size[object - 1]) {
+        std::cout << "Error: Bytes " << offset << "-" << offset + bytes - 1 << " are outside object "
+                  << object << " (" << object_size[object - 1] << " bytes)\n";
+        return false;
+    }
+    CoSimOp op = {CoSimOp::TOUCH, object, offset, bytes};
+    trace.push_back(op);
+
+    size_t hits = live->hits;
+    size_t accesses = live->accesses;
+    size_t skipped = live->skipped_accesses;
+    apply(*live, op);
+
+    std::cout << "Object " << object << " +" << offset;
+    if (live->skipped_accesses > skipped) {
+        std::cout << ": not placed, skipped\n";
+    } else {
+        size_t touched = live->accesses - accesses;
+        size_t hit = live->hits - hits;
+        std::cout << " (0x" << std::hex << live->address_of[object - 1] + offset << std::dec << "): ";
+        if (touched == 1) {
+            std::cout << (hit ? "HIT" : "MISS") << "\n";
+        } else {
+            std::cout << touched << " blocks, " << hit << " hits, " << touched - hit << " misses\n";
+        }
+    }
+    return true;
+}
+
+void CoSimulator::dump() const {
+    if (live->memory) live->memory->dump();
+    else live->buddy->dump();
+}
+
+void CoSimulator::reset() {
+    trace.clear();
+    object_size.clear();
+    object_live.clear();
+    live = newRun(live->placement);
+}
+
+void CoSimulator::stats() const {
+    const PlacementRun& run = *live;
+    size_t misses = run.misses();
+
+    std::cout << "\n=== Co-simulation Statistics ===\n";
+    std::cout << "Placement: " << placementName(run.placement) << "\n";
+    std::cout << "Cache: " << cache_size << " bytes, " << block_size << " byte blocks, "
+              << associativity << "-way " << policyName(policy) << "\n";
+    std::cout << "Trace: " << trace.size() << " operations, " << object_size.size() << " objects\n";
+    std::cout << "Allocations: " << run.allocations << " (" << run.failed_allocations << " failed), "
+              << run.split_objects << " objects split across an extra cache block\n";
+    std::cout << "Peak memory used: " << run.peak_used << " bytes, peak external fragmentation: "
+              << run.peak_fragmentation << "%\n";
+    std::cout << "Cache block accesses: " << run.accesses;
+    if (run.skipped_accesses > 0) {
+        std::cout << " (" << run.skipped_accesses << " skipped, object not placed)";
+    }
+    std::cout << "\n";
+    std::cout << "Hits: " << run.hits << ", misses: " << misses << " (cold " << run.cold_misses
+              << ", capacity " << run.capacity_misses << ", conflict " << run.conflict_misses << ")\n";
+    std::cout << "Miss ratio: " << std::fixed << std::setprecision(2)
+              << (run.accesses > 0 ? 100.0 * misses / run.accesses : 0.0) << "%\n";
+    std::cout << "================================\n\n";
+}
+
+void CoSimulator::compare() const {
+    if (trace.empty()) {
+        std::cout << "No operations to compare\n";
+        return;
+    }
+
+    std::cout << "\n=== Placement Comparison (" << trace.size() << " operations, " << cache_size
+              << " byte " << associativity << "-way cache) ===\n";
+    std::cout << "Placement   Failed   Split  Frag%   Accesses    Misses  Miss%    Cold  Capacity  Conflict\n";
+    for (Placement placement : ALL_PLACEMENTS) {
+        std::unique_ptr<PlacementRun> run = replay(placement);
+        std::cout << std::setfill(' ') << std::left << std::setw(10) << placementName(placement) << std::right
+                  << std::setw(8) << run->failed_allocations
+                  << std::setw(8) << run->split_objects
+                  << std::setw(7) << run->peak_fragmentation
+                  << std::setw(11) << run->accesses
+                  << std::setw(10) << run->misses()
+                  << std::setw(7) << std::fixed << std::setprecision(2)
+                  << (run->accesses > 0 ? 100.0 * run->misses() / run->accesses : 0.0)
+                  << std::setw(8) << run->cold_misses
+                  << std::setw(10) << run->capacity_misses
+                  << std::setw(10) << run->conflict_misses << "\n";
+    }
+    std::cout << "(Frag%: peak external fragmentation; Accesses: cache blocks touched, which depends on alignment)\n";
+    std::cout << "================================\n\n";
+}
+
+void CoSimulator::writeRunJson(std::ostream& out, const PlacementRun& run) {
+    out << "{\"placement\": \"" << placementName(run.placement)
+        << "\", \"allocations\": " << run.allocations
+        << ", \"failed_allocations\": " << run.failed_allocations
+        << ", \"split_objects\": " << run.split_objects
+        << ", \"peak_used\": " << run.peak_used
+        << ", \"peak_fragmentation_pct\": " << run.peak_fragmentation
+        << ", \"accesses\": " << run.accesses << ", \"skipped_accesses\": " << run.skipped_accesses
+        << ", \"hits\": " << run.hits << ", \"cold_misses\": " << run.cold_misses
+        << ", \"capacity_misses\": " << run.capacity_misses
+        << ", \"conflict_misses\": " << run.conflict_misses << "}";
+}
+
+void CoSimulator::writeStatsJson(std::ostream& out) const {
+    out << "{\"memory\": " << memory_size << ", \"cache_size\": " << cache_size
+        << ", \"block_size\": " << block_size << ", \"associativity\": " << associativity
+        << ", \"policy\": \"" << policyName(policy) << "\", \"operations\": " << trace.size()
+        << ",\n    \"live\": ";
+    writeRunJson(out, *live);
+    out << ",\n    \"placements\": [";
+    const char* separator = "\n        ";
+    for (Placement placement : ALL_PLACEMENTS) {
+        out << separator;
+        writeRunJson(out, *replay(placement));
+        separator = ",\n        ";
+    }
+    out << "]}";
+}
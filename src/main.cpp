@@ -1,319 +1,1238 @@
-#include "MemoryManager.h"
-#include "BuddyAllocator.h"
-#include "Cache.h"
-#include "VirtualMemory.h"
-#include <iostream>
-#include <sstream>
-#include <string>
-#include <memory>
-
-enum SimulatorMode {
-    STANDARD_ALLOCATOR,
-    BUDDY_ALLOCATOR,
-    CACHE_SIM,
-    VIRTUAL_MEMORY_SIM
-};
-
-void printHelp() {
-    std::cout << "\n=== Memory Management Simulator ===\n";
-    std::cout << "Available commands:\n\n";
-    std::cout << "General:\n";
-    std::cout << "  mode <standard|buddy|cache|vm>  - Switch simulator mode\n";
-    std::cout << "  help                             - Show this help message\n";
-    std::cout << "  exit                             - Exit the simulator\n\n";
-    
-    std::cout << "Standard/Buddy Allocator:\n";
-    std::cout << "  init memory <size>               - Initialize memory\n";
-    std::cout << "  set allocator <first_fit|best_fit|worst_fit> - Set allocation strategy\n";
-    std::cout << "  malloc <size>                    - Allocate memory\n";
-    std::cout << "  free <id>                        - Free allocated block\n";
-    std::cout << "  dump                             - Show memory layout\n";
-    std::cout << "  stats                            - Show statistics\n\n";
-    
-    std::cout << "Cache Simulator:\n";
-    std::cout << "  init cache <name> <size> <block_size> <assoc> [fifo|lru] - Init cache\n";
-    std::cout << "  access <address>                 - Access memory address\n";
-    std::cout << "  reset                            - Reset cache statistics\n";
-    std::cout << "  stats                            - Show cache statistics\n\n";
-    
-    std::cout << "Virtual Memory Simulator:\n";
-    std::cout << "  init vm <num_pages> <page_size> <num_frames> - Initialize VM\n";
-    std::cout << "  set policy <fifo|lru>            - Set page replacement policy\n";
-    std::cout << "  translate <virt_addr>            - Translate virtual address\n";
-    std::cout << "  reset                            - Reset VM statistics\n";
-    std::cout << "  stats                            - Show VM statistics\n";
-    std::cout << "====================================\n\n";
-}
-
-int main() {
-    std::unique_ptr<MemoryManager> memManager;
-    std::unique_ptr<BuddyAllocator> buddyAllocator;
-    std::unique_ptr<Cache> cache;
-    std::unique_ptr<VirtualMemory> vm;
-    
-    SimulatorMode mode = STANDARD_ALLOCATOR;
-    std::string line;
-    
-    std::cout << "Memory Management Simulator\n";
-    std::cout << "Type 'help' for commands\n\n";
-    
-    while (true) {
-        std::cout << "memsim> ";
-        if (!std::getline(std::cin, line)) {
-            break;
-        }
-        
-        if (line.empty()) continue;
-        
-        std::istringstream iss(line);
-        std::string cmd;
-        iss >> cmd;
-        
-        // General commands
-        if (cmd == "exit" || cmd == "quit") {
-            std::cout << "Exiting simulator...\n";
-            break;
-        }
-        else if (cmd == "help") {
-            printHelp();
-        }
-        else if (cmd == "mode") {
-            std::string mode_str;
-            iss >> mode_str;
-            
-            if (mode_str == "standard") {
-                mode = STANDARD_ALLOCATOR;
-                if (!memManager) {
-                    memManager = std::make_unique<MemoryManager>();
-                }
-                std::cout << "Switched to Standard Allocator mode\n";
-            }
-            else if (mode_str == "buddy") {
-                mode = BUDDY_ALLOCATOR;
-                if (!buddyAllocator) {
-                    buddyAllocator = std::make_unique<BuddyAllocator>();
-                }
-                std::cout << "Switched to Buddy Allocator mode\n";
-            }
-            else if (mode_str == "cache") {
-                mode = CACHE_SIM;
-                std::cout << "Switched to Cache Simulator mode\n";
-            }
-            else if (mode_str == "vm") {
-                mode = VIRTUAL_MEMORY_SIM;
-                std::cout << "Switched to Virtual Memory mode\n";
-            }
-            else {
-                std::cout << "Unknown mode: " << mode_str << "\n";
-            }
-        }
-        // Standard/Buddy allocator commands
-        else if (cmd == "init") {
-            std::string sub_cmd;
-            iss >> sub_cmd;
-            
-            if (sub_cmd == "memory") {
-                size_t size;
-                iss >> size;
-                
-                if (mode == STANDARD_ALLOCATOR) {
-                    if (!memManager) {
-                        memManager = std::make_unique<MemoryManager>();
-                    }
-                    memManager->init(size);
-                }
-                else if (mode == BUDDY_ALLOCATOR) {
-                    if (!buddyAllocator) {
-                        buddyAllocator = std::make_unique<BuddyAllocator>();
-                    }
-                    buddyAllocator->init(size);
-                }
-                else {
-                    std::cout << "Error: Not in allocator mode\n";
-                }
-            }
-            else if (sub_cmd == "cache") {
-                std::string name;
-                size_t size, block_size, assoc;
-                std::string policy_str;
-                
-                iss >> name >> size >> block_size >> assoc;
-                
-                ReplacementPolicy policy = FIFO;
-                if (iss >> policy_str) {
-                    if (policy_str == "lru") {
-                        policy = LRU;
-                    }
-                }
-                
-                cache = std::make_unique<Cache>(name, size, block_size, assoc, policy);
-            }
-            else if (sub_cmd == "vm") {
-                size_t num_pages, page_size, num_frames;
-                iss >> num_pages >> page_size >> num_frames;
-                
-                vm = std::make_unique<VirtualMemory>(num_pages, page_size, num_frames);
-            }
-            else {
-                std::cout << "Unknown init command: " << sub_cmd << "\n";
-            }
-        }
-        else if (cmd == "set") {
-            std::string sub_cmd;
-            iss >> sub_cmd;
-            
-            if (sub_cmd == "allocator") {
-                std::string strategy_str;
-                iss >> strategy_str;
-                
-                if (mode == STANDARD_ALLOCATOR && memManager) {
-                    if (strategy_str == "first_fit") {
-                        memManager->setStrategy(FIRST_FIT);
-                    }
-                    else if (strategy_str == "best_fit") {
-                        memManager->setStrategy(BEST_FIT);
-                    }
-                    else if (strategy_str == "worst_fit") {
-                        memManager->setStrategy(WORST_FIT);
-                    }
-                    else {
-                        std::cout << "Unknown strategy: " << strategy_str << "\n";
-                    }
-                }
-                else {
-                    std::cout << "Error: Not in standard allocator mode or not initialized\n";
-                }
-            }
-            else if (sub_cmd == "policy") {
-                std::string policy_str;
-                iss >> policy_str;
-                
-                if (mode == VIRTUAL_MEMORY_SIM && vm) {
-                    if (policy_str == "fifo") {
-                        vm->setPolicy(PAGE_FIFO);
-                    }
-                    else if (policy_str == "lru") {
-                        vm->setPolicy(PAGE_LRU);
-                    }
-                    else {
-                        std::cout << "Unknown policy: " << policy_str << "\n";
-                    }
-                }
-                else {
-                    std::cout << "Error: Not in VM mode or not initialized\n";
-                }
-            }
-            else {
-                std::cout << "Unknown set command: " << sub_cmd << "\n";
-            }
-        }
-        else if (cmd == "malloc") {
-            size_t size;
-            iss >> size;
-            
-            if (mode == STANDARD_ALLOCATOR && memManager) {
-                memManager->malloc(size);
-            }
-            else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
-                buddyAllocator->allocate(size);
-            }
-            else {
-                std::cout << "Error: Not in allocator mode or not initialized\n";
-            }
-        }
-        else if (cmd == "free") {
-            int id;
-            iss >> id;
-            
-            if (mode == STANDARD_ALLOCATOR && memManager) {
-                memManager->free(id);
-            }
-            else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
-                buddyAllocator->free(id);
-            }
-            else {
-                std::cout << "Error: Not in allocator mode or not initialized\n";
-            }
-        }
-        else if (cmd == "dump") {
-            if (mode == STANDARD_ALLOCATOR && memManager) {
-                memManager->dump();
-            }
-            else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
-                buddyAllocator->dump();
-            }
-            else {
-                std::cout << "Error: Not in allocator mode or not initialized\n";
-            }
-        }
-        else if (cmd == "stats") {
-            if (mode == STANDARD_ALLOCATOR && memManager) {
-                memManager->stats();
-            }
-            else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
-                buddyAllocator->stats();
-            }
-            else if (mode == CACHE_SIM && cache) {
-                cache->stats();
-            }
-            else if (mode == VIRTUAL_MEMORY_SIM && vm) {
-                vm->stats();
-            }
-            else {
-                std::cout << "Error: Simulator not initialized\n";
-            }
-        }
-        // Cache commands
-        else if (cmd == "access") {
-            size_t address;
-            iss >> address;
-            
-            if (mode == CACHE_SIM && cache) {
-                bool hit = cache->access(address);
-                std::cout << "Address 0x" << std::hex << address << std::dec 
-                          << ": " << (hit ? "HIT" : "MISS") << "\n";
-            }
-            else {
-                std::cout << "Error: Not in cache mode or not initialized\n";
-            }
-        }
-        else if (cmd == "reset") {
-            if (mode == CACHE_SIM && cache) {
-                cache->reset();
-                std::cout << "Cache statistics reset\n";
-            }
-            else if (mode == VIRTUAL_MEMORY_SIM && vm) {
-                vm->reset();
-                std::cout << "Virtual memory statistics reset\n";
-            }
-            else {
-                std::cout << "Error: Reset not available in this mode\n";
-            }
-        }
-        // Virtual memory commands
-        else if (cmd == "translate") {
-            size_t virt_addr;
-            iss >> std::hex >> virt_addr;
-            
-            if (mode == VIRTUAL_MEMORY_SIM && vm) {
-                size_t phys_addr = vm->translate(virt_addr);
-                if (phys_addr == SIZE_MAX) {
-                    std::cout << "Error: Failed to translate virtual address 0x" << std::hex << virt_addr << std::dec << "\n";
-                } else {
-                    std::cout << "Virtual address 0x" << std::hex << virt_addr 
-                              << std::dec << " -> Physical address 0x" << std::hex << phys_addr 
-                              << std::dec << "\n";
-                }
-            }
-            else {
-                std::cout << "Error: Not in VM mode or not initialized\n";
-            }
-        }
-        else {
-            std::cout << "Unknown command: " << cmd << "\n";
-            std::cout << "Type 'help' for available commands\n";
-        }
-    }
-    
-    return 0;
+#include "MemoryManager.h"
+#include "BuddyAllocator.h"
+#include "FixedCache.h"
+#include "SampledCache.h"
+#include "VirtualMemory.h"
+#include "MultiProcessVM.h"
+#include "Coherence.h"
+#include "CoSimulation.h"
+#include "Arena.h"
+#include "AllocTrace.h"
+#include "CommandTokenizer.h"
+#include "Profile.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <iomanip>
+#include <cstdint>
+#include <vector>
+
+enum SimulatorMode {
+    STANDARD_ALLOCATOR,
+    BUDDY_ALLOCATOR,
+    CACHE_SIM,
+    VIRTUAL_MEMORY_SIM,
+    MULTI_PROCESS_VM_SIM,
+    COHERENCE_SIM,
+    CO_SIM
+};
+
+enum Command {
+    CMD_UNKNOWN,
+    CMD_EXIT,
+    CMD_HELP,
+    CMD_MODE,
+    CMD_INIT,
+    CMD_SET,
+    CMD_MALLOC,
+    CMD_FREE,
+    CMD_DUMP,
+    CMD_STATS,
+    CMD_SAVE,
+    CMD_LOAD,
+    CMD_SAMPLE,
+    CMD_COMPACT,
+    CMD_ARENA,
+    CMD_ACCESS,
+    CMD_RESET,
+    CMD_TRANSLATE,
+    CMD_PROCESS,
+    CMD_TOUCH,
+    CMD_COMPARE,
+    CMD_PROFILE,
+    CMD_REPLAY
+};
+
+// Switch on the first letter, then at most three string compares
+Command lookupCommand(std::string_view cmd) {
+    switch (cmd[0]) {
+        case 'a': return cmd == "access" ? CMD_ACCESS : cmd == "arena" ? CMD_ARENA : CMD_UNKNOWN;
+        case 'c': return cmd == "compact" ? CMD_COMPACT : cmd == "compare" ? CMD_COMPARE : CMD_UNKNOWN;
+        case 'd': return cmd == "dump" ? CMD_DUMP : CMD_UNKNOWN;
+        case 'e': return cmd == "exit" ? CMD_EXIT : CMD_UNKNOWN;
+        case 'f': return cmd == "free" ? CMD_FREE : CMD_UNKNOWN;
+        case 'h': return cmd == "help" ? CMD_HELP : CMD_UNKNOWN;
+        case 'i': return cmd == "init" ? CMD_INIT : CMD_UNKNOWN;
+        case 'l': return cmd == "load" ? CMD_LOAD : CMD_UNKNOWN;
+        case 'm': return cmd == "malloc" ? CMD_MALLOC : cmd == "mode" ? CMD_MODE : CMD_UNKNOWN;
+        case 'p': return cmd == "process" ? CMD_PROCESS : cmd == "profile" ? CMD_PROFILE : CMD_UNKNOWN;
+        case 'q': return cmd == "quit" ? CMD_EXIT : CMD_UNKNOWN;
+        case 'r': return cmd == "reset" ? CMD_RESET : cmd == "replay" ? CMD_REPLAY : CMD_UNKNOWN;
+        case 's':
+            return cmd == "stats" ? CMD_STATS : cmd == "set" ? CMD_SET :
+                   cmd == "sample" ? CMD_SAMPLE : cmd == "save" ? CMD_SAVE : CMD_UNKNOWN;
+        case 't': return cmd == "translate" ? CMD_TRANSLATE : cmd == "touch" ? CMD_TOUCH : CMD_UNKNOWN;
+    }
+    return CMD_UNKNOWN;
+}
+
+// Unknown names keep the FIFO default
+ReplacementPolicy parseCachePolicy(std::string_view policy_str) {
+    if (policy_str == "lru") return LRU;
+    if (policy_str == "plru") return TREE_PLRU;
+    if (policy_str == "srrip") return SRRIP;
+    if (policy_str == "brrip") return BRRIP;
+    if (policy_str == "drrip") return DRRIP;
+    if (policy_str == "random") return RANDOM_REPLACEMENT;
+    return FIFO;
+}
+
+void printHelp() {
+    std::cout << "\n=== Memory Management Simulator ===\n";
+    std::cout << "Available commands (numbers and addresses are decimal, or hex with 0x):\n\n";
+    std::cout << "General:\n";
+    std::cout << "  mode <standard|buddy|cache|vm|mpvm|coherence|cosim> - Switch simulator mode\n";
+    std::cout << "  stats json <file>                - Write statistics and histograms as JSON\n";
+    std::cout << "  sample <n> <file>|off            - Record a sample every n operations (.csv or JSONL)\n";
+    std::cout << "  save <file>                      - Write a binary snapshot of the current simulator\n";
+    std::cout << "  load <file>                      - Restore a snapshot written by save\n";
+    std::cout << "  profile [reset]                  - Hot-path probes and time per command (make PROFILE=1 builds)\n";
+    std::cout << "  help                             - Show this help message\n";
+    std::cout << "  # <text>                         - Comment, ignored (for scripts run with -f)\n";
+    std::cout << "  exit                             - Exit the simulator\n\n";
+    
+    std::cout << "Standard/Buddy Allocator:\n";
+    std::cout << "  init memory <size>               - Initialize memory\n";
+    std::cout << "  set allocator <first_fit|best_fit|worst_fit|next_fit> - Set allocation strategy\n";
+    std::cout << "  malloc <size>                    - Allocate memory\n";
+    std::cout << "  free <id>                        - Free allocated block\n";
+    std::cout << "  dump                             - Show memory layout\n";
+    std::cout << "  stats                            - Show statistics\n";
+    std::cout << "  compact [max_bytes]              - Slide used blocks down (standard only)\n";
+    std::cout << "  replay <file>                    - Replay an allocation trace from libmemsim_trace.so\n";
+    std::cout << "  arena create <size>              - Carve a bump-pointer arena from memory\n";
+    std::cout << "  arena alloc <arena_id> <size>    - Allocate from an arena\n";
+    std::cout << "  arena reset <arena_id>           - Release every object in an arena\n";
+    std::cout << "  arena destroy <arena_id>         - Return an arena to the allocator\n";
+    std::cout << "  arena stats [arena_id]           - Arena statistics vs malloc/free\n\n";
+    
+    std::cout << "Cache Simulator:\n";
+    std::cout << "  init cache <name> <size> <block_size> <assoc> [policy] - Init cache\n";
+    std::cout << "      policy: fifo|lru|plru|srrip|brrip|drrip|random (default fifo)\n";
+    std::cout << "  access <address>                 - Access memory address\n";
+    std::cout << "  set sampling sets <k>            - Simulate 1 in k sets and extrapolate\n";
+    std::cout << "  set sampling time <period> <warmup> <measure> - Simulate part of every period\n";
+    std::cout << "  set sampling off                 - Simulate every access again\n";
+    std::cout << "  reset                            - Reset cache statistics\n";
+    std::cout << "  stats                            - Show cache statistics\n\n";
+    
+    std::cout << "Virtual Memory Simulator:\n";
+    std::cout << "  init vm <num_pages> <page_size> <num_frames> - Initialize VM\n";
+    std::cout << "  set policy <fifo|lru>            - Set page replacement policy\n";
+    std::cout << "  set window <accesses>            - Set the working-set window\n";
+    std::cout << "  set pff <interval>|off           - Page-fault-frequency resident set control\n";
+    std::cout << "  set pagesizes <order>...|base    - Huge page sizes as powers of two of the page size\n";
+    std::cout << "  set hugepages <never|always|promote [pct]> - Huge page policy\n";
+    std::cout << "  set swap <latency_us> <MB_per_s> [queue_depth] - Swap device timing\n";
+    std::cout << "  set memtime <ns>                 - Time of one memory access\n";
+    std::cout << "  set prefetch <pages>             - Read ahead after each fault (0 = off)\n";
+    std::cout << "  translate <virt_addr> [r|w]      - Translate virtual address (w = write)\n";
+    std::cout << "  reset                            - Reset VM statistics\n";
+    std::cout << "  stats                            - Show VM statistics\n\n";
+    
+    std::cout << "Multi-Process Virtual Memory:\n";
+    std::cout << "  init mpvm <page_size> <num_frames> - Initialize a shared frame pool\n";
+    std::cout << "  process create <num_pages>       - Start a process with its own page table\n";
+    std::cout << "  process fork <asid>              - Copy a process, sharing pages copy-on-write\n";
+    std::cout << "  process exit <asid>              - End a process and release its frames\n";
+    std::cout << "  translate <asid> <virt_addr> [r|w] - Translate for one process (w = write)\n";
+    std::cout << "  set policy <fifo|lru>            - Set page replacement policy\n";
+    std::cout << "  set scope <global|local>         - Replace among all frames or the process's own\n";
+    std::cout << "  set thrashing <window> <fault_pct> - Thrashing detection threshold\n";
+    std::cout << "  reset                            - Page everything out and reset statistics\n";
+    std::cout << "  stats                            - Show per-process and pool statistics\n\n";
+    
+    std::cout << "Cache Coherence:\n";
+    std::cout << "  init coherence <cores> <size> <block_size> <assoc> [policy] - Private cache per core\n";
+    std::cout << "  set protocol <mesi|moesi>        - Coherence protocol\n";
+    std::cout << "  set interconnect <snoop|directory> - Snooping bus or directory\n";
+    std::cout << "  set shared <size> <assoc>|off    - Shared level below the private caches\n";
+    std::cout << "  access <core> <address> [r|w]    - Access from one core (w = write)\n";
+    std::cout << "  reset                            - Empty the caches and reset statistics\n";
+    std::cout << "  stats                            - Misses by cause, traffic and hot lines\n\n";
+    
+    std::cout << "Allocator + Cache Co-simulation:\n";
+    std::cout << "  init cosim <memory> <cache_size> <block_size> <assoc> [policy] - Memory is a power of 2\n";
+    std::cout << "  set allocator <first_fit|best_fit|worst_fit|next_fit|buddy> - Placement, replays the trace\n";
+    std::cout << "  malloc <size>                    - Allocate an object; prints its number and address\n";
+    std::cout << "  free <object>                    - Free an object\n";
+    std::cout << "  touch <object> <offset> [bytes]  - Access bytes of an object through the cache\n";
+    std::cout << "  compare                          - Replay the trace under every placement\n";
+    std::cout << "  dump                             - Memory layout of the current placement\n";
+    std::cout << "  reset                            - Clear the trace\n";
+    std::cout << "  stats                            - Cache misses (cold/capacity/conflict) and placement\n";
+    std::cout << "====================================\n\n";
+}
+
+int main(int argc, char* argv[]) {
+    // memsim -f <script> runs a command file without prompts
+    std::ifstream script;
+    if (argc == 3 && std::string_view(argv[1]) == "-f") {
+        script.open(argv[2]);
+        if (!script) {
+            std::cout << "Error: Cannot open " << argv[2] << "\n";
+            return 1;
+        }
+        // No prompts to flush, so let cout buffer freely
+        std::ios::sync_with_stdio(false);
+    }
+    else if (argc != 1) {
+        std::cout << "Usage: " << argv[0] << " [-f script.txt]\n";
+        return 1;
+    }
+    bool interactive = !script.is_open();
+    std::istream& input = interactive ? std::cin : script;
+    
+    std::unique_ptr<MemoryManager> memManager;
+    std::unique_ptr<BuddyAllocator> buddyAllocator;
+    std::unique_ptr<CacheBase> cache;
+    std::unique_ptr<VirtualMemory> vm;
+    std::unique_ptr<MultiProcessVM> mpvm;
+    std::unique_ptr<CoherenceSimulator> coherence;
+    std::unique_ptr<CoSimulator> cosim;
+    std::unique_ptr<ArenaManager> memArenas;
+    std::unique_ptr<ArenaManager> buddyArenas;
+    
+    SimulatorMode mode = STANDARD_ALLOCATOR;
+    // The line buffer is reused, so once it has grown to the longest line
+    // a command costs no heap allocation
+    std::string line;
+    
+    std::cout << "Memory Management Simulator\n";
+    if (interactive) {
+        std::cout << "Type 'help' for commands\n\n";
+    }
+    
+    bool running = true;
+    while (running) {
+        if (interactive) {
+            std::cout << "memsim> ";
+        }
+        if (!std::getline(input, line)) {
+            break;
+        }
+        
+        CommandTokenizer tok(line);
+        std::string_view cmd = tok.next();
+        if (cmd.empty() || cmd[0] == '#') continue;
+        // Profile builds time every command by name
+        MEMSIM_PHASE("cmd " + std::string(cmd));
+        
+        // General commands
+        switch (lookupCommand(cmd)) {
+            case CMD_EXIT: {
+                std::cout << "Exiting simulator...\n";
+                running = false;
+                break;
+            }
+            case CMD_HELP: {
+                printHelp();
+                break;
+            }
+            case CMD_PROFILE: {
+                if (tok.next() == "reset") {
+                    profileReset();
+                } else {
+                    profileReport();
+                }
+                break;
+            }
+            case CMD_MODE: {
+                std::string_view mode_str = tok.next();
+                
+                if (mode_str == "standard") {
+                    mode = STANDARD_ALLOCATOR;
+                    if (!memManager) {
+                        memManager = std::make_unique<MemoryManager>();
+                    }
+                    std::cout << "Switched to Standard Allocator mode\n";
+                }
+                else if (mode_str == "buddy") {
+                    mode = BUDDY_ALLOCATOR;
+                    if (!buddyAllocator) {
+                        buddyAllocator = std::make_unique<BuddyAllocator>();
+                    }
+                    std::cout << "Switched to Buddy Allocator mode\n";
+                }
+                else if (mode_str == "cache") {
+                    mode = CACHE_SIM;
+                    std::cout << "Switched to Cache Simulator mode\n";
+                }
+                else if (mode_str == "vm") {
+                    mode = VIRTUAL_MEMORY_SIM;
+                    std::cout << "Switched to Virtual Memory mode\n";
+                }
+                else if (mode_str == "mpvm") {
+                    mode = MULTI_PROCESS_VM_SIM;
+                    std::cout << "Switched to Multi-Process Virtual Memory mode\n";
+                }
+                else if (mode_str == "coherence") {
+                    mode = COHERENCE_SIM;
+                    std::cout << "Switched to Cache Coherence mode\n";
+                }
+                else if (mode_str == "cosim") {
+                    mode = CO_SIM;
+                    std::cout << "Switched to Allocator + Cache Co-simulation mode\n";
+                }
+                else {
+                    std::cout << "Unknown mode: " << mode_str << "\n";
+                }
+                break;
+            }
+            // Standard/Buddy allocator commands
+            case CMD_INIT: {
+                std::string_view sub_cmd = tok.next();
+                
+                if (sub_cmd == "memory") {
+                    size_t size = 0;
+                    
+                    if (!tok.next(size) || size == 0) {
+                        std::cout << "Error: Usage: init memory <size>\n";
+                    }
+                    else if (mode == STANDARD_ALLOCATOR) {
+                        if (!memManager) {
+                            memManager = std::make_unique<MemoryManager>();
+                        }
+                        memManager->init(size);
+                        if (memArenas) memArenas->clear();
+                    }
+                    else if (mode == BUDDY_ALLOCATOR) {
+                        if (!buddyAllocator) {
+                            buddyAllocator = std::make_unique<BuddyAllocator>();
+                        }
+                        buddyAllocator->init(size);
+                        if (buddyArenas) buddyArenas->clear();
+                    }
+                    else {
+                        std::cout << "Error: Not in allocator mode\n";
+                    }
+                }
+                else if (sub_cmd == "cache") {
+                    std::string name(tok.next());
+                    size_t size = 0, block_size = 0, assoc = 0;
+                    tok.next(size);
+                    tok.next(block_size);
+                    tok.next(assoc);
+                    
+                    ReplacementPolicy policy = parseCachePolicy(tok.next());
+                    
+                    if (block_size == 0 || assoc == 0 || size < block_size * assoc) {
+                        std::cout << "Error: Usage: init cache <name> <size> <block_size> <assoc> [policy]\n";
+                    }
+                    else {
+                        cache = makeCache(name, size, block_size, assoc, policy);
+                    }
+                }
+                else if (sub_cmd == "coherence") {
+                    size_t cores = 0, size = 0, block_size = 0, assoc = 0;
+                    tok.next(cores);
+                    tok.next(size);
+                    tok.next(block_size);
+                    tok.next(assoc);
+                    ReplacementPolicy policy = parseCachePolicy(tok.next());
+                    
+                    if (cores == 0 || cores > 64 || block_size == 0 || assoc == 0 ||
+                        size < block_size * assoc) {
+                        std::cout << "Error: Usage: init coherence <cores 1-64> <size> <block_size> <assoc> [policy]\n";
+                    }
+                    else {
+                        if (coherence) coherence->stopSampling();
+                        coherence = std::make_unique<CoherenceSimulator>(cores, size, block_size, assoc, policy);
+                    }
+                }
+                else if (sub_cmd == "cosim") {
+                    size_t memory = 0, size = 0, block_size = 0, assoc = 0;
+                    tok.next(memory);
+                    tok.next(size);
+                    tok.next(block_size);
+                    tok.next(assoc);
+                    ReplacementPolicy policy = parseCachePolicy(tok.next());
+                    
+                    if (memory == 0 || (memory & (memory - 1)) != 0 || block_size == 0 || assoc == 0 ||
+                        size < block_size * assoc) {
+                        std::cout << "Error: Usage: init cosim <memory (power of 2)> <cache_size> <block_size> <assoc> [policy]\n";
+                    }
+                    else {
+                        cosim = std::make_unique<CoSimulator>(memory, size, block_size, assoc, policy);
+                    }
+                }
+                else if (sub_cmd == "vm") {
+                    size_t num_pages = 0, page_size = 0, num_frames = 0;
+                    tok.next(num_pages);
+                    tok.next(page_size);
+                    tok.next(num_frames);
+                    
+                    if (num_pages == 0 || page_size == 0 || num_frames == 0) {
+                        std::cout << "Error: Usage: init vm <num_pages> <page_size> <num_frames>\n";
+                    }
+                    else {
+                        vm = std::make_unique<VirtualMemory>(num_pages, page_size, num_frames);
+                    }
+                }
+                else if (sub_cmd == "mpvm") {
+                    size_t page_size = 0, num_frames = 0;
+                    tok.next(page_size);
+                    tok.next(num_frames);
+                    
+                    if (page_size == 0 || num_frames == 0) {
+                        std::cout << "Error: Usage: init mpvm <page_size> <num_frames>\n";
+                    }
+                    else {
+                        if (mpvm) mpvm->stopSampling();
+                        mpvm = std::make_unique<MultiProcessVM>(page_size, num_frames);
+                    }
+                }
+                else {
+                    std::cout << "Unknown init command: " << sub_cmd << "\n";
+                }
+                break;
+            }
+            case CMD_SET: {
+                std::string_view sub_cmd = tok.next();
+                
+                if (sub_cmd == "allocator") {
+                    std::string_view strategy_str = tok.next();
+                    
+                    if (mode == CO_SIM && cosim) {
+                        if (strategy_str == "first_fit") cosim->setPlacement(PLACEMENT_FIRST_FIT);
+                        else if (strategy_str == "best_fit") cosim->setPlacement(PLACEMENT_BEST_FIT);
+                        else if (strategy_str == "worst_fit") cosim->setPlacement(PLACEMENT_WORST_FIT);
+                        else if (strategy_str == "next_fit") cosim->setPlacement(PLACEMENT_NEXT_FIT);
+                        else if (strategy_str == "buddy") cosim->setPlacement(PLACEMENT_BUDDY);
+                        else std::cout << "Unknown strategy: " << strategy_str << "\n";
+                    }
+                    else if (mode == STANDARD_ALLOCATOR && memManager) {
+                        if (strategy_str == "first_fit") {
+                            memManager->setStrategy(FIRST_FIT);
+                        }
+                        else if (strategy_str == "best_fit") {
+                            memManager->setStrategy(BEST_FIT);
+                        }
+                        else if (strategy_str == "worst_fit") {
+                            memManager->setStrategy(WORST_FIT);
+                        }
+                        else if (strategy_str == "next_fit") {
+                            memManager->setStrategy(NEXT_FIT);
+                        }
+                        else {
+                            std::cout << "Unknown strategy: " << strategy_str << "\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in standard allocator mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "policy") {
+                    std::string_view policy_str = tok.next();
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (policy_str == "fifo") {
+                            vm->setPolicy(PAGE_FIFO);
+                        }
+                        else if (policy_str == "lru") {
+                            vm->setPolicy(PAGE_LRU);
+                        }
+                        else {
+                            std::cout << "Unknown policy: " << policy_str << "\n";
+                        }
+                    }
+                    else if (mode == MULTI_PROCESS_VM_SIM && mpvm) {
+                        if (policy_str == "fifo") {
+                            mpvm->setPolicy(PAGE_FIFO);
+                        }
+                        else if (policy_str == "lru") {
+                            mpvm->setPolicy(PAGE_LRU);
+                        }
+                        else {
+                            std::cout << "Unknown policy: " << policy_str << "\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "window") {
+                    size_t delta = 0;
+                    tok.next(delta);
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (delta == 0 || delta > VirtualMemory::MAX_WS_WINDOW) {
+                            std::cout << "Error: Usage: set window <accesses>\n";
+                        }
+                        else {
+                            vm->setWorkingSetWindow(delta);
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "pff") {
+                    std::string_view arg = tok.next();
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        size_t threshold = 0;
+                        if (arg == "off") {
+                            vm->setPffThreshold(0);
+                        }
+                        else if (CommandTokenizer::parse(arg, threshold) && threshold > 0) {
+                            vm->setPffThreshold(threshold);
+                        }
+                        else {
+                            std::cout << "Error: Usage: set pff <interval> or set pff off\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "pagesizes") {
+                    std::vector<unsigned> orders;
+                    bool valid = true;
+                    for (std::string_view arg = tok.next(); !arg.empty(); arg = tok.next()) {
+                        unsigned order = 0;
+                        if (arg == "base" && orders.empty()) {
+                            continue;
+                        }
+                        if (!CommandTokenizer::parse(arg, order)) {
+                            valid = false;
+                            break;
+                        }
+                        orders.push_back(order);
+                    }
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (!valid) {
+                            std::cout << "Error: Usage: set pagesizes <order>... or set pagesizes base\n";
+                        }
+                        else {
+                            vm->setPageSizes(orders);
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "hugepages") {
+                    std::string_view policy_str = tok.next();
+                    size_t pct = 50;
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (policy_str == "never") {
+                            vm->setHugePagePolicy(HUGE_NEVER);
+                        }
+                        else if (policy_str == "always") {
+                            vm->setHugePagePolicy(HUGE_ALWAYS);
+                        }
+                        else if (policy_str == "promote") {
+                            tok.next(pct);
+                            if (pct == 0 || pct > 100) {
+                                std::cout << "Error: Promotion threshold must be 1-100%\n";
+                            }
+                            else {
+                                vm->setHugePagePolicy(HUGE_PROMOTE, pct);
+                            }
+                        }
+                        else {
+                            std::cout << "Unknown huge page policy: " << policy_str << "\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "swap") {
+                    double latency_us = -1, bandwidth_mbps = 0;
+                    size_t queue_depth = 32;
+                    tok.next(latency_us);
+                    tok.next(bandwidth_mbps);
+                    tok.next(queue_depth);
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (latency_us < 0 || bandwidth_mbps <= 0 || queue_depth == 0) {
+                            std::cout << "Error: Usage: set swap <latency_us> <MB_per_s> [queue_depth]\n";
+                        }
+                        else {
+                            vm->setSwapDevice(latency_us, bandwidth_mbps, queue_depth);
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "memtime") {
+                    double ns = -1;
+                    tok.next(ns);
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        if (ns < 0) {
+                            std::cout << "Error: Usage: set memtime <ns>\n";
+                        }
+                        else {
+                            vm->setMemoryAccessTime(ns);
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "prefetch") {
+                    size_t pages = 0;
+                    tok.next(pages);
+                    
+                    if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                        vm->setPrefetch(pages);
+                    }
+                    else {
+                        std::cout << "Error: Not in VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "scope") {
+                    std::string_view scope_str = tok.next();
+                    
+                    if (mode == MULTI_PROCESS_VM_SIM && mpvm) {
+                        if (scope_str == "global") {
+                            mpvm->setScope(SCOPE_GLOBAL);
+                        }
+                        else if (scope_str == "local") {
+                            mpvm->setScope(SCOPE_LOCAL);
+                        }
+                        else {
+                            std::cout << "Unknown scope: " << scope_str << "\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in multi-process VM mode or not initialized\n";
+                    }
+                }
+                else if (sub_cmd == "sampling") {
+                    std::string_view kind = tok.next();
+                    
+                    if (mode != CACHE_SIM || !cache) {
+                        std::cout << "Error: Not in cache mode or not initialized\n";
+                        break;
+                    }
+                    SampledCache* sampled = dynamic_cast<SampledCache*>(cache.get());
+                    if (kind == "off") {
+                        if (sampled) {
+                            cache = sampled->release();
+                        }
+                        std::cout << cache->getName() << ": sampling off, statistics reset\n";
+                        break;
+                    }
+                    
+                    size_t ratio = 0, period = 0, warmup = 0, measure = 0;
+                    size_t sets = cache->getSize() / cache->getBlockSize() / cache->getAssociativity();
+                    bool valid = kind == "sets" ? tok.next(ratio) && ratio > 0 && ratio <= sets :
+                                 kind == "time" && tok.next(period) && tok.next(warmup) &&
+                                 tok.next(measure) && measure > 0 && warmup + measure <= period;
+                    if (!valid) {
+                        std::cout << "Error: Usage: set sampling sets <1_in_k> (k <= " << sets << ")"
+                                  << ", set sampling time <period> <warmup> <measure>, or set sampling off\n";
+                        break;
+                    }
+                    if (!sampled) {
+                        std::unique_ptr<SampledCache> wrapper = std::make_unique<SampledCache>(std::move(cache));
+                        sampled = wrapper.get();
+                        cache = std::move(wrapper);
+                    }
+                    if (kind == "sets") {
+                        sampled->setSetSampling(ratio);
+                    }
+                    else {
+                        sampled->setTimeSampling(period, warmup, measure);
+                    }
+                }
+                else if (sub_cmd == "protocol" || sub_cmd == "interconnect" || sub_cmd == "shared") {
+                    std::string_view arg = tok.next();
+                    
+                    if (mode != COHERENCE_SIM || !coherence) {
+                        std::cout << "Error: Not in coherence mode or not initialized\n";
+                    }
+                    else if (sub_cmd == "protocol" && (arg == "mesi" || arg == "moesi")) {
+                        coherence->setProtocol(arg == "mesi" ? MESI : MOESI);
+                    }
+                    else if (sub_cmd == "interconnect" && (arg == "snoop" || arg == "directory")) {
+                        coherence->setInterconnect(arg == "snoop" ? SNOOPING_BUS : DIRECTORY);
+                    }
+                    else if (sub_cmd == "shared") {
+                        size_t size = 0, assoc = 0;
+                        if (arg == "off") {
+                            coherence->setSharedLevel(0, 0);
+                        }
+                        else if (CommandTokenizer::parse(arg, size) && tok.next(assoc) && size > 0) {
+                            coherence->setSharedLevel(size, assoc);
+                        }
+                        else {
+                            std::cout << "Error: Usage: set shared <size> <assoc> or set shared off\n";
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Usage: set protocol <mesi|moesi> or set interconnect <snoop|directory>\n";
+                    }
+                }
+                else if (sub_cmd == "thrashing") {
+                    size_t window = 0;
+                    double fault_pct = -1;
+                    tok.next(window);
+                    tok.next(fault_pct);
+                    
+                    if (mode == MULTI_PROCESS_VM_SIM && mpvm) {
+                        if (window == 0 || fault_pct < 0 || fault_pct > 100) {
+                            std::cout << "Error: Usage: set thrashing <window> <fault_pct>\n";
+                        }
+                        else {
+                            mpvm->setThrashing(window, fault_pct);
+                        }
+                    }
+                    else {
+                        std::cout << "Error: Not in multi-process VM mode or not initialized\n";
+                    }
+                }
+                else {
+                    std::cout << "Unknown set command: " << sub_cmd << "\n";
+                }
+                break;
+            }
+            case CMD_MALLOC: {
+                size_t size = 0;
+                tok.next(size);
+                
+                if (mode == STANDARD_ALLOCATOR && memManager) {
+                    memManager->malloc(size);
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    buddyAllocator->allocate(size);
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->allocate(size);
+                }
+                else {
+                    std::cout << "Error: Not in allocator mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_FREE: {
+                int id = 0;
+                tok.next(id);
+                
+                // A block backing an arena goes back through arena destroy
+                ArenaManager* arenas = mode == STANDARD_ALLOCATOR ? memArenas.get()
+                                     : mode == BUDDY_ALLOCATOR ? buddyArenas.get() : nullptr;
+                int owner = arenas ? arenas->ownerOf(id) : -1;
+                if (owner != -1) {
+                    std::cout << "Error: Block " << id << " backs arena " << owner
+                              << "; use arena destroy " << owner << "\n";
+                }
+                else if (mode == STANDARD_ALLOCATOR && memManager) {
+                    memManager->free(id);
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    buddyAllocator->free(id);
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->release(id > 0 ? id : 0);
+                }
+                else {
+                    std::cout << "Error: Not in allocator mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_DUMP: {
+                if (mode == STANDARD_ALLOCATOR && memManager) {
+                    memManager->dump();
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    buddyAllocator->dump();
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->dump();
+                }
+                else {
+                    std::cout << "Error: Not in allocator mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_STATS: {
+                std::string_view format = tok.next();
+                std::string path(tok.next());
+                if (format == "json") {
+                    bool ready = (mode == STANDARD_ALLOCATOR && memManager) ||
+                                 (mode == BUDDY_ALLOCATOR && buddyAllocator) ||
+                                 (mode == CACHE_SIM && cache) ||
+                                 (mode == VIRTUAL_MEMORY_SIM && vm) ||
+                                 (mode == MULTI_PROCESS_VM_SIM && mpvm) ||
+                                 (mode == COHERENCE_SIM && coherence) ||
+                                 (mode == CO_SIM && cosim);
+                    if (!ready) {
+                        std::cout << "Error: Simulator not initialized\n";
+                        continue;
+                    }
+                    if (path.empty()) {
+                        std::cout << "Error: Usage: stats json <file>\n";
+                        continue;
+                    }
+                    std::ofstream out(path);
+                    if (!out) {
+                        std::cout << "Error: Cannot write " << path << "\n";
+                        continue;
+                    }
+                    out << "{\"" << (mode == CACHE_SIM ? "cache" : mode == VIRTUAL_MEMORY_SIM ? "vm" :
+                               mode == MULTI_PROCESS_VM_SIM ? "mpvm" :
+                               mode == COHERENCE_SIM ? "coherence" :
+                               mode == CO_SIM ? "cosim" : "allocator")
+                        << "\":\n    ";
+                    if (mode == STANDARD_ALLOCATOR && memManager) {
+                        memManager->writeStatsJson(out);
+                    }
+                    else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                        buddyAllocator->writeStatsJson(out);
+                    }
+                    else if (mode == CACHE_SIM && cache) {
+                        cache->writeStatsJson(out);
+                    }
+                    else if (mode == MULTI_PROCESS_VM_SIM) {
+                        mpvm->writeStatsJson(out);
+                    }
+                    else if (mode == COHERENCE_SIM) {
+                        coherence->writeStatsJson(out);
+                    }
+                    else if (mode == CO_SIM) {
+                        cosim->writeStatsJson(out);
+                    }
+                    else {
+                        vm->writeStatsJson(out);
+                    }
+                    out << "\n}\n";
+                    std::cout << "Statistics written to " << path << "\n";
+                }
+                else if (mode == STANDARD_ALLOCATOR && memManager) {
+                    memManager->stats();
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    buddyAllocator->stats();
+                }
+                else if (mode == CACHE_SIM && cache) {
+                    cache->stats();
+                }
+                else if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                    vm->stats();
+                }
+                else if (mode == MULTI_PROCESS_VM_SIM && mpvm) {
+                    mpvm->stats();
+                }
+                else if (mode == COHERENCE_SIM && coherence) {
+                    coherence->stats();
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->stats();
+                }
+                else {
+                    std::cout << "Error: Simulator not initialized\n";
+                }
+                break;
+            }
+            case CMD_SAVE:
+            case CMD_LOAD: {
+                std::string path(tok.next());
+                if (path.empty()) {
+                    std::cout << "Error: Usage: " << cmd << " <file>\n";
+                    continue;
+                }
+                
+                bool done = false;
+                if (mode == MULTI_PROCESS_VM_SIM || mode == COHERENCE_SIM || mode == CO_SIM) {
+                    std::cout << "Error: Snapshots are not supported in "
+                              << (mode == COHERENCE_SIM ? "coherence" : mode == CO_SIM ? "co-simulation"
+                                                                                       : "multi-process VM")
+                              << " mode\n";
+                    continue;
+                }
+                if (cmd == "save") {
+                    if (mode == STANDARD_ALLOCATOR && memManager) done = memManager->save(path);
+                    else if (mode == BUDDY_ALLOCATOR && buddyAllocator) done = buddyAllocator->save(path);
+                    else if (mode == CACHE_SIM && cache) done = cache->save(path);
+                    else if (mode == VIRTUAL_MEMORY_SIM && vm) done = vm->save(path);
+                    else {
+                        std::cout << "Error: Simulator not initialized\n";
+                        continue;
+                    }
+                }
+                else if (mode == STANDARD_ALLOCATOR) {
+                    if (!memManager) {
+                        memManager = std::make_unique<MemoryManager>();
+                    }
+                    done = memManager->load(path);
+                    // Arenas pointed into the replaced block list
+                    if (done && memArenas) memArenas->clear();
+                }
+                else if (mode == BUDDY_ALLOCATOR) {
+                    if (!buddyAllocator) {
+                        buddyAllocator = std::make_unique<BuddyAllocator>();
+                    }
+                    done = buddyAllocator->load(path);
+                    if (done && buddyArenas) buddyArenas->clear();
+                }
+                else if (mode == CACHE_SIM) {
+                    std::unique_ptr<CacheBase> loaded = loadCache(path);
+                    if (loaded) {
+                        cache = std::move(loaded);
+                        done = true;
+                    }
+                }
+                else {
+                    std::unique_ptr<VirtualMemory> loaded = VirtualMemory::load(path);
+                    if (loaded) {
+                        vm = std::move(loaded);
+                        done = true;
+                    }
+                }
+                
+                if (done) {
+                    std::cout << "State " << (cmd == "save" ? "saved to " : "loaded from ") << path << "\n";
+                }
+                break;
+            }
+            case CMD_SAMPLE: {
+                std::string_view arg = tok.next();
+                std::string path(tok.next());
+                
+                bool ready = (mode == STANDARD_ALLOCATOR && memManager) ||
+                             (mode == BUDDY_ALLOCATOR && buddyAllocator) ||
+                             (mode == CACHE_SIM && cache) ||
+                             (mode == VIRTUAL_MEMORY_SIM && vm) ||
+                             (mode == MULTI_PROCESS_VM_SIM && mpvm) ||
+                             (mode == COHERENCE_SIM && coherence);
+                if (mode == CO_SIM) {
+                    std::cout << "Error: Sampling is not supported in co-simulation mode\n";
+                }
+                else if (!ready) {
+                    std::cout << "Error: Simulator not initialized\n";
+                }
+                else if (arg == "off") {
+                    if (mode == STANDARD_ALLOCATOR) memManager->stopSampling();
+                    else if (mode == BUDDY_ALLOCATOR) buddyAllocator->stopSampling();
+                    else if (mode == CACHE_SIM) cache->stopSampling();
+                    else if (mode == MULTI_PROCESS_VM_SIM) mpvm->stopSampling();
+                    else if (mode == COHERENCE_SIM) coherence->stopSampling();
+                    else vm->stopSampling();
+                    std::cout << "Sampling stopped\n";
+                }
+                else {
+                    size_t interval = 0;
+                    CommandTokenizer::parse(arg, interval);
+                    if (interval == 0 || path.empty()) {
+                        std::cout << "Error: Usage: sample <interval> <file.csv|file.jsonl> or sample off\n";
+                        continue;
+                    }
+                    
+                    bool opened = false;
+                    if (mode == STANDARD_ALLOCATOR) opened = memManager->startSampling(path, interval);
+                    else if (mode == BUDDY_ALLOCATOR) opened = buddyAllocator->startSampling(path, interval);
+                    else if (mode == CACHE_SIM) opened = cache->startSampling(path, interval);
+                    else if (mode == MULTI_PROCESS_VM_SIM) opened = mpvm->startSampling(path, interval);
+                    else if (mode == COHERENCE_SIM) opened = coherence->startSampling(path, interval);
+                    else opened = vm->startSampling(path, interval);
+                    
+                    if (opened) {
+                        std::cout << "Sampling every " << interval << " operations to " << path << "\n";
+                    } else {
+                        std::cout << "Error: Cannot write " << path << "\n";
+                    }
+                }
+                break;
+            }
+            case CMD_COMPACT: {
+                size_t max_bytes = SIZE_MAX;
+                tok.next(max_bytes);
+                
+                if (mode == STANDARD_ALLOCATOR && memManager) {
+                    CompactionResult result = memManager->compact(max_bytes);
+                    for (const Relocation& r : result.relocations) {
+                        std::cout << "Block " << r.id << ": 0x" << std::hex << std::setfill('0')
+                                  << std::setw(4) << r.old_address << " -> 0x" << std::setw(4)
+                                  << r.new_address << std::dec << " (" << r.size << " bytes)\n";
+                    }
+                    if (memArenas) {
+                        memArenas->relocate(result.relocations);
+                    }
+                    std::cout << "Compaction moved " << result.relocations.size() << " blocks ("
+                              << result.bytes_moved << " bytes)"
+                              << (result.complete ? ", memory fully compacted\n"
+                                                  : ", byte budget left blocks in place\n");
+                }
+                else {
+                    std::cout << "Error: Not in standard allocator mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_REPLAY: {
+                std::string path(tok.next());
+                if (path.empty()) {
+                    std::cout << "Error: Usage: replay <file>\n";
+                }
+                else if (mode == STANDARD_ALLOCATOR && memManager) {
+                    replayAllocTrace(path, *memManager);
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    replayAllocTrace(path, *buddyAllocator);
+                }
+                else {
+                    std::cout << "Error: Not in allocator mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_ARENA: {
+                std::string_view sub_cmd = tok.next();
+                
+                ArenaManager* arenas = nullptr;
+                if (mode == STANDARD_ALLOCATOR && memManager) {
+                    if (!memArenas) {
+                        memArenas = std::make_unique<ArenaManager>(*memManager);
+                    }
+                    arenas = memArenas.get();
+                }
+                else if (mode == BUDDY_ALLOCATOR && buddyAllocator) {
+                    if (!buddyArenas) {
+                        buddyArenas = std::make_unique<ArenaManager>(*buddyAllocator);
+                    }
+                    arenas = buddyArenas.get();
+                }
+                
+                if (!arenas) {
+                    std::cout << "Error: Not in allocator mode or not initialized\n";
+                }
+                else if (sub_cmd == "create") {
+                    size_t size = 0;
+                    tok.next(size);
+                    arenas->create(size);
+                }
+                else if (sub_cmd == "alloc") {
+                    int arena_id = 0;
+                    size_t size = 0;
+                    tok.next(arena_id);
+                    tok.next(size);
+                    arenas->allocate(arena_id, size);
+                }
+                else if (sub_cmd == "reset") {
+                    int arena_id = 0;
+                    tok.next(arena_id);
+                    arenas->reset(arena_id);
+                }
+                else if (sub_cmd == "destroy") {
+                    int arena_id = 0;
+                    tok.next(arena_id);
+                    arenas->destroy(arena_id);
+                }
+                else if (sub_cmd == "stats") {
+                    int arena_id = 0;
+                    if (tok.next(arena_id)) {
+                        arenas->stats(arena_id);
+                    } else {
+                        arenas->stats();
+                    }
+                }
+                else {
+                    std::cout << "Unknown arena command: " << sub_cmd << "\n";
+                }
+                break;
+            }
+            // Cache commands
+            case CMD_ACCESS: {
+                size_t address = 0;
+                if (mode == COHERENCE_SIM) {
+                    size_t core = 0;
+                    bool valid = tok.next(core) && tok.next(address);
+                    bool write = tok.next() == "w";
+                    
+                    if (!valid) {
+                        std::cout << "Error: Usage: access <core> <address> [r|w]\n";
+                    }
+                    else if (!coherence) {
+                        std::cout << "Error: Not in coherence mode or not initialized\n";
+                    }
+                    else if (core >= coherence->getCores()) {
+                        std::cout << "Error: No core " << core << " (" << coherence->getCores() << " cores)\n";
+                    }
+                    else {
+                        bool hit = coherence->access(core, address, write);
+                        std::cout << "Core " << core << (write ? " write" : " read") << " 0x" << std::hex
+                                  << address << std::dec << ": " << (hit ? "HIT" : "MISS") << ", now "
+                                  << lineStateName(coherence->stateOf(core, address)) << "\n";
+                    }
+                    break;
+                }
+                
+                if (!tok.next(address)) {
+                    std::cout << "Error: Usage: access <address>\n";
+                }
+                else if (mode == CACHE_SIM && cache) {
+                    bool hit = cache->access(address);
+                    std::cout << "Address 0x" << std::hex << address << std::dec << ": "
+                              << (!cache->lastAccessSimulated() ? "not sampled" : hit ? "HIT" : "MISS")
+                              << "\n";
+                }
+                else {
+                    std::cout << "Error: Not in cache mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_RESET: {
+                if (mode == CACHE_SIM && cache) {
+                    cache->reset();
+                    std::cout << "Cache statistics reset\n";
+                }
+                else if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                    vm->reset();
+                    std::cout << "Virtual memory statistics reset\n";
+                }
+                else if (mode == MULTI_PROCESS_VM_SIM && mpvm) {
+                    mpvm->reset();
+                    std::cout << "Multi-process VM paged out and statistics reset\n";
+                }
+                else if (mode == COHERENCE_SIM && coherence) {
+                    coherence->reset();
+                    std::cout << "Private caches emptied and statistics reset\n";
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->reset();
+                    std::cout << "Trace cleared, memory and cache reset\n";
+                }
+                else {
+                    std::cout << "Error: Reset not available in this mode\n";
+                }
+                break;
+            }
+            // Co-simulation commands
+            case CMD_TOUCH: {
+                size_t object = 0, offset = 0, bytes = 1;
+                bool valid = tok.next(object) && tok.next(offset);
+                std::string_view length = tok.next();
+                if (!length.empty() && !CommandTokenizer::parse(length, bytes)) {
+                    valid = false;
+                }
+                
+                if (!valid) {
+                    std::cout << "Error: Usage: touch <object> <offset> [bytes]\n";
+                }
+                else if (mode == CO_SIM && cosim) {
+                    cosim->touch(object, offset, bytes);
+                }
+                else {
+                    std::cout << "Error: Not in co-simulation mode or not initialized\n";
+                }
+                break;
+            }
+            case CMD_COMPARE: {
+                if (mode == CO_SIM && cosim) {
+                    cosim->compare();
+                }
+                else {
+                    std::cout << "Error: Not in co-simulation mode or not initialized\n";
+                }
+                break;
+            }
+            // Virtual memory commands
+            case CMD_PROCESS: {
+                std::string_view sub_cmd = tok.next();
+                
+                if (mode != MULTI_PROCESS_VM_SIM || !mpvm) {
+                    std::cout << "Error: Not in multi-process VM mode or not initialized\n";
+                }
+                else if (sub_cmd == "create") {
+                    size_t num_pages = 0;
+                    tok.next(num_pages);
+                    mpvm->createProcess(num_pages);
+                }
+                else if (sub_cmd == "fork") {
+                    int asid = 0;
+                    tok.next(asid);
+                    mpvm->forkProcess(asid);
+                }
+                else if (sub_cmd == "exit") {
+                    int asid = 0;
+                    tok.next(asid);
+                    mpvm->exitProcess(asid);
+                }
+                else {
+                    std::cout << "Unknown process command: " << sub_cmd << "\n";
+                }
+                break;
+            }
+            case CMD_TRANSLATE: {
+                size_t virt_addr = 0;
+                if (mode == MULTI_PROCESS_VM_SIM) {
+                    int asid = 0;
+                    bool valid = tok.next(asid) && tok.next(virt_addr);
+                    bool write = tok.next() == "w";
+                    
+                    if (!valid) {
+                        std::cout << "Error: Usage: translate <asid> <virt_addr> [r|w]\n";
+                        break;
+                    }
+                    if (!mpvm) {
+                        std::cout << "Error: Not in multi-process VM mode or not initialized\n";
+                        break;
+                    }
+                    size_t phys_addr = mpvm->translate(asid, virt_addr, write);
+                    if (phys_addr == SIZE_MAX) {
+                        std::cout << "Error: Failed to translate virtual address 0x" << std::hex << virt_addr
+                                  << std::dec << " for ASID " << asid << "\n";
+                    } else {
+                        std::cout << "ASID " << asid << ": virtual address 0x" << std::hex << virt_addr
+                                  << " -> Physical address 0x" << phys_addr << std::dec << "\n";
+                    }
+                    break;
+                }
+                
+                bool valid = tok.next(virt_addr);
+                bool write = tok.next() == "w";
+                
+                if (!valid) {
+                    std::cout << "Error: Usage: translate <virt_addr> [r|w]\n";
+                }
+                else if (mode == VIRTUAL_MEMORY_SIM && vm) {
+                    size_t phys_addr = vm->translate(virt_addr, write);
+                    if (phys_addr == SIZE_MAX) {
+                        std::cout << "Error: Failed to translate virtual address 0x" << std::hex << virt_addr << std::dec << "\n";
+                    } else {
+                        std::cout << "Virtual address 0x" << std::hex << virt_addr 
+                                  << std::dec << " -> Physical address 0x" << std::hex << phys_addr 
+                                  << std::dec << "\n";
+                    }
+                }
+                else {
+                    std::cout << "Error: Not in VM mode or not initialized\n";
+                }
+                break;
+            }
+            default: {
+                std::cout << "Unknown command: " << cmd << "\n";
+                std::cout << "Type 'help' for available commands\n";
+                break;
+            }
+        }
+    }
+    
+    // Write the final sample of any run still being recorded
+    if (memManager) memManager->stopSampling();
+    if (buddyAllocator) buddyAllocator->stopSampling();
+    if (cache) cache->stopSampling();
+    if (vm) vm->stopSampling();
+    if (mpvm) mpvm->stopSampling();
+    if (coherence) coherence->stopSampling();
+    
+    return 0;
 }
\ No newline at end of file
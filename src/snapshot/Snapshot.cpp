@@ -0,0 +1,157 @@
+#include "Snapshot.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_MMAP 1
+#endif
+
+static const size_t HEADER_WORDS = 4;
+
+SnapshotWriter::SnapshotWriter(const std::string& path, SnapshotKind kind)
+    : out(path, std::ios::out | std::ios::binary | std::ios::trunc) {
+    put(SNAPSHOT_MAGIC);
+    put(SNAPSHOT_VERSION);
+    put(kind);
+    put(SNAPSHOT_BYTE_ORDER);
+}
+
+void SnapshotWriter::putString(const std::string& s) {
+    put(s.size());
+    std::vector<uint64_t> padded((s.size() + 7) / 8, 0);
+    if (!s.empty()) {
+        std::memcpy(padded.data(), s.data(), s.size());
+    }
+    putArray(padded.data(), padded.size());
+}
+
+void SnapshotWriter::putPadding(size_t bytes) {
+    static const char zeros[sizeof(uint64_t)] = {};
+    out.write(zeros, (sizeof(uint64_t) - bytes % sizeof(uint64_t)) % sizeof(uint64_t));
+}
+
+SnapshotReader::SnapshotReader(const std::string& path, SnapshotKind kind)
+    : words(nullptr), num_words(0), position(0), mapping(nullptr), mapping_bytes(0) {
+#ifdef SNAPSHOT_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fail("cannot open " + path);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            mapping = p;
+            mapping_bytes = st.st_size;
+            words = static_cast<const uint64_t*>(p);
+            num_words = mapping_bytes / sizeof(uint64_t);
+        }
+    }
+    close(fd);
+#endif
+
+    // Fall back to reading the file when it cannot be mapped
+    if (!mapping) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            fail("cannot open " + path);
+            return;
+        }
+        std::streamsize bytes = in.tellg();
+        in.seekg(0);
+        copy.resize(bytes / sizeof(uint64_t));
+        in.read(reinterpret_cast<char*>(copy.data()), copy.size() * sizeof(uint64_t));
+        words = copy.data();
+        num_words = copy.size();
+    }
+
+    if (num_words < HEADER_WORDS || words[0] != SNAPSHOT_MAGIC) {
+        fail(path + " is not a simulator snapshot");
+    } else if (words[3] != SNAPSHOT_BYTE_ORDER) {
+        fail(path + " was written on a host with a different byte order");
+    } else if (words[1] != SNAPSHOT_VERSION) {
+        fail(path + " has snapshot version " + std::to_string(words[1]) +
+             ", expected " + std::to_string(SNAPSHOT_VERSION));
+    } else if (words[2] != (uint64_t)kind) {
+        fail(path + " holds a different simulator's state");
+    }
+    position = HEADER_WORDS;
+}
+
+SnapshotReader::~SnapshotReader() {
+#ifdef SNAPSHOT_MMAP
+    if (mapping) {
+        munmap(mapping, mapping_bytes);
+    }
+#endif
+}
+
+void SnapshotReader::fail(const std::string& message) {
+    if (error_message.empty()) {
+        error_message = message;
+    }
+}
+
+bool SnapshotReader::get(uint64_t& value) {
+    const uint64_t* p = getArray(1);
+    if (!p) {
+        return false;
+    }
+    value = *p;
+    return true;
+}
+
+const uint64_t* SnapshotReader::getArray(size_t count) {
+    if (!ok()) {
+        return nullptr;
+    }
+    if (count > num_words - position) {
+        fail("snapshot is truncated");
+        return nullptr;
+    }
+    const uint64_t* p = words + position;
+    position += count;
+    return p;
+}
+
+const uint64_t* SnapshotReader::getRecords(uint64_t count, size_t width) {
+    if (width > 0 && count > num_words / width) {
+        fail("snapshot is truncated");
+        return nullptr;
+    }
+    return getArray(count * width);
+}
+
+bool SnapshotReader::checkRecords(uint64_t count, uint64_t size, size_t expected) {
+    if (size != expected) {
+        fail("snapshot records are " + std::to_string(size) + " bytes, expected " +
+             std::to_string(expected));
+        return false;
+    }
+    if (count > num_words * sizeof(uint64_t) / expected) {
+        fail("snapshot is truncated");
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::getString(std::string& s) {
+    uint64_t length = 0;
+    if (!get(length)) {
+        return false;
+    }
+    if (length > num_words * sizeof(uint64_t)) {
+        fail("snapshot is truncated");
+        return false;
+    }
+    const uint64_t* p = getArray((length + 7) / 8);
+    if (!p) {
+        return false;
+    }
+    s.assign(reinterpret_cast<const char*>(p), length);
+    return true;
+}
@@ -0,0 +1,99 @@
+#include "Histogram.h"
+#include "Snapshot.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+Histogram::Histogram() {
+    reset();
+}
+
+void Histogram::reset() {
+    counts.fill(0);
+    count = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = index / SUB_BUCKETS - 1;
+    uint64_t lower = uint64_t(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the value we are after, 1-based
+    uint64_t rank = (uint64_t)std::ceil(q * count);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t bound = bucketUpperBound(i);
+            if (bound > max_value) bound = max_value;
+            if (bound < min_value) bound = min_value;
+            return bound;
+        }
+    }
+    return max_value;
+}
+
+void Histogram::print(const std::string& label, const std::string& unit) const {
+    std::cout << label << ": ";
+    if (count == 0) {
+        std::cout << "no samples\n";
+        return;
+    }
+    std::cout << "count " << count << ", min " << getMin()
+              << ", p50 " << percentile(0.50) << ", p99 " << percentile(0.99)
+              << ", p99.9 " << percentile(0.999) << ", max " << max_value
+              << " " << unit << "\n";
+}
+
+void Histogram::writeJson(std::ostream& out) const {
+    out << "{\"count\": " << count << ", \"min\": " << getMin()
+        << ", \"mean\": " << std::fixed << std::setprecision(2) << getMean()
+        << ", \"p50\": " << percentile(0.50) << ", \"p99\": " << percentile(0.99)
+        << ", \"p999\": " << percentile(0.999) << ", \"max\": " << max_value
+        << ", \"buckets\": [";
+    bool first = true;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << "[" << bucketUpperBound(i) << ", " << counts[i] << "]";
+        first = false;
+    }
+    out << "]}";
+}
+
+void Histogram::save(SnapshotWriter& out) const {
+    out.put(count);
+    out.put(sum);
+    out.put(min_value);
+    out.put(max_value);
+    out.putArray(counts.data(), NUM_BUCKETS);
+}
+
+bool Histogram::load(SnapshotReader& in) {
+    const uint64_t* p = in.getArray(4 + NUM_BUCKETS);
+    if (!p) {
+        return false;
+    }
+    count = p[0];
+    sum = p[1];
+    min_value = p[2];
+    max_value = p[3];
+    std::copy(p + 4, p + 4 + NUM_BUCKETS, counts.begin());
+    return true;
+}
@@ -0,0 +1,214 @@
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+
+#ifndef MEMSIM_PROFILE
+
+bool profileCompiled() {
+    return false;
+}
+
+void profileReport() {
+    std::cout << "Error: Profiling probes are not compiled in (rebuild with make clean && make PROFILE=1)\n";
+}
+
+void profileReset() {
+    profileReport();
+}
+
+#else
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+Histogram probe_histograms[NUM_PROBES];
+
+static const char* const PROBE_NAMES[NUM_PROBES] = {
+    "malloc search length",
+    "coalesce merges per free",
+    "buddy splits per allocation",
+    "buddy merges per free",
+    "cache ways per lookup",
+    "page-table entries per translation",
+    "page victim scan length",
+};
+
+static const size_t NUM_COUNTERS = 4;
+static const char* const COUNTER_NAMES[NUM_COUNTERS] = {
+    "cycles", "instructions", "cache misses", "branch misses"
+};
+
+struct PhaseTotals {
+    std::string name;
+    size_t calls = 0;
+    uint64_t totals[1 + NUM_COUNTERS] = {};  // wall ns, then the counters
+};
+
+static std::vector<PhaseTotals> phases;
+
+// Hardware counters for this thread, opened on first use. Each counter is
+// opened on its own so a PMU without one of them still reports the rest.
+class PerfCounters {
+public:
+    PerfCounters() {
+        for (size_t i = 0; i < NUM_COUNTERS; i++) fds[i] = -1;
+#ifdef __linux__
+        static const uint64_t configs[NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fds[i] == -1 && error.empty()) {
+                error = std::strerror(errno);
+            }
+        }
+#else
+        error = "not supported on this platform";
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            if (fds[i] != -1) close(fds[i]);
+        }
+#endif
+    }
+
+    bool available(size_t i) const { return fds[i] != -1; }
+    const std::string& openError() const { return error; }
+
+    void read(uint64_t* values) const {
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            values[i] = 0;
+#ifdef __linux__
+            if (fds[i] != -1 && ::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i])) {
+                values[i] = 0;
+            }
+#endif
+        }
+    }
+
+private:
+    int fds[NUM_COUNTERS];
+    std::string error;
+};
+
+static PerfCounters& counters() {
+    static PerfCounters instance;
+    return instance;
+}
+
+static uint64_t wallNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ProfilePhase::ProfilePhase(const std::string& name) {
+    index = phases.size();
+    for (size_t i = 0; i < phases.size(); i++) {
+        if (phases[i].name == name) {
+            index = i;
+            break;
+        }
+    }
+    if (index == phases.size()) {
+        phases.emplace_back();
+        phases.back().name = name;
+    }
+    counters().read(start + 1);
+    start[0] = wallNs();
+}
+
+ProfilePhase::~ProfilePhase() {
+    uint64_t end[1 + NUM_COUNTERS];
+    end[0] = wallNs();
+    counters().read(end + 1);
+    PhaseTotals& phase = phases[index];
+    phase.calls++;
+    for (size_t i = 0; i < 1 + NUM_COUNTERS; i++) {
+        phase.totals[i] += end[i] - start[i];
+    }
+}
+
+bool profileCompiled() {
+    return true;
+}
+
+void profileReport() {
+    std::cout << "\n=== Profile ===\n";
+    std::cout << "Probes:\n";
+    for (size_t p = 0; p < NUM_PROBES; p++) {
+        const Histogram& h = probe_histograms[p];
+        std::cout << "  " << std::setfill(' ') << std::left << std::setw(36) << PROBE_NAMES[p] << std::right;
+        if (h.getCount() == 0) {
+            std::cout << "no samples\n";
+            continue;
+        }
+        std::cout << "count " << h.getCount() << ", mean " << std::fixed << std::setprecision(2)
+                  << h.getMean() << ", total " << std::setprecision(0) << h.getMean() * h.getCount()
+                  << ", p50 " << h.percentile(0.50) << ", p99 " << h.percentile(0.99)
+                  << ", max " << h.getMax() << "\n";
+    }
+
+    std::cout << "Phases:\n";
+    const PerfCounters& perf = counters();
+    bool any = false;
+    for (const PhaseTotals& phase : phases) {
+        // A phase still open, like the command printing this, has no calls yet
+        if (phase.calls == 0) continue;
+        any = true;
+        std::cout << "  " << phase.name << ": " << phase.calls << " call"
+                  << (phase.calls == 1 ? "" : "s") << ", " << std::fixed << std::setprecision(3)
+                  << phase.totals[0] / 1e6 << " ms";
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            if (perf.available(i)) {
+                std::cout << ", " << phase.totals[1 + i] << " " << COUNTER_NAMES[i];
+            }
+        }
+        if (perf.available(0) && perf.available(1) && phase.totals[1] > 0) {
+            std::cout << ", IPC " << std::setprecision(2) << (double)phase.totals[2] / phase.totals[1];
+        }
+        std::cout << "\n";
+    }
+    if (!any) {
+        std::cout << "  none\n";
+    }
+    if (!perf.openError().empty()) {
+        std::cout << "Unavailable counters:";
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            if (!perf.available(i)) std::cout << " " << COUNTER_NAMES[i];
+        }
+        std::cout << " (" << perf.openError() << "; on Linux check /proc/sys/kernel/perf_event_paranoid)\n";
+    }
+    std::cout << "===============\n\n";
+}
+
+void profileReset() {
+    for (Histogram& h : probe_histograms) {
+        h.reset();
+    }
+    // Phases stay registered: one may be open, e.g. a script resetting itself
+    for (PhaseTotals& phase : phases) {
+        phase.calls = 0;
+        for (uint64_t& total : phase.totals) total = 0;
+    }
+    std::cout << "Profile probes and phases reset\n";
+}
+
+#endif // MEMSIM_PROFILE
@@ -0,0 +1,216 @@
+#include "ReuseDistance.h"
+#include "Snapshot.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+ReuseDistance::ReuseDistance()
+    : threshold(UINT64_MAX), scale(1.0), tracked(0), next_position(0), generation(1),
+      first_touches(0) {}
+
+void ReuseDistance::reset() {
+    threshold = UINT64_MAX;
+    scale = 1.0;
+    std::fill(last_bits.begin(), last_bits.end(), 0);
+    std::fill(group_counts.begin(), group_counts.end(), 0);
+    by_hash.clear();
+    tracked = 0;
+    next_position = 0;
+    hist.reset();
+    first_touches = 0;
+
+    // Only when the 16-bit generation wraps are the slots cleared here
+    if (++generation == 0) {
+        generation = 1;
+        std::fill(slots.begin(), slots.end(), Slot());
+    }
+}
+
+void ReuseDistance::allocate() {
+    if (slots.empty()) {
+        slots.assign(TABLE_SIZE, Slot());
+        last_bits.assign(POSITIONS / 64, 0);
+        group_counts.assign(POSITIONS >> GROUP_BITS, 0);
+        owner.assign(POSITIONS, 0);
+        by_hash.reserve(MAX_TRACKED + 1);
+    }
+}
+
+void ReuseDistance::sampledAccess(uint64_t block, uint64_t h) {
+    allocate();
+    if (next_position == POSITIONS) {
+        renumber();
+    }
+
+    size_t slot = findSlot(block, h);
+    if (live(slot)) {
+        uint32_t last = slots[slot].position;
+        hist.record((uint64_t)std::llround(countAfter(last) * scale));
+        clearLast(last);
+        slots[slot].position = next_position;
+        setLast(next_position++, slot);
+    } else {
+        first_touches++;
+        track(slot, block, h);
+        std::push_heap(by_hash.begin(), by_hash.end());
+    }
+
+    if (tracked > MAX_TRACKED) {
+        dropLargestHash();
+    }
+}
+
+size_t ReuseDistance::countAfter(uint32_t position) const {
+    // Rest of the position's word, the rest of its group, then whole groups
+    size_t word = position >> 6;
+    size_t count = __builtin_popcountll(last_bits[word] >> (position & 63) >> 1);
+    size_t group = position >> GROUP_BITS;
+    size_t group_end = (group + 1) << (GROUP_BITS - 6);
+    for (word++; word < group_end; word++) {
+        count += __builtin_popcountll(last_bits[word]);
+    }
+    size_t last_group = next_position > 0 ? (next_position - 1) >> GROUP_BITS : 0;
+    for (group++; group <= last_group; group++) {
+        count += group_counts[group];
+    }
+    return count;
+}
+
+size_t ReuseDistance::findSlot(uint64_t block, uint64_t h) const {
+    size_t slot = h & (TABLE_SIZE - 1);
+    while (live(slot) && slots[slot].block != block) {
+        slot = (slot + 1) & (TABLE_SIZE - 1);
+    }
+    return slot;
+}
+
+// Backward-shift deletion: later slots of the same probe run move up so
+// lookups never stop early at the gap
+void ReuseDistance::eraseSlot(size_t slot) {
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & (TABLE_SIZE - 1);
+        if (!live(next)) {
+            break;
+        }
+        size_t home = hash(slots[next].block) & (TABLE_SIZE - 1);
+        bool stays = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+        if (!stays) {
+            slots[slot] = slots[next];
+            owner[slots[slot].position] = slot;
+            slot = next;
+        }
+    }
+    slots[slot].generation = 0;
+}
+
+// Start tracking a block in an empty slot, as the newest access; the
+// caller restores the heap
+void ReuseDistance::track(size_t slot, uint64_t block, uint64_t h) {
+    slots[slot] = {block, next_position, generation};
+    setLast(next_position++, slot);
+    tracked++;
+    by_hash.push_back({h, block});
+}
+
+// Lower the threshold to the largest tracked hash and drop every block at
+// or above it
+void ReuseDistance::dropLargestHash() {
+    threshold = by_hash.front().first;
+    while (!by_hash.empty() && by_hash.front().first >= threshold) {
+        std::pop_heap(by_hash.begin(), by_hash.end());
+        std::pair<uint64_t, uint64_t> largest = by_hash.back();
+        by_hash.pop_back();
+        size_t slot = findSlot(largest.second, largest.first);
+        clearLast(slots[slot].position);
+        eraseSlot(slot);
+        tracked--;
+    }
+    scale = std::ldexp(1.0, 64) / std::max<uint64_t>(threshold, 1);
+}
+
+// Positions ran out: number the tracked blocks 0..n-1 in access order
+void ReuseDistance::renumber() {
+    uint32_t renumbered = 0;
+    for (uint32_t position = 0; position < next_position; position++) {
+        if (last_bits[position >> 6] >> (position & 63) & 1) {
+            uint16_t slot = owner[position];
+            slots[slot].position = renumbered;
+            owner[renumbered++] = slot;
+        }
+    }
+    std::fill(last_bits.begin(), last_bits.end(), 0);
+    std::fill(group_counts.begin(), group_counts.end(), 0);
+    for (uint32_t position = 0; position < renumbered; position++) {
+        setLast(position, owner[position]);
+    }
+    next_position = renumbered;
+}
+
+void ReuseDistance::print(const std::string& label) const {
+    hist.print(label, "blocks");
+    std::cout << label << " sampling: ";
+    if (threshold == UINT64_MAX) {
+        std::cout << "every block";
+    } else {
+        std::cout << "1 in " << std::fixed << std::setprecision(2) << scale << " blocks";
+    }
+    std::cout << ", " << first_touches << " first touches\n";
+}
+
+void ReuseDistance::writeJson(std::ostream& out) const {
+    out << "{\"sampling_rate\": " << std::fixed << std::setprecision(6) << samplingRate()
+        << ", \"first_touches\": " << first_touches << ", \"distance\": ";
+    hist.writeJson(out);
+    out << "}";
+}
+
+void ReuseDistance::save(SnapshotWriter& out) const {
+    out.put(threshold);
+    out.put(first_touches);
+    hist.save(out);
+
+    // Tracked blocks oldest first
+    out.put(tracked);
+    for (uint32_t position = 0; position < next_position; position++) {
+        if (last_bits[position >> 6] >> (position & 63) & 1) {
+            out.put(slots[owner[position]].block);
+        }
+    }
+}
+
+bool ReuseDistance::load(SnapshotReader& in) {
+    uint64_t saved_threshold = 0, saved_first_touches = 0, count = 0;
+    Histogram saved_hist;
+    if (!in.get(saved_threshold) || !in.get(saved_first_touches) || !saved_hist.load(in) ||
+        !in.get(count)) {
+        return false;
+    }
+    const uint64_t* blocks = count <= MAX_TRACKED ? in.getArray(count) : nullptr;
+    if (!blocks) {
+        in.fail("snapshot reuse distance table is inconsistent");
+        return false;
+    }
+
+    reset();
+    allocate();
+    for (size_t i = 0; i < count; i++) {
+        uint64_t h = hash(blocks[i]);
+        size_t slot = findSlot(blocks[i], h);
+        if (h >= saved_threshold || live(slot)) {
+            reset();
+            in.fail("snapshot reuse distance table is inconsistent");
+            return false;
+        }
+        track(slot, blocks[i], h);
+    }
+    std::make_heap(by_hash.begin(), by_hash.end());
+    threshold = saved_threshold;
+    if (threshold != UINT64_MAX) {
+        scale = std::ldexp(1.0, 64) / std::max<uint64_t>(threshold, 1);
+    }
+    first_touches = saved_first_touches;
+    hist = saved_hist;
+    return true;
+}
@@ -0,0 +1,77 @@
+#include "SampleWriter.h"
+#include <cstdio>
+
+SampleWriter::SampleWriter() : csv(false), rows(0), interval(0), countdown(0) {}
+
+SampleWriter::~SampleWriter() {
+    close();
+}
+
+bool SampleWriter::open(const std::string& file_path, const std::vector<std::string>& names,
+                        size_t every) {
+    close();
+    if (every == 0) {
+        return false;
+    }
+    file.open(file_path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    path = file_path;
+    columns = names;
+    rows = 0;
+    interval = every;
+    countdown = every;
+    csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    buffer.clear();
+    buffer.reserve(FLUSH_BYTES + 1024);
+
+    if (csv) {
+        for (size_t i = 0; i < columns.size(); i++) {
+            buffer += (i > 0 ? "," : "") + columns[i];
+        }
+        buffer += '\n';
+    }
+    return true;
+}
+
+void SampleWriter::write(const double* values) {
+    if (!file.is_open()) {
+        return;
+    }
+
+    // %.15g prints counters exactly and ratios without trailing zeros
+    char number[32];
+    if (!csv) buffer += '{';
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (i > 0) buffer += csv ? "," : ", ";
+        if (!csv) {
+            buffer += '"';
+            buffer += columns[i];
+            buffer += "\": ";
+        }
+        std::snprintf(number, sizeof(number), "%.15g", values[i]);
+        buffer += number;
+    }
+    buffer += csv ? "\n" : "}\n";
+    rows++;
+
+    if (buffer.size() >= FLUSH_BYTES) {
+        flush();
+    }
+}
+
+void SampleWriter::flush() {
+    file.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void SampleWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    flush();
+    file.close();
+    interval = 0;
+}
@@ -0,0 +1,110 @@
+#include "AllocTrace.h"
+#include "MemoryManager.h"
+#include "BuddyAllocator.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <unordered_map>
+
+bool readAllocTrace(const std::string& path, AllocTraceHeader& header,
+                    std::vector<AllocTraceRecord>& records) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cout << "Error: Cannot open " << path << "\n";
+        return false;
+    }
+    size_t file_bytes = in.tellg();
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != ALLOC_TRACE_MAGIC) {
+        std::cout << "Error: " << path << " is not an allocation trace\n";
+        return false;
+    }
+    if (header.version != ALLOC_TRACE_VERSION || header.record_bytes != sizeof(AllocTraceRecord)) {
+        std::cout << "Error: " << path << " is trace version " << header.version << " with "
+                  << header.record_bytes << " byte records, expected version " << ALLOC_TRACE_VERSION
+                  << " with " << sizeof(AllocTraceRecord) << "\n";
+        return false;
+    }
+
+    // A process killed mid-write can leave a partial record at the end
+    records.resize((file_bytes - sizeof(header)) / sizeof(AllocTraceRecord));
+    if (!in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(AllocTraceRecord))) {
+        std::cout << "Error: Cannot read " << path << "\n";
+        return false;
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const AllocTraceRecord& a, const AllocTraceRecord& b) {
+                         return a.time_ns < b.time_ns;
+                     });
+    return true;
+}
+
+// Shared by both allocators: alloc(size) returns a block id or -1,
+// release(id) frees it
+template <typename Alloc, typename Release>
+static bool replay(const std::string& path, Alloc alloc, Release release) {
+    AllocTraceHeader header;
+    std::vector<AllocTraceRecord> records;
+    if (!readAllocTrace(path, header, records)) {
+        return false;
+    }
+
+    // Traced address -> simulated block id, -1 if the simulated allocation
+    // failed, so the block's free still matches
+    std::unordered_map<uint64_t, int> live;
+    size_t allocations = 0, reallocs = 0, aligned = 0, failed = 0, frees = 0, untraced_frees = 0;
+    size_t threads = 0;
+    for (const AllocTraceRecord& record : records) {
+        threads = std::max<size_t>(threads, record.thread + 1);
+        auto it = live.find(record.address);
+        if (record.op == TRACE_FREE && it == live.end()) {
+            untraced_frees++;
+            continue;
+        }
+        // An allocation of a live address means its free tied in time and
+        // sorted after it; free it first either way
+        if (it != live.end()) {
+            if (it->second >= 0) {
+                release(it->second);
+            }
+            live.erase(it);
+            frees++;
+        }
+        if (record.op == TRACE_FREE) {
+            continue;
+        }
+
+        int id = alloc(std::max<size_t>(record.size, 1));
+        allocations++;
+        reallocs += record.op == TRACE_REALLOC;
+        aligned += record.op == TRACE_ALIGNED;
+        failed += id < 0;
+        live[record.address] = id;
+    }
+
+    double seconds = records.empty() ? 0.0 : records.back().time_ns / 1e9;
+    std::cout << "Replayed " << records.size() << " records of process " << header.pid << " from "
+              << threads << " thread" << (threads == 1 ? "" : "s") << " over " << std::fixed
+              << std::setprecision(3) << seconds << " s: " << allocations << " allocations ("
+              << reallocs << " by realloc, " << aligned << " aligned, " << failed << " failed), "
+              << frees << " frees, "
+              << untraced_frees << " frees of untraced blocks, " << live.size() << " blocks still live\n";
+    return true;
+}
+
+bool replayAllocTrace(const std::string& path, MemoryManager& memory) {
+    memory.setVerbose(false);
+    bool done = replay(path, [&](size_t size) { return memory.malloc(size); },
+                       [&](int id) { memory.free(id); });
+    memory.setVerbose(true);
+    return done;
+}
+
+bool replayAllocTrace(const std::string& path, BuddyAllocator& buddy) {
+    buddy.setVerbose(false);
+    bool done = replay(path, [&](size_t size) { return buddy.allocate(size); },
+                       [&](int id) { buddy.free(id); });
+    buddy.setVerbose(true);
+    return done;
+}
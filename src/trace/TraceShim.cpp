@@ -0,0 +1,340 @@
+// LD_PRELOAD allocation tracer. Interposes malloc, calloc, realloc, free
+// and the aligned allocators (posix_memalign, aligned_alloc, memalign,
+// valloc), and appends an AllocTraceRecord per call to the trace file:
+//
+//   LD_PRELOAD=bin/libmemsim_trace.so MEMSIM_TRACE=app.%p.trace ./app
+//
+// MEMSIM_TRACE names the file, %p standing for the process id (default
+// memsim_trace.%p.bin). Each thread fills its own buffer without locks and
+// appends it with one O_APPEND write when full, at thread exit and at
+// process exit. A forked child traces to its own file when the name has a
+// %p, and stops tracing otherwise.
+//
+// Nothing here may call malloc: buffers come from mmap and the file name
+// is formatted by hand.
+
+#include "AllocTrace.h"
+#include <atomic>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <new>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+using MallocFn = void* (*)(size_t);
+using CallocFn = void* (*)(size_t, size_t);
+using ReallocFn = void* (*)(void*, size_t);
+using FreeFn = void (*)(void*);
+using PosixMemalignFn = int (*)(void**, size_t, size_t);
+using AlignedAllocFn = void* (*)(size_t, size_t);  // aligned_alloc and memalign
+using VallocFn = void* (*)(size_t);
+
+MallocFn real_malloc;
+CallocFn real_calloc;
+ReallocFn real_realloc;
+FreeFn real_free;
+PosixMemalignFn real_posix_memalign;
+AlignedAllocFn real_aligned_alloc;
+AlignedAllocFn real_memalign;
+VallocFn real_valloc;
+
+// dlsym allocates before the real functions are known
+alignas(16) char bootstrap[4096];
+size_t bootstrap_used;
+bool resolving;
+
+const size_t BUFFER_RECORDS = 4096;  // 96 KiB per thread
+
+struct ThreadBuffer {
+    AllocTraceRecord records[BUFFER_RECORDS];
+    std::atomic<size_t> count;
+    std::atomic<bool> in_use;
+    uint16_t thread;
+    ThreadBuffer* next;  // every buffer ever made, for the flush at exit
+};
+
+std::atomic<bool> tracing(false);
+int trace_fd = -1;
+uint64_t start_ns;
+char trace_path[4096];
+std::atomic<ThreadBuffer*> all_buffers(nullptr);
+std::atomic<uint16_t> next_thread(0);
+pthread_key_t buffer_key;
+
+__thread ThreadBuffer* local_buffer __attribute__((tls_model("initial-exec")));
+__thread bool in_hook __attribute__((tls_model("initial-exec")));
+
+uint64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void resolve() {
+    resolving = true;
+    real_malloc = reinterpret_cast<MallocFn>(dlsym(RTLD_NEXT, "malloc"));
+    real_calloc = reinterpret_cast<CallocFn>(dlsym(RTLD_NEXT, "calloc"));
+    real_realloc = reinterpret_cast<ReallocFn>(dlsym(RTLD_NEXT, "realloc"));
+    real_free = reinterpret_cast<FreeFn>(dlsym(RTLD_NEXT, "free"));
+    real_posix_memalign = reinterpret_cast<PosixMemalignFn>(dlsym(RTLD_NEXT, "posix_memalign"));
+    real_aligned_alloc = reinterpret_cast<AlignedAllocFn>(dlsym(RTLD_NEXT, "aligned_alloc"));
+    real_memalign = reinterpret_cast<AlignedAllocFn>(dlsym(RTLD_NEXT, "memalign"));
+    real_valloc = reinterpret_cast<VallocFn>(dlsym(RTLD_NEXT, "valloc"));
+    resolving = false;
+}
+
+void* bootstrapAlloc(size_t size) {
+    size = (size + 15) & ~size_t(15);
+    if (bootstrap_used + size > sizeof(bootstrap)) {
+        return nullptr;
+    }
+    void* p = bootstrap + bootstrap_used;
+    bootstrap_used += size;
+    return p;
+}
+
+bool isBootstrap(void* p) {
+    return p >= static_cast<void*>(bootstrap) && p < static_cast<void*>(bootstrap + sizeof(bootstrap));
+}
+
+void writeAll(int fd, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n <= 0) return;
+        p += n;
+        bytes -= n;
+    }
+}
+
+void flush(ThreadBuffer* buffer) {
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    if (count > 0 && trace_fd >= 0) {
+        writeAll(trace_fd, buffer->records, count * sizeof(AllocTraceRecord));
+    }
+    buffer->count.store(0, std::memory_order_release);
+}
+
+// pthread key destructor: the thread is exiting
+void retireBuffer(void* arg) {
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(arg);
+    flush(buffer);
+    local_buffer = nullptr;
+    buffer->in_use.store(false, std::memory_order_release);
+}
+
+// Reuse the buffer of a thread that has exited, or map a new one
+ThreadBuffer* attachBuffer() {
+    ThreadBuffer* buffer = all_buffers.load(std::memory_order_acquire);
+    for (; buffer; buffer = buffer->next) {
+        bool expected = false;
+        if (!buffer->in_use.load(std::memory_order_relaxed) &&
+            buffer->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    if (!buffer) {
+        void* memory = mmap(nullptr, sizeof(ThreadBuffer), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        buffer = new (memory) ThreadBuffer();
+        buffer->in_use.store(true, std::memory_order_relaxed);
+        buffer->next = all_buffers.load(std::memory_order_relaxed);
+        while (!all_buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release)) {
+        }
+    }
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+    pthread_setspecific(buffer_key, buffer);
+    local_buffer = buffer;
+    return buffer;
+}
+
+void record(AllocTraceOp op, void* address, size_t size, uint64_t time, size_t alignment = 0) {
+    if (!tracing.load(std::memory_order_relaxed) || in_hook) {
+        return;
+    }
+    in_hook = true;
+    ThreadBuffer* buffer = local_buffer ? local_buffer : attachBuffer();
+    if (buffer) {
+        size_t n = buffer->count.load(std::memory_order_relaxed);
+        AllocTraceRecord& r = buffer->records[n];
+        r.time_ns = time - start_ns;
+        r.address = reinterpret_cast<uint64_t>(address);
+        r.size = size > UINT32_MAX ? UINT32_MAX : uint32_t(size);
+        r.thread = buffer->thread;
+        r.op = op;
+        r.align_shift = alignment > 0 ? __builtin_ctzll(alignment) : 0;
+        buffer->count.store(n + 1, std::memory_order_release);
+        if (n + 1 == BUFFER_RECORDS) {
+            flush(buffer);
+        }
+    }
+    in_hook = false;
+}
+
+// Replace %p in the configured name with the process id
+void formatPath(const char* pattern, bool& per_process) {
+    char pid[24];
+    size_t digits = 0;
+    for (unsigned long value = getpid(); value > 0 || digits == 0; value /= 10) {
+        pid[digits++] = char('0' + value % 10);
+    }
+    per_process = false;
+    size_t out = 0;
+    for (const char* c = pattern; *c && out + digits + 1 < sizeof(trace_path); c++) {
+        if (c[0] == '%' && c[1] == 'p') {
+            per_process = true;
+            for (size_t i = digits; i-- > 0;) trace_path[out++] = pid[i];
+            c++;
+        } else {
+            trace_path[out++] = *c;
+        }
+    }
+    trace_path[out] = '\0';
+}
+
+bool openTrace() {
+    const char* pattern = getenv("MEMSIM_TRACE");
+    bool per_process;
+    formatPath(pattern && *pattern ? pattern : "memsim_trace.%p.bin", per_process);
+    trace_fd = open(trace_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (trace_fd < 0) {
+        return false;
+    }
+    AllocTraceHeader header;
+    header.magic = ALLOC_TRACE_MAGIC;
+    header.version = ALLOC_TRACE_VERSION;
+    header.record_bytes = sizeof(AllocTraceRecord);
+    header.pid = getpid();
+    header.start_ns = clockNs(CLOCK_REALTIME);
+    start_ns = clockNs(CLOCK_MONOTONIC);
+    writeAll(trace_fd, &header, sizeof(header));
+    return true;
+}
+
+// The child keeps only the forking thread, and the parent's records stay
+// with the parent
+void atforkChild() {
+    for (ThreadBuffer* buffer = all_buffers.load(); buffer; buffer = buffer->next) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        if (buffer != local_buffer) {
+            buffer->in_use.store(false, std::memory_order_relaxed);
+        }
+    }
+    close(trace_fd);
+    trace_fd = -1;
+    const char* pattern = getenv("MEMSIM_TRACE");
+    bool per_process = !(pattern && *pattern) || std::strstr(pattern, "%p");
+    tracing.store(per_process && openTrace(), std::memory_order_relaxed);
+}
+
+__attribute__((constructor)) void startTrace() {
+    if (!real_malloc) resolve();
+    pthread_key_create(&buffer_key, retireBuffer);
+    pthread_atfork(nullptr, nullptr, atforkChild);
+    tracing.store(openTrace(), std::memory_order_release);
+}
+
+// Threads still running at exit may be mid-append; their buffers are
+// flushed as far as they have been committed
+__attribute__((destructor)) void stopTrace() {
+    tracing.store(false, std::memory_order_release);
+    for (ThreadBuffer* buffer = all_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        flush(buffer);
+    }
+    if (trace_fd >= 0) {
+        close(trace_fd);
+        trace_fd = -1;
+    }
+}
+
+}  // namespace
+
+extern "C" {
+
+void* malloc(size_t size) {
+    if (!real_malloc) {
+        if (resolving) return bootstrapAlloc(size);
+        resolve();
+    }
+    void* p = real_malloc(size);
+    if (p) record(TRACE_MALLOC, p, size, clockNs(CLOCK_MONOTONIC));
+    return p;
+}
+
+void* calloc(size_t count, size_t size) {
+    if (!real_calloc) {
+        if (resolving) return bootstrapAlloc(count * size);  // already zero
+        resolve();
+    }
+    void* p = real_calloc(count, size);
+    if (p) record(TRACE_CALLOC, p, count * size, clockNs(CLOCK_MONOTONIC));
+    return p;
+}
+
+void* realloc(void* old, size_t size) {
+    if (!real_realloc) {
+        if (resolving) return nullptr;
+        resolve();
+    }
+    if (isBootstrap(old)) {
+        // The old size is unknown; copy what the bootstrap area can hold
+        size_t available = bootstrap + sizeof(bootstrap) - static_cast<char*>(old);
+        void* p = malloc(size);
+        if (p) std::memcpy(p, old, size < available ? size : available);
+        return p;
+    }
+    uint64_t freed_at = clockNs(CLOCK_MONOTONIC);
+    void* p = real_realloc(old, size);
+    if (old && (p || size == 0)) record(TRACE_FREE, old, 0, freed_at);
+    if (p) record(old ? TRACE_REALLOC : TRACE_MALLOC, p, size, clockNs(CLOCK_MONOTONIC));
+    return p;
+}
+
+// dlsym never calls the aligned allocators, so they need no bootstrap path
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (!real_posix_memalign) resolve();
+    int error = real_posix_memalign(out, alignment, size);
+    if (error == 0) record(TRACE_ALIGNED, *out, size, clockNs(CLOCK_MONOTONIC), alignment);
+    return error;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (!real_aligned_alloc) resolve();
+    void* p = real_aligned_alloc(alignment, size);
+    if (p) record(TRACE_ALIGNED, p, size, clockNs(CLOCK_MONOTONIC), alignment);
+    return p;
+}
+
+void* memalign(size_t alignment, size_t size) {
+    if (!real_memalign) resolve();
+    void* p = real_memalign(alignment, size);
+    if (p) record(TRACE_ALIGNED, p, size, clockNs(CLOCK_MONOTONIC), alignment);
+    return p;
+}
+
+void* valloc(size_t size) {
+    if (!real_valloc) resolve();
+    void* p = real_valloc(size);
+    if (p) record(TRACE_ALIGNED, p, size, clockNs(CLOCK_MONOTONIC), getpagesize());
+    return p;
+}
+
+void free(void* p) {
+    if (!p || isBootstrap(p)) {
+        return;
+    }
+    record(TRACE_FREE, p, 0, clockNs(CLOCK_MONOTONIC));
+    if (!real_free) resolve();
+    real_free(p);
+}
+
+}  // extern "C"
@@ -0,0 +1,542 @@
+#include "MultiProcessVM.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+MultiProcessVM::MultiProcessVM(size_t page_size, size_t num_frames)
+    : page_size(page_size), num_frames(num_frames), policy(PAGE_FIFO), scope(SCOPE_GLOBAL),
+      verbose(true), frames_used(0), access_counter(0), total_faults(0), cow_copies(0),
+      thrash_window(1000), thrash_fault_pct(25.0), window_accesses(0), window_faults(0),
+      thrashing_windows(0), windows_evaluated(0), system_thrashing(false),
+      sample_accesses(0), sample_faults(0) {
+
+    frames.resize(num_frames);
+    for (FrameEntry& frame : frames) {
+        frame.used = false;
+        frame.backing = 0;
+        frame.owner = -1;
+        frame.loaded_at = 0;
+        frame.last_use = 0;
+    }
+
+    std::cout << "Multi-process virtual memory initialized: " << page_size
+              << " bytes per page, " << num_frames << " shared frames\n";
+}
+
+Process* MultiProcessVM::findProcess(int asid) {
+    if (asid < 1 || (size_t)asid > processes.size() || !processes[asid - 1].alive) {
+        return nullptr;
+    }
+    return &processes[asid - 1];
+}
+
+size_t MultiProcessVM::newBacking() {
+    backing_refs.push_back(1);
+    backing_frame.push_back(-1);
+    return backing_refs.size() - 1;
+}
+
+size_t MultiProcessVM::liveProcesses() const {
+    size_t live = 0;
+    for (const Process& process : processes) {
+        if (process.alive) live++;
+    }
+    return live;
+}
+
+int MultiProcessVM::createProcess(size_t num_pages) {
+    if (num_pages == 0) {
+        std::cout << "Error: A process needs at least one page\n";
+        return -1;
+    }
+
+    Process process;
+    process.asid = processes.size() + 1;
+    process.alive = true;
+    process.page_table.resize(num_pages);
+    for (ProcessPageEntry& entry : process.page_table) {
+        entry.backing = newBacking();
+    }
+    process.resident = 0;
+    process.accesses = 0;
+    process.major_faults = 0;
+    process.minor_faults = 0;
+    process.cow_copies = 0;
+    process.window_accesses = 0;
+    process.window_faults = 0;
+    process.thrashing_windows = 0;
+    process.thrashing = false;
+    processes.push_back(process);
+
+    std::cout << "Process created: ASID " << process.asid << " with " << num_pages << " pages\n";
+    return process.asid;
+}
+
+int MultiProcessVM::forkProcess(int parent_asid) {
+    Process* parent = findProcess(parent_asid);
+    if (!parent) {
+        std::cout << "Error: No live process with ASID " << parent_asid << "\n";
+        return -1;
+    }
+
+    // The child starts with the parent's page table; resident pages are
+    // mapped into the same frames and every page is shared until written
+    Process child = *parent;
+    child.asid = processes.size() + 1;
+    child.resident = 0;
+    child.accesses = 0;
+    child.major_faults = 0;
+    child.minor_faults = 0;
+    child.cow_copies = 0;
+    child.window_accesses = 0;
+    child.window_faults = 0;
+    child.thrashing_windows = 0;
+    child.thrashing = false;
+    for (size_t page = 0; page < child.page_table.size(); page++) {
+        const ProcessPageEntry& entry = child.page_table[page];
+        backing_refs[entry.backing]++;
+        if (entry.valid) {
+            frames[entry.frame].mappings.push_back({child.asid, page});
+        }
+    }
+    processes.push_back(child);
+
+    std::cout << "Process created: ASID " << child.asid << " forked from ASID " << parent_asid
+              << ", " << child.page_table.size() << " pages shared copy-on-write\n";
+    return child.asid;
+}
+
+bool MultiProcessVM::exitProcess(int asid) {
+    Process* process = findProcess(asid);
+    if (!process) {
+        std::cout << "Error: No live process with ASID " << asid << "\n";
+        return false;
+    }
+
+    for (size_t page = 0; page < process->page_table.size(); page++) {
+        ProcessPageEntry& entry = process->page_table[page];
+        if (entry.valid) {
+            unmap(entry.frame, asid, page);
+        }
+        backing_refs[entry.backing]--;
+    }
+    process->alive = false;
+    process->page_table.clear();
+    process->page_table.shrink_to_fit();
+
+    std::cout << "Process ASID " << asid << " exited\n";
+    return true;
+}
+
+void MultiProcessVM::setPolicy(PageReplacementPolicy new_policy) {
+    policy = new_policy;
+    std::cout << "Page replacement policy set to: " << (policy == PAGE_FIFO ? "FIFO" : "LRU") << "\n";
+}
+
+void MultiProcessVM::setScope(ReplacementScope new_scope) {
+    scope = new_scope;
+    std::cout << "Replacement scope set to: " << (scope == SCOPE_GLOBAL ? "global" : "local") << "\n";
+}
+
+void MultiProcessVM::setThrashing(size_t window, double fault_pct) {
+    thrash_window = window;
+    thrash_fault_pct = fault_pct;
+    std::cout << "Thrashing threshold: " << fault_pct << "% faults over " << window
+              << " accesses\n";
+}
+
+int MultiProcessVM::selectVictim(int owner) const {
+    MEMSIM_PROBE(PROBE_VICTIM_SCAN, num_frames);
+    int victim = -1;
+    size_t best = SIZE_MAX;
+    for (size_t i = 0; i < num_frames; i++) {
+        const FrameEntry& frame = frames[i];
+        if (!frame.used || (owner >= 0 && frame.owner != owner)) {
+            continue;
+        }
+        size_t key = (policy == PAGE_FIFO) ? frame.loaded_at : frame.last_use;
+        if (key < best) {
+            best = key;
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+int MultiProcessVM::allocateFrame(Process& process) {
+    // Under local replacement each process may grow to an equal share of
+    // the frames; past that it replaces its own pages
+    size_t quota = std::max<size_t>(1, num_frames / liveProcesses());
+    bool may_grow = scope == SCOPE_GLOBAL || process.resident < quota;
+
+    if (frames_used < num_frames && may_grow) {
+        for (size_t i = 0; i < num_frames; i++) {
+            if (!frames[i].used) {
+                return i;
+            }
+        }
+    }
+
+    int owner = (scope == SCOPE_LOCAL && process.resident > 0) ? process.asid : -1;
+    int victim = selectVictim(owner);
+    evictFrame(victim);
+    return victim;
+}
+
+void MultiProcessVM::evictFrame(int frame) {
+    FrameEntry& entry = frames[frame];
+    if (verbose) {
+        std::cout << "Evicting frame " << frame << " (page " << entry.mappings[0].second
+                  << " of ASID " << entry.mappings[0].first;
+        if (entry.mappings.size() > 1) {
+            std::cout << ", shared by " << entry.mappings.size() << " mappings";
+        }
+        std::cout << ")\n";
+    }
+
+    for (const std::pair<int, size_t>& mapping : entry.mappings) {
+        ProcessPageEntry& pte = processes[mapping.first - 1].page_table[mapping.second];
+        pte.valid = false;
+        pte.frame = -1;
+    }
+    processes[entry.owner - 1].resident--;
+    backing_frame[entry.backing] = -1;
+    entry.used = false;
+    entry.owner = -1;
+    entry.mappings.clear();
+    frames_used--;
+}
+
+void MultiProcessVM::unmap(int frame, int asid, size_t page) {
+    FrameEntry& entry = frames[frame];
+    std::vector<std::pair<int, size_t>>& mappings = entry.mappings;
+    mappings.erase(std::find(mappings.begin(), mappings.end(), std::make_pair(asid, page)));
+
+    ProcessPageEntry& pte = processes[asid - 1].page_table[page];
+    pte.valid = false;
+    pte.frame = -1;
+
+    if (mappings.empty()) {
+        // Last mapping gone: the frame is free
+        processes[entry.owner - 1].resident--;
+        backing_frame[entry.backing] = -1;
+        entry.used = false;
+        entry.owner = -1;
+        frames_used--;
+    } else if (entry.owner == asid) {
+        // Charge the frame to a process that still maps it
+        processes[asid - 1].resident--;
+        entry.owner = mappings[0].first;
+        processes[entry.owner - 1].resident++;
+    }
+}
+
+void MultiProcessVM::loadPage(Process& process, size_t page) {
+    ProcessPageEntry& entry = process.page_table[page];
+    total_faults++;
+
+    // Another process already brought this content in: map its frame
+    int frame = backing_frame[entry.backing];
+    if (frame >= 0) {
+        process.minor_faults++;
+        frames[frame].mappings.push_back({process.asid, page});
+        entry.valid = true;
+        entry.frame = frame;
+        if (verbose) {
+            std::cout << "ASID " << process.asid << ": page " << page
+                      << " mapped from shared frame " << frame << "\n";
+        }
+        return;
+    }
+
+    process.major_faults++;
+    frame = allocateFrame(process);
+    FrameEntry& target = frames[frame];
+    target.used = true;
+    target.backing = entry.backing;
+    target.owner = process.asid;
+    target.loaded_at = access_counter;
+    target.last_use = access_counter;
+    target.mappings.assign(1, {process.asid, page});
+    backing_frame[entry.backing] = frame;
+    frames_used++;
+    process.resident++;
+    entry.valid = true;
+    entry.frame = frame;
+
+    if (verbose) {
+        std::cout << "ASID " << process.asid << ": page fault, loading page " << page
+                  << " into frame " << frame << "\n";
+    }
+}
+
+void MultiProcessVM::copyOnWrite(Process& process, size_t page) {
+    ProcessPageEntry& entry = process.page_table[page];
+    int frame = entry.frame;
+    backing_refs[entry.backing]--;
+    size_t copy = newBacking();
+    process.cow_copies++;
+    cow_copies++;
+
+    // Sole resident mapping: the other sharers are paged out and keep the
+    // original in the backing store, so the frame becomes the private copy
+    if (frames[frame].mappings.size() == 1) {
+        backing_frame[entry.backing] = -1;
+        entry.backing = copy;
+        frames[frame].backing = copy;
+        backing_frame[copy] = frame;
+        return;
+    }
+
+    unmap(frame, process.asid, page);
+    entry.backing = copy;
+    int target = allocateFrame(process);
+    FrameEntry& destination = frames[target];
+    destination.used = true;
+    destination.backing = copy;
+    destination.owner = process.asid;
+    destination.loaded_at = access_counter;
+    destination.last_use = access_counter;
+    destination.mappings.assign(1, {process.asid, page});
+    backing_frame[copy] = target;
+    frames_used++;
+    process.resident++;
+    entry.valid = true;
+    entry.frame = target;
+
+    if (verbose) {
+        std::cout << "ASID " << process.asid << ": copy-on-write of page " << page
+                  << " from frame " << frame << " into frame " << target << "\n";
+    }
+}
+
+size_t MultiProcessVM::translate(int asid, size_t virtual_address, bool write) {
+    Process* process = findProcess(asid);
+    if (!process) {
+        if (verbose) std::cout << "Error: No live process with ASID " << asid << "\n";
+        return SIZE_MAX;
+    }
+
+    size_t page = virtual_address / page_size;
+    size_t offset = virtual_address % page_size;
+    if (page >= process->page_table.size()) {
+        if (verbose) {
+            std::cout << "Error: Invalid virtual address 0x" << std::hex << virtual_address
+                      << std::dec << " for ASID " << asid << "\n";
+        }
+        return SIZE_MAX;
+    }
+
+    if (sampler.tick()) {
+        takeSample();
+    }
+
+    access_counter++;
+    process->accesses++;
+    process->window_accesses++;
+    window_accesses++;
+
+    MEMSIM_PROBE(PROBE_PAGE_WALK, 1);
+    ProcessPageEntry& entry = process->page_table[page];
+    if (!entry.valid) {
+        loadPage(*process, page);
+        process->window_faults++;
+        window_faults++;
+    }
+    if (write && backing_refs[entry.backing] > 1) {
+        copyOnWrite(*process, page);
+    }
+    frames[entry.frame].last_use = access_counter;
+    size_t physical_address = entry.frame * page_size + offset;
+
+    if (window_accesses >= thrash_window) {
+        endThrashingWindow();
+    }
+    return physical_address;
+}
+
+void MultiProcessVM::endThrashingWindow() {
+    windows_evaluated++;
+    double fault_pct = 100.0 * window_faults / window_accesses;
+    bool thrashing = fault_pct >= thrash_fault_pct;
+    if (thrashing) {
+        thrashing_windows++;
+    }
+
+    if (verbose && thrashing != system_thrashing) {
+        if (thrashing) {
+            std::cout << "Thrashing: " << std::fixed << std::setprecision(2) << fault_pct
+                      << "% of the last " << window_accesses << " accesses faulted ("
+                      << liveProcesses() << " processes, " << num_frames << " frames)\n";
+        } else {
+            std::cout << "Thrashing ended: " << std::fixed << std::setprecision(2) << fault_pct
+                      << "% of the last " << window_accesses << " accesses faulted\n";
+        }
+    }
+    system_thrashing = thrashing;
+
+    for (Process& process : processes) {
+        process.thrashing = process.alive && process.window_accesses > 0 &&
+                            100.0 * process.window_faults / process.window_accesses >= thrash_fault_pct;
+        if (process.thrashing) {
+            process.thrashing_windows++;
+        }
+        process.window_accesses = 0;
+        process.window_faults = 0;
+    }
+    window_accesses = 0;
+    window_faults = 0;
+}
+
+void MultiProcessVM::reset() {
+    // Page out everything; processes and their sharing stay as they are
+    bool was_verbose = verbose;
+    verbose = false;
+    for (size_t i = 0; i < num_frames; i++) {
+        if (frames[i].used) {
+            evictFrame(i);
+        }
+    }
+    verbose = was_verbose;
+
+    for (Process& process : processes) {
+        process.accesses = 0;
+        process.major_faults = 0;
+        process.minor_faults = 0;
+        process.cow_copies = 0;
+        process.window_accesses = 0;
+        process.window_faults = 0;
+        process.thrashing_windows = 0;
+        process.thrashing = false;
+    }
+    access_counter = 0;
+    total_faults = 0;
+    cow_copies = 0;
+    window_accesses = 0;
+    window_faults = 0;
+    thrashing_windows = 0;
+    windows_evaluated = 0;
+    system_thrashing = false;
+    sample_accesses = 0;
+    sample_faults = 0;
+}
+
+bool MultiProcessVM::startSampling(const std::string& path, size_t interval) {
+    sample_accesses = access_counter;
+    sample_faults = total_faults;
+    return sampler.open(path, {"access", "window_fault_pct", "frames_used", "live_processes",
+                               "thrashing"}, interval);
+}
+
+void MultiProcessVM::stopSampling() {
+    // Record the partial last window before closing
+    if (sampler.isOpen()) {
+        if (access_counter > sample_accesses) {
+            takeSample();
+        }
+        sampler.close();
+    }
+}
+
+void MultiProcessVM::takeSample() {
+    size_t accesses = access_counter - sample_accesses;
+    size_t faults = total_faults - sample_faults;
+    double row[] = {
+        (double)access_counter,
+        accesses > 0 ? 100.0 * faults / accesses : 0.0,
+        (double)frames_used,
+        (double)liveProcesses(),
+        system_thrashing ? 1.0 : 0.0,
+    };
+    sampler.write(row);
+    sample_accesses = access_counter;
+    sample_faults = total_faults;
+}
+
+void MultiProcessVM::stats() const {
+    size_t virtual_pages = 0;
+    size_t resident_mappings = 0;
+    for (const Process& process : processes) {
+        virtual_pages += process.page_table.size();
+    }
+    for (const FrameEntry& frame : frames) {
+        resident_mappings += frame.mappings.size();
+    }
+    size_t distinct = 0;
+    for (int refs : backing_refs) {
+        if (refs > 0) distinct++;
+    }
+    size_t minor = 0;
+    for (const Process& process : processes) {
+        minor += process.minor_faults;
+    }
+
+    std::cout << "\n=== Multi-Process VM Statistics ===\n";
+    std::cout << "Frames: " << frames_used << " of " << num_frames << " in use ("
+              << page_size << " bytes per page)\n";
+    std::cout << "Policy: " << (policy == PAGE_FIFO ? "FIFO" : "LRU") << ", "
+              << (scope == SCOPE_GLOBAL ? "global" : "local") << " replacement\n";
+    std::cout << "Processes: " << liveProcesses() << " live, " << processes.size() << " created\n";
+    std::cout << "Virtual pages: " << virtual_pages << " mapped, " << distinct
+              << " distinct (sharing saves " << virtual_pages - distinct << " pages)\n";
+    std::cout << "Consolidation ratio: " << std::fixed << std::setprecision(2)
+              << (num_frames > 0 ? (double)virtual_pages / num_frames : 0.0)
+              << " virtual pages per frame\n";
+    std::cout << "Resident mappings: " << resident_mappings << " in " << frames_used
+              << " frames (" << resident_mappings - frames_used << " frames saved by sharing)\n";
+    std::cout << "Total accesses: " << access_counter << "\n";
+    std::cout << "Page faults: " << total_faults << " (major " << total_faults - minor
+              << ", minor " << minor << "), fault rate "
+              << (access_counter > 0 ? 100.0 * total_faults / access_counter : 0.0) << "%\n";
+    std::cout << "Copy-on-write copies: " << cow_copies << "\n";
+    std::cout << "Thrashing windows: " << thrashing_windows << " of " << windows_evaluated
+              << " (" << thrash_window << " accesses, threshold " << thrash_fault_pct << "%)"
+              << (system_thrashing ? ", thrashing now" : "") << "\n";
+
+    std::cout << "\nASID  State   Pages  Resident  Accesses   Major   Minor  Fault%    COW  Thrashing\n";
+    for (const Process& process : processes) {
+        size_t faults = process.major_faults + process.minor_faults;
+        std::cout << std::setw(4) << process.asid << "  " << std::left << std::setw(6)
+                  << (process.alive ? "live" : "exited") << std::right
+                  << std::setw(7) << process.page_table.size()
+                  << std::setw(10) << process.resident
+                  << std::setw(10) << process.accesses
+                  << std::setw(8) << process.major_faults
+                  << std::setw(8) << process.minor_faults
+                  << std::setw(8) << (process.accesses > 0 ? 100.0 * faults / process.accesses : 0.0)
+                  << std::setw(7) << process.cow_copies
+                  << std::setw(11) << process.thrashing_windows << "\n";
+    }
+    std::cout << "===================================\n\n";
+}
+
+void MultiProcessVM::writeStatsJson(std::ostream& out) const {
+    size_t virtual_pages = 0;
+    for (const Process& process : processes) {
+        virtual_pages += process.page_table.size();
+    }
+
+    out << "{\"page_size\": " << page_size << ", \"frames\": " << num_frames
+        << ", \"frames_used\": " << frames_used
+        << ", \"policy\": \"" << (policy == PAGE_FIFO ? "FIFO" : "LRU")
+        << "\", \"scope\": \"" << (scope == SCOPE_GLOBAL ? "global" : "local")
+        << "\", \"accesses\": " << access_counter << ", \"faults\": " << total_faults
+        << ", \"cow_copies\": " << cow_copies
+        << ", \"consolidation_ratio\": " << std::fixed << std::setprecision(2)
+        << (num_frames > 0 ? (double)virtual_pages / num_frames : 0.0)
+        << ", \"thrashing_windows\": " << thrashing_windows
+        << ", \"windows\": " << windows_evaluated << ",\n    \"processes\": [";
+    for (size_t i = 0; i < processes.size(); i++) {
+        const Process& process = processes[i];
+        out << (i > 0 ? ",\n        " : "\n        ")
+            << "{\"asid\": " << process.asid << ", \"alive\": " << (process.alive ? "true" : "false")
+            << ", \"pages\": " << process.page_table.size() << ", \"resident\": " << process.resident
+            << ", \"accesses\": " << process.accesses << ", \"major_faults\": " << process.major_faults
+            << ", \"minor_faults\": " << process.minor_faults
+            << ", \"cow_copies\": " << process.cow_copies
+            << ", \"thrashing_windows\": " << process.thrashing_windows << "}";
+    }
+    out << "]}";
+}
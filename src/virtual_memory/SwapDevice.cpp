@@ -0,0 +1,112 @@
+#include "SwapDevice.h"
+#include "Snapshot.h"
+#include <algorithm>
+
+SwapDevice::SwapDevice()
+    : latency(100000.0), bandwidth(0.5), queue_depth(32) {
+    reset();
+}
+
+void SwapDevice::configure(double latency_ns, double new_bandwidth, size_t depth) {
+    latency = latency_ns;
+    bandwidth = new_bandwidth;
+    queue_depth = depth;
+}
+
+void SwapDevice::reset() {
+    busy_until = 0;
+    pending.clear();
+    reads = 0;
+    writes = 0;
+    prefetches = 0;
+    bytes_read = 0;
+    bytes_written = 0;
+    busy_time = 0;
+    queue_stall = 0;
+}
+
+double SwapDevice::serve(double now, size_t bytes) {
+    double service = latency + bytes / bandwidth;
+    busy_until = std::max(now, busy_until) + service;
+    busy_time += service;
+    return busy_until;
+}
+
+double SwapDevice::waitForSlot(double now) {
+    while (!pending.empty() && pending.front() <= now) {
+        pending.pop_front();
+    }
+    if (pending.size() >= queue_depth) {
+        // Wait for the oldest outstanding request
+        double freed = pending.front();
+        queue_stall += freed - now;
+        now = freed;
+        pending.pop_front();
+    }
+    return now;
+}
+
+double SwapDevice::read(double now, size_t bytes) {
+    reads++;
+    bytes_read += bytes;
+    return serve(now, bytes);
+}
+
+double SwapDevice::write(double now, size_t bytes) {
+    now = waitForSlot(now);
+    writes++;
+    bytes_written += bytes;
+    pending.push_back(serve(now, bytes));
+    return now;
+}
+
+double SwapDevice::prefetch(double& now, size_t bytes) {
+    now = waitForSlot(now);
+    prefetches++;
+    bytes_read += bytes;
+    double done = serve(now, bytes);
+    pending.push_back(done);
+    return done;
+}
+
+void SwapDevice::save(SnapshotWriter& out) const {
+    out.putDouble(latency);
+    out.putDouble(bandwidth);
+    out.put(queue_depth);
+    out.putDouble(busy_until);
+    out.put(reads);
+    out.put(writes);
+    out.put(prefetches);
+    out.put(bytes_read);
+    out.put(bytes_written);
+    out.putDouble(busy_time);
+    out.putDouble(queue_stall);
+    out.put(pending.size());
+    for (double done : pending) {
+        out.putDouble(done);
+    }
+}
+
+bool SwapDevice::load(SnapshotReader& in) {
+    const uint64_t* p = in.getArray(12);
+    const uint64_t* queued = p ? in.getRecords(p[11], 1) : nullptr;
+    if (!queued) {
+        return false;
+    }
+    latency = SnapshotReader::toDouble(p[0]);
+    bandwidth = SnapshotReader::toDouble(p[1]);
+    queue_depth = p[2];
+    busy_until = SnapshotReader::toDouble(p[3]);
+    reads = p[4];
+    writes = p[5];
+    prefetches = p[6];
+    bytes_read = p[7];
+    bytes_written = p[8];
+    busy_time = SnapshotReader::toDouble(p[9]);
+    queue_stall = SnapshotReader::toDouble(p[10]);
+    pending.clear();
+    for (uint64_t i = 0; i < p[11]; i++) {
+        pending.push_back(SnapshotReader::toDouble(queued[i]));
+    }
+    return bandwidth > 0 && queue_depth > 0;
+}
@@ -1,168 +1,1255 @@
-#include "VirtualMemory.h"
-#include <iostream>
-#include <iomanip>
-#include <algorithm>
-
-VirtualMemory::VirtualMemory(size_t num_pages, size_t page_size, size_t num_frames,
-                             PageReplacementPolicy policy)
-    : num_pages(num_pages), page_size(page_size), num_frames(num_frames),
-      policy(policy), time_counter(0), page_faults(0), page_hits(0) {
-    
-    page_table.resize(num_pages);
-    frame_used.resize(num_frames, false);
-    
-    std::cout << "Virtual memory initialized: " << num_pages << " pages, "
-              << page_size << " bytes per page, " << num_frames << " frames\n";
-}
-
-void VirtualMemory::setPolicy(PageReplacementPolicy new_policy) {
-    policy = new_policy;
-    std::string policyName = (policy == PAGE_FIFO) ? "FIFO" : "LRU";
-    std::cout << "Page replacement policy set to: " << policyName << "\n";
-}
-
-int VirtualMemory::findFreeFrame() {
-    for (size_t i = 0; i < num_frames; i++) {
-        if (!frame_used[i]) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int VirtualMemory::selectVictimPage() {
-    if (policy == PAGE_FIFO) {
-        // Use FIFO queue
-        if (!fifo_queue.empty()) {
-            int victim_page = fifo_queue.front();
-            fifo_queue.pop();
-            return victim_page;
-        }
-    } else if (policy == PAGE_LRU) {
-        // Find page with smallest timestamp
-        int victim_page = -1;
-        size_t min_time = SIZE_MAX;
-        
-        for (size_t i = 0; i < num_pages; i++) {
-            if (page_table[i].valid && page_table[i].timestamp < min_time) {
-                min_time = page_table[i].timestamp;
-                victim_page = i;
-            }
-        }
-        return victim_page;
-    }
-    return -1;
-}
-
-bool VirtualMemory::handlePageFault(size_t page_num) {
-    page_faults++;
-    
-    // Try to find a free frame
-    int frame = findFreeFrame();
-    
-    if (frame == -1) { // No free frame
-        int victim_page = selectVictimPage();
-        
-        if (victim_page == -1) {
-            std::cout << "Error: Cannot find victim page and no free frames\n";
-            return false; // Failed to handle page fault
-        }
-        
-        frame = page_table[victim_page].frame;
-        page_table[victim_page].valid = false;
-        page_table[victim_page].frame = -1;
-        
-        std::cout << "Page fault: evicting page " << victim_page 
-                  << " from frame " << frame << "\n";
-    }
-    
-    // At this point, 'frame' must be a valid frame number.
-
-    frame_used[frame] = true;
-    page_table[page_num].valid = true;
-    page_table[page_num].frame = frame;
-    page_table[page_num].timestamp = time_counter++;
-    
-    if (policy == PAGE_FIFO) {
-        fifo_queue.push(page_num);
-    }
-    
-    std::cout << "Page fault: loading page " << page_num 
-              << " into frame " << frame << "\n";
-
-    return true; // Successfully handled page fault
-}
-
-size_t VirtualMemory::translate(size_t virtual_address) {
-    size_t page_num = virtual_address / page_size;
-    size_t offset = virtual_address % page_size;
-    
-    if (page_num >= num_pages) {
-        std::cout << "Error: Invalid virtual address 0x" << std::hex 
-                  << virtual_address << std::dec << "\n";
-        return SIZE_MAX; // Return error code for invalid address
-    }
-    
-    if (page_table[page_num].valid) {
-        // Page hit
-        page_hits++;
-        
-        // Update timestamp for LRU
-        if (policy == PAGE_LRU) {
-            page_table[page_num].timestamp = time_counter++;
-        }
-        
-        int frame = page_table[page_num].frame;
-        size_t physical_address = frame * page_size + offset;
-        
-        return physical_address;
-    } else {
-        // Page fault
-        if (!handlePageFault(page_num)) {
-            // If handling the page fault failed, return an error
-            return SIZE_MAX; 
-        }
-        
-        // Page fault handled successfully, now we can translate
-        int frame = page_table[page_num].frame;
-        size_t physical_address = frame * page_size + offset;
-        
-        return physical_address;
-    }
-}
-
-void VirtualMemory::reset() {
-    for (auto& entry : page_table) {
-        entry.valid = false;
-        entry.frame = -1;
-        entry.timestamp = 0;
-    }
-    
-    for (size_t i = 0; i < num_frames; i++) {
-        frame_used[i] = false;
-    }
-    
-    while (!fifo_queue.empty()) {
-        fifo_queue.pop();
-    }
-    
-    time_counter = 0;
-    page_faults = 0;
-    page_hits = 0;
-}
-
-void VirtualMemory::stats() const {
-    size_t total_accesses = page_hits + page_faults;
-    double hit_ratio = total_accesses > 0 ? 
-                       (double)page_hits / total_accesses * 100.0 : 0.0;
-    
-    std::cout << "\n=== Virtual Memory Statistics ===\n";
-    std::cout << "Total page accesses: " << total_accesses << "\n";
-    std::cout << "Page hits: " << page_hits << "\n";
-    std::cout << "Page faults: " << page_faults << "\n";
-    std::cout << "Page hit ratio: " << std::fixed << std::setprecision(2) 
-              << hit_ratio << "%\n";
-    std::cout << "Page fault ratio: " << std::fixed << std::setprecision(2) 
-              << (100.0 - hit_ratio) << "%\n";
-    std::cout << "=================================\n\n";
+#include "VirtualMemory.h"
+#include "Snapshot.h"
+#include "Profile.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Access history the entry stamps keep when they are rebased
+static const size_t STAMP_KEEP = size_t(1) << 31;
+
+VirtualMemory::VirtualMemory(size_t num_pages, size_t page_size, size_t num_frames,
+                             PageReplacementPolicy policy)
+    : num_pages(num_pages), page_size(page_size), num_frames(num_frames),
+      policy(policy), verbose(true), access_base(0), page_faults(0), page_hits(0),
+      last_fault_access(0), window_hits(0), window_faults(0), ws_window(1000),
+      pff_threshold(0), resident_limit(num_frames), resident_count(0), resident_sum(0),
+      pff_grows(0), pff_shrinks(0), pff_released(0), huge_policy(HUGE_NEVER), promote_pct(50),
+      promotions(0), demotions(0), demoted_freed(0), huge_fallbacks(0), bloat_evicted(0),
+      memory_time(100), sim_time(0), fault_service(0), window_time(0), writebacks(0),
+      clean_evictions(0), prefetch_pages(0), prefetch_hits(0) {
+    
+    page_table.resize(num_pages);
+    epoch = 0;
+    frame_page.resize(num_frames, -1);
+    initFramePool();
+    ws_nodes.assign(num_pages + 1, WorkingSetNode());
+    ws_nodes[num_pages].prev = ws_nodes[num_pages].next = num_pages;
+    clearWorkingSet();
+    
+    std::cout << "Virtual memory initialized: " << num_pages << " pages, "
+              << page_size << " bytes per page, " << num_frames << " frames\n";
+}
+
+void VirtualMemory::setPolicy(PageReplacementPolicy new_policy) {
+    // The FIFO queue is only kept under FIFO. Switching to it queues the
+    // resident mappings by their stamps, the closest record of load order.
+    if (new_policy == PAGE_FIFO && policy != PAGE_FIFO) {
+        fifo_queue.clear();
+        for (size_t frame = 0; frame < num_frames; frame++) {
+            int page = frame_page[frame];
+            if (page >= 0 && (size_t)page == headOf(page)) {
+                fifo_queue.push_back(page);
+            }
+        }
+        std::stable_sort(fifo_queue.begin(), fifo_queue.end(), [this](int a, int b) {
+            return page_table[a].last_used < page_table[b].last_used;
+        });
+    } else if (new_policy != PAGE_FIFO) {
+        fifo_queue.clear();
+    }
+    policy = new_policy;
+    std::string policyName = (policy == PAGE_FIFO) ? "FIFO" : "LRU";
+    std::cout << "Page replacement policy set to: " << policyName << "\n";
+}
+
+void VirtualMemory::setWorkingSetWindow(size_t delta) {
+    ws_window = delta;
+    clearWorkingSet();
+    std::cout << "Working set window set to " << delta << " accesses\n";
+}
+
+void VirtualMemory::setPffThreshold(size_t threshold) {
+    pff_threshold = threshold;
+    if (threshold == 0) {
+        // Back to a fixed allocation of the whole budget
+        resident_limit = num_frames;
+        std::cout << "Page-fault-frequency control off\n";
+    } else {
+        std::cout << "Page-fault-frequency control on: critical interval "
+                  << threshold << " accesses\n";
+    }
+}
+
+bool VirtualMemory::setPageSizes(const std::vector<unsigned>& orders) {
+    if (resident_count > 0) {
+        std::cout << "Error: Page sizes can only change while no pages are resident (use reset)\n";
+        return false;
+    }
+    for (size_t i = 0; i < orders.size(); i++) {
+        if (orders[i] == 0 || orders[i] > 30 || (i > 0 && orders[i] <= orders[i - 1]) ||
+            (size_t(1) << orders[i]) > num_pages || orders[i] > max_block_order) {
+            std::cout << "Error: Huge page orders must be increasing, and each huge page must "
+                      << "fit in both the address space and the frames\n";
+            return false;
+        }
+    }
+    
+    huge_orders = orders;
+    region_resident.clear();
+    for (unsigned order : huge_orders) {
+        region_resident.push_back(std::vector<uint32_t>(num_pages >> order, 0));
+    }
+    huge_faults.assign(huge_orders.size(), 0);
+    
+    std::cout << "Page sizes:";
+    std::cout << " " << page_size;
+    for (unsigned order : huge_orders) {
+        std::cout << ", " << (page_size << order);
+    }
+    std::cout << " bytes\n";
+    return true;
+}
+
+void VirtualMemory::setHugePagePolicy(HugePagePolicy new_policy, size_t pct) {
+    huge_policy = new_policy;
+    promote_pct = pct;
+    std::cout << "Huge page policy set to: "
+              << (huge_policy == HUGE_NEVER ? "never" : huge_policy == HUGE_ALWAYS ? "always" : "promote");
+    if (huge_policy == HUGE_PROMOTE) {
+        std::cout << " at " << pct << "% of a region resident";
+    }
+    std::cout << "\n";
+}
+
+void VirtualMemory::setSwapDevice(double latency_us, double bandwidth_mbps, size_t queue_depth) {
+    // 1 MB/s moves 0.001 bytes per nanosecond
+    swap.configure(latency_us * 1000.0, bandwidth_mbps / 1000.0, queue_depth);
+    std::cout << "Swap device: latency " << latency_us << " us, bandwidth " << bandwidth_mbps
+              << " MB/s, queue depth " << queue_depth << "\n";
+}
+
+void VirtualMemory::setMemoryAccessTime(double ns) {
+    memory_time = ns;
+    std::cout << "Memory access time set to " << ns << " ns\n";
+}
+
+void VirtualMemory::setPrefetch(size_t pages) {
+    prefetch_pages = pages;
+    if (pages == 0) {
+        std::cout << "Swap prefetch off\n";
+    } else {
+        std::cout << "Swap prefetch: " << pages << " pages after each fault\n";
+    }
+}
+
+void VirtualMemory::clearWorkingSet() {
+    // Only pages in the list have nonzero stamps
+    size_t page = ws_nodes[num_pages].next;
+    while (page != num_pages) {
+        size_t next = ws_nodes[page].next;
+        ws_nodes[page] = WorkingSetNode();
+        page = next;
+    }
+    ws_nodes[num_pages].prev = ws_nodes[num_pages].next = num_pages;
+    ws_size = 0;
+    ws_hist.reset();
+}
+
+void VirtualMemory::unlinkWorkingSet(size_t page_num) {
+    WorkingSetNode& node = ws_nodes[page_num];
+    ws_nodes[node.prev].next = node.next;
+    ws_nodes[node.next].prev = node.prev;
+    node.last_reference = 0;
+}
+
+void VirtualMemory::appendWorkingSet(size_t page_num, uint32_t stamp) {
+    WorkingSetNode& node = ws_nodes[page_num];
+    node.prev = ws_nodes[num_pages].prev;
+    node.next = num_pages;
+    node.last_reference = stamp;
+    ws_nodes[node.prev].next = page_num;
+    ws_nodes[num_pages].prev = page_num;
+}
+
+// Move the stamp base up so stamps stay within 32 bits. Mappings untouched
+// for more than STAMP_KEEP accesses clamp to the new base: they tie as the
+// oldest for LRU and count as unreferenced for PFF control. The window is
+// at most STAMP_KEEP, so working-set stamps never clamp.
+void VirtualMemory::rebaseStamps() {
+    size_t access_shift = page_hits + page_faults - access_base > STAMP_KEEP ?
+                          page_hits + page_faults - access_base - STAMP_KEEP : 0;
+    for (PageTableEntry& entry : page_table) {
+        entry.last_used = entry.last_used > access_shift ? entry.last_used - access_shift : 0;
+    }
+    for (size_t page = ws_nodes[num_pages].next; page != num_pages; page = ws_nodes[page].next) {
+        ws_nodes[page].last_reference -= access_shift;
+    }
+    access_base += access_shift;
+}
+
+void VirtualMemory::recordReference(size_t page_num) {
+    size_t now = page_hits + page_faults;
+    uint32_t stamp = accessStamp(now);
+    if (ws_nodes[num_pages].prev == page_num) {
+        // Already the newest page, as on every access within one page
+        ws_nodes[page_num].last_reference = stamp;
+    } else {
+        if (ws_nodes[page_num].last_reference != 0) {
+            unlinkWorkingSet(page_num);
+        } else {
+            ws_size++;
+        }
+        appendWorkingSet(page_num, stamp);
+    }
+    
+    // Pages whose latest reference is ws_window or more accesses old
+    size_t oldest = ws_nodes[num_pages].next;
+    while (accessOf(ws_nodes[oldest].last_reference) + ws_window <= now) {
+        unlinkWorkingSet(oldest);
+        ws_size--;
+        oldest = ws_nodes[num_pages].next;
+    }
+    ws_hist.record(ws_size);
+    
+    page_table[headOf(page_num)].last_used = stamp;
+    page_table[page_num].touched = true;
+    resident_sum += resident_count;
+}
+
+void VirtualMemory::controlResidentSet(size_t previous_fault, size_t now) {
+    if (now - previous_fault < pff_threshold) {
+        // Faulting too often: allow one more frame, up to the budget
+        if (resident_limit < num_frames) {
+            resident_limit++;
+            pff_grows++;
+            if (verbose) {
+                std::cout << "PFF: growing resident set to " << resident_limit << " frames\n";
+            }
+        }
+        return;
+    }
+    
+    // Faulting rarely: release the pages not referenced since the previous
+    // fault and keep the resident set where it now is
+    size_t released = 0;
+    for (size_t frame = 0; frame < num_frames; frame++) {
+        int page = frame_page[frame];
+        if (page >= 0 && (size_t)page == headOf(page) &&
+            accessOf(page_table[page].last_used) < previous_fault) {
+            size_t pages = size_t(1) << page_table[page].order;
+            if (pages > 1) {
+                bloat_evicted += untouchedPages(page);
+            }
+            writeBack(page);
+            evictPage(page);
+            released += pages;
+        }
+    }
+    dropStaleQueued();
+    size_t old_limit = resident_limit;
+    resident_limit = std::min(num_frames, std::max<size_t>(1, resident_count + 1));
+    if (released > 0 || resident_limit < old_limit) {
+        pff_shrinks++;
+        pff_released += released;
+        if (verbose) {
+            std::cout << "PFF: released " << released << " frames, resident set limit "
+                      << resident_limit << " frames\n";
+        }
+    }
+}
+
+void VirtualMemory::initFramePool() {
+    free_blocks.assign(1, std::set<size_t>());
+    free_order.assign(num_frames, -1);
+    max_block_order = 0;
+    
+    // Carve the frames into the largest aligned power-of-two blocks
+    size_t frame = 0;
+    while (frame < num_frames) {
+        unsigned order = 0;
+        while (order < 30 && frame % (size_t(2) << order) == 0 &&
+               frame + (size_t(2) << order) <= num_frames) {
+            order++;
+        }
+        if (order >= free_blocks.size()) {
+            free_blocks.resize(order + 1);
+        }
+        free_blocks[order].insert(frame);
+        free_order[frame] = order;
+        max_block_order = std::max(max_block_order, order);
+        frame += size_t(1) << order;
+    }
+}
+
+int VirtualMemory::allocFrames(unsigned order) {
+    // Smallest free block that fits, lowest frame first
+    unsigned found = order;
+    while (found < free_blocks.size() && free_blocks[found].empty()) {
+        found++;
+    }
+    if (found >= free_blocks.size()) {
+        return -1;
+    }
+    
+    size_t frame = *free_blocks[found].begin();
+    free_blocks[found].erase(free_blocks[found].begin());
+    free_order[frame] = -1;
+    
+    // Split, keeping the lower half and freeing the upper buddy
+    while (found > order) {
+        found--;
+        size_t buddy = frame + (size_t(1) << found);
+        free_blocks[found].insert(buddy);
+        free_order[buddy] = found;
+    }
+    return frame;
+}
+
+void VirtualMemory::freeFrames(size_t frame, unsigned order) {
+    // Merge with the buddy while it is free at the same order
+    while (order < max_block_order) {
+        size_t buddy = frame ^ (size_t(1) << order);
+        if (buddy >= num_frames || free_order[buddy] != (int8_t)order) {
+            break;
+        }
+        free_blocks[order].erase(buddy);
+        free_order[buddy] = -1;
+        frame = std::min(frame, buddy);
+        order++;
+    }
+    free_blocks[order].insert(frame);
+    free_order[frame] = order;
+}
+
+int VirtualMemory::obtainFrames(unsigned order) {
+    size_t need = size_t(1) << order;
+    if (order > max_block_order || need > resident_limit) {
+        return -1;
+    }
+    
+    while (true) {
+        if (resident_count + need <= resident_limit) {
+            int frame = allocFrames(order);
+            if (frame >= 0) {
+                return frame;
+            }
+        }
+        
+        // Huge pages never force evictions; the fault falls back to a base page
+        if (order > 0) {
+            return -1;
+        }
+        int victim_page = selectVictimPage();
+        if (victim_page == -1) {
+            return -1;
+        }
+        reclaim(victim_page);
+    }
+}
+
+void VirtualMemory::countResident(size_t head, unsigned order, int delta) {
+    size_t pages = size_t(1) << order;
+    for (size_t i = 0; i < huge_orders.size(); i++) {
+        unsigned region_order = huge_orders[i];
+        size_t first = head >> region_order;
+        size_t last = (head + pages - 1) >> region_order;
+        size_t per_region = std::min(pages, size_t(1) << region_order);
+        for (size_t region = first; region <= last && region < region_resident[i].size(); region++) {
+            region_resident[i][region] += delta * (int)per_region;
+        }
+    }
+}
+
+void VirtualMemory::mapRegion(size_t head, unsigned order, size_t frame, size_t now) {
+    size_t pages = size_t(1) << order;
+    for (size_t i = 0; i < pages; i++) {
+        PageTableEntry& entry = page_table[head + i];
+        if (entry.epoch != epoch) {
+            entry = PageTableEntry();
+            entry.epoch = epoch;
+        }
+        entry.valid = true;
+        entry.touched = false;
+        entry.order = order;
+        entry.frame = frame + i;
+        frame_page[frame + i] = head + i;
+    }
+    page_table[head].last_used = accessStamp(now);
+    resident_count += pages;
+    countResident(head, order, 1);
+    
+    if (policy == PAGE_FIFO) {
+        fifo_queue.push_back(head);
+    }
+}
+
+// Remove the queued heads that PFF control or a promotion unmapped, so the
+// FIFO queue holds exactly the resident mappings
+void VirtualMemory::dropStaleQueued() {
+    fifo_queue.erase(std::remove_if(fifo_queue.begin(), fifo_queue.end(), [this](int page) {
+        return !isMapped(page) || (size_t)page != headOf(page);
+    }), fifo_queue.end());
+}
+
+void VirtualMemory::evictPage(size_t page_num) {
+    PageTableEntry& head = page_table[page_num];
+    unsigned order = head.order;
+    size_t pages = size_t(1) << order;
+    size_t frame = head.frame;
+    for (size_t i = 0; i < pages; i++) {
+        PageTableEntry& entry = page_table[page_num + i];
+        entry.valid = false;
+        entry.touched = false;
+        entry.dirty = false;
+        entry.order = 0;
+        entry.frame = -1;
+        frame_page[frame + i] = -1;
+    }
+    freeFrames(frame, order);
+    resident_count -= pages;
+    countResident(page_num, order, -1);
+}
+
+size_t VirtualMemory::writeBack(size_t head) {
+    size_t pages = size_t(1) << page_table[head].order;
+    size_t dirty = 0;
+    for (size_t i = 0; i < pages; i++) {
+        if (page_table[head + i].dirty) dirty++;
+    }
+    
+    // Clean pages still match their copy in swap and are dropped; dirty
+    // ones are queued on the device and written in the background
+    if (dirty > 0) {
+        sim_time = swap.write(sim_time, dirty * page_size);
+    }
+    writebacks += dirty;
+    clean_evictions += pages - dirty;
+    return dirty;
+}
+
+void VirtualMemory::readIn(size_t page_num, size_t head, unsigned order) {
+    size_t pages = size_t(1) << order;
+    double issued = sim_time;
+    std::unordered_map<size_t, double>::iterator ahead = prefetched.find(page_num);
+    double done;
+    if (order == 0 && ahead != prefetched.end()) {
+        // Already read, or on its way from the device
+        done = ahead->second;
+        prefetch_hits++;
+    } else {
+        done = swap.read(issued, pages * page_size);
+    }
+    for (size_t i = 0; i < pages; i++) {
+        prefetched.erase(head + i);
+    }
+    
+    // Read ahead the pages that follow, queued behind the demand read
+    for (size_t page = head + pages; page < head + pages + prefetch_pages && page < num_pages; page++) {
+        if (isMapped(page) || prefetched.count(page)) {
+            continue;
+        }
+        double ready = swap.prefetch(issued, page_size);
+        prefetched[page] = ready;
+        prefetch_order.push_back({page, ready});
+        
+        // Bounded buffer: forget the oldest read, unless it was used since
+        if (prefetch_order.size() > PREFETCH_BUFFER) {
+            std::pair<size_t, double> oldest = prefetch_order.front();
+            prefetch_order.pop_front();
+            std::unordered_map<size_t, double>::iterator it = prefetched.find(oldest.first);
+            if (it != prefetched.end() && it->second == oldest.second) {
+                prefetched.erase(it);
+            }
+        }
+    }
+    sim_time = std::max(issued, done);
+}
+
+size_t VirtualMemory::untouchedPages(size_t head) const {
+    size_t pages = size_t(1) << page_table[head].order;
+    size_t untouched = 0;
+    for (size_t i = 0; i < pages; i++) {
+        if (!page_table[head + i].touched) untouched++;
+    }
+    return untouched;
+}
+
+void VirtualMemory::reclaim(size_t head) {
+    PageTableEntry& entry = page_table[head];
+    unsigned order = entry.order;
+    size_t pages = size_t(1) << order;
+    size_t untouched = order > 0 ? untouchedPages(head) : 0;
+    
+    // Demote a partly used huge page: keep its touched base pages and
+    // free the rest, instead of throwing the whole mapping out. Under FIFO
+    // the kept pages go back at the front, in address order, since they
+    // are as old as the huge page; the head's own entry was just popped.
+    if (order > 0 && untouched > 0 && untouched < pages) {
+        size_t frame = entry.frame;
+        uint32_t last_used = entry.last_used;
+        countResident(head, order, -1);
+        for (size_t i = pages; i-- > 0;) {
+            PageTableEntry& page = page_table[head + i];
+            page.order = 0;
+            if (page.touched) {
+                page.last_used = last_used;
+                countResident(head + i, 0, 1);
+                if (policy == PAGE_FIFO) {
+                    fifo_queue.push_front(head + i);
+                }
+            } else {
+                page.valid = false;
+                page.frame = -1;
+                frame_page[frame + i] = -1;
+                freeFrames(frame + i, 0);
+                resident_count--;
+            }
+        }
+        demotions++;
+        demoted_freed += untouched;
+        clean_evictions += untouched;  // never referenced, so never written
+        if (verbose) {
+            std::cout << "Page fault: demoting huge page at page " << head << ", freeing "
+                      << untouched << " untouched pages\n";
+        }
+        return;
+    }
+    
+    size_t dirty = writeBack(head);
+    if (verbose) {
+        if (order > 0) {
+            std::cout << "Page fault: evicting huge page at page " << head << " from frames "
+                      << entry.frame << "-" << entry.frame + pages - 1;
+        } else {
+            std::cout << "Page fault: evicting page " << head
+                      << " from frame " << entry.frame;
+        }
+        if (dirty > 0) {
+            std::cout << ", writing back " << dirty << (dirty == 1 ? " dirty page" : " dirty pages");
+        }
+        std::cout << "\n";
+    }
+    bloat_evicted += untouched;
+    evictPage(head);
+}
+
+void VirtualMemory::promote(size_t page_num) {
+    for (size_t i = huge_orders.size(); i-- > 0;) {
+        unsigned order = huge_orders[i];
+        size_t region = page_num >> order;
+        size_t pages = size_t(1) << order;
+        if (region >= region_resident[i].size() ||
+            region_resident[i][region] * 100 < promote_pct * pages) {
+            continue;
+        }
+        size_t head = region << order;
+        if (isMapped(head) && page_table[head].order >= order) {
+            continue;  // already one mapping
+        }
+        
+        // Like khugepaged: allocate the huge page first and give up if
+        // no free block is available
+        size_t resident = region_resident[i][region];
+        if (resident_count - resident + pages > resident_limit) {
+            continue;
+        }
+        int frame = allocFrames(order);
+        if (frame < 0) {
+            continue;
+        }
+        
+        // Copy the resident pages over and release their old frames; the
+        // faulting reference stamps the new mapping
+        std::vector<bool> touched(pages, false);
+        std::vector<bool> dirty(pages, false);
+        size_t page = head;
+        while (page < head + pages) {
+            PageTableEntry& entry = page_table[page];
+            if (!isMapped(page)) {
+                page++;
+                continue;
+            }
+            size_t mapping = size_t(1) << entry.order;
+            for (size_t j = 0; j < mapping; j++) {
+                touched[page - head + j] = page_table[page + j].touched;
+                dirty[page - head + j] = page_table[page + j].dirty;
+            }
+            evictPage(page);
+            page += mapping;
+        }
+        
+        dropStaleQueued();
+        mapRegion(head, order, frame, page_hits + page_faults);
+        for (size_t j = 0; j < pages; j++) {
+            page_table[head + j].touched = touched[j];
+            page_table[head + j].dirty = dirty[j];
+            prefetched.erase(head + j);
+        }
+        promotions++;
+        if (verbose) {
+            std::cout << "Promoting pages " << head << "-" << head + pages - 1
+                      << " to a huge page in frames " << frame << "-" << frame + pages - 1 << "\n";
+        }
+        return;
+    }
+}
+
+int VirtualMemory::selectVictimPage() {
+    if (policy == PAGE_FIFO) {
+        // The queue holds only resident mappings, so its front is the victim
+        MEMSIM_PROBE(PROBE_VICTIM_SCAN, 1);
+        if (!fifo_queue.empty()) {
+            int oldest = fifo_queue.front();
+            fifo_queue.pop_front();
+            return oldest;
+        }
+    } else if (policy == PAGE_LRU) {
+        // Find the mapping loaded or referenced longest ago
+        MEMSIM_PROBE(PROBE_VICTIM_SCAN, num_pages);
+        int victim_page = -1;
+        size_t min_time = SIZE_MAX;
+        
+        for (size_t i = 0; i < num_pages; i++) {
+            // Only head pages carry a mapping's stamps
+            if (isMapped(i) && i == headOf(i)) {
+                if (page_table[i].last_used < min_time) {
+                    min_time = page_table[i].last_used;
+                    victim_page = i;
+                }
+            }
+        }
+        return victim_page;
+    }
+    return -1;
+}
+
+bool VirtualMemory::handlePageFault(size_t page_num) {
+    page_faults++;
+    double fault_start = sim_time;
+    
+    // Accesses so far, counting this one
+    size_t now = page_hits + page_faults;
+    if (page_faults > 1) {
+        fault_interval_hist.record(now - last_fault_access);
+        if (pff_threshold > 0) {
+            controlResidentSet(last_fault_access, now);
+        }
+    }
+    last_fault_access = now;
+    
+    // Map the largest huge page the policy allows and the frame pool can
+    // supply, else a base page
+    unsigned order = 0;
+    int frame = -1;
+    if (huge_policy == HUGE_ALWAYS) {
+        bool tried = false;
+        for (size_t i = huge_orders.size(); i-- > 0 && frame == -1;) {
+            size_t region = page_num >> huge_orders[i];
+            if (region < region_resident[i].size() && region_resident[i][region] == 0) {
+                tried = true;
+                order = huge_orders[i];
+                frame = obtainFrames(order);
+            }
+        }
+        if (frame == -1 && tried) {
+            huge_fallbacks++;
+        }
+    }
+    if (frame == -1) {
+        order = 0;
+        frame = obtainFrames(0);
+    }
+    
+    if (frame == -1) {
+        if (verbose) std::cout << "Error: Cannot find victim page and no free frames\n";
+        return false; // Failed to handle page fault
+    }
+    
+    size_t head = page_num & ~((size_t(1) << order) - 1);
+    mapRegion(head, order, frame, now);
+    readIn(page_num, head, order);
+    
+    if (verbose) {
+        if (order > 0) {
+            std::cout << "Page fault: loading huge page of pages " << head << "-"
+                      << head + (size_t(1) << order) - 1 << " into frames " << frame << "-"
+                      << frame + (size_t(1) << order) - 1 << "\n";
+        } else {
+            std::cout << "Page fault: loading page " << page_num
+                      << " into frame " << frame << "\n";
+        }
+    }
+    
+    if (order > 0) {
+        huge_faults[std::find(huge_orders.begin(), huge_orders.end(), order) - huge_orders.begin()]++;
+    } else if (huge_policy == HUGE_PROMOTE) {
+        promote(page_num);
+    }
+    fault_service += sim_time - fault_start;
+
+    return true; // Successfully handled page fault
+}
+
+size_t VirtualMemory::translate(size_t virtual_address, bool write) {
+    size_t page_num = virtual_address / page_size;
+    size_t offset = virtual_address % page_size;
+    
+    if (page_num >= num_pages) {
+        if (verbose) {
+            std::cout << "Error: Invalid virtual address 0x" << std::hex 
+                      << virtual_address << std::dec << "\n";
+        }
+        return SIZE_MAX; // Return error code for invalid address
+    }
+    
+    if (sampler.tick()) {
+        takeSample();
+    }
+    if (page_hits + page_faults - access_base > UINT32_MAX) {
+        rebaseStamps();
+    }
+    // A page of a huge mapping also reads its head entry
+    MEMSIM_PROBE(PROBE_PAGE_WALK, headOf(page_num) == page_num ? 1 : 2);
+    
+    if (isMapped(page_num)) {
+        // Page hit
+        page_hits++;
+        
+        recordReference(page_num);
+        page_table[page_num].dirty |= write;
+        sim_time += memory_time;
+        
+        int frame = page_table[page_num].frame;
+        size_t physical_address = frame * page_size + offset;
+        
+        return physical_address;
+    } else {
+        // Page fault
+        if (!handlePageFault(page_num)) {
+            // If handling the page fault failed, return an error
+            return SIZE_MAX; 
+        }
+        
+        // Page fault handled successfully, now we can translate
+        recordReference(page_num);
+        page_table[page_num].dirty |= write;
+        sim_time += memory_time;
+        int frame = page_table[page_num].frame;
+        size_t physical_address = frame * page_size + offset;
+        
+        return physical_address;
+    }
+}
+
+void VirtualMemory::reset() {
+    // Entries of the old epoch read as unmapped and are cleared when next
+    // mapped. Only when the 16-bit epoch wraps is the table cleared here.
+    if (++epoch == 0) {
+        std::fill(page_table.begin(), page_table.end(), PageTableEntry());
+    }
+    
+    // Regions with resident pages are the only nonzero counts
+    for (size_t frame = 0; frame < num_frames; frame++) {
+        int page = frame_page[frame];
+        if (page < 0) continue;
+        for (size_t i = 0; i < huge_orders.size(); i++) {
+            region_resident[i][(size_t)page >> huge_orders[i]] = 0;
+        }
+        frame_page[frame] = -1;
+    }
+    initFramePool();
+    
+    fifo_queue.clear();
+    
+    access_base = 0;
+    page_faults = 0;
+    page_hits = 0;
+    last_fault_access = 0;
+    fault_interval_hist.reset();
+    window_hits = 0;
+    window_faults = 0;
+    
+    // The window and PFF threshold stay configured
+    clearWorkingSet();
+    resident_limit = num_frames;
+    resident_count = 0;
+    resident_sum = 0;
+    pff_grows = 0;
+    pff_shrinks = 0;
+    pff_released = 0;
+    std::fill(huge_faults.begin(), huge_faults.end(), 0);
+    promotions = 0;
+    demotions = 0;
+    demoted_freed = 0;
+    huge_fallbacks = 0;
+    bloat_evicted = 0;
+    
+    // The device, memory time and prefetch depth stay configured
+    swap.reset();
+    sim_time = 0;
+    fault_service = 0;
+    window_time = 0;
+    writebacks = 0;
+    clean_evictions = 0;
+    prefetched.clear();
+    prefetch_order.clear();
+    prefetch_hits = 0;
+}
+
+bool VirtualMemory::startSampling(const std::string& path, size_t interval) {
+    window_hits = page_hits;
+    window_faults = page_faults;
+    window_time = sim_time;
+    return sampler.open(path, {"access", "window_hit_ratio_pct", "window_faults", "hit_ratio_pct",
+                                "working_set", "resident_frames", "window_eat_ns"},
+                        interval);
+}
+
+void VirtualMemory::stopSampling() {
+    // Record the partial last window before closing
+    if (sampler.isOpen()) {
+        if (page_hits + page_faults > window_hits + window_faults) {
+            takeSample();
+        }
+        sampler.close();
+    }
+}
+
+void VirtualMemory::takeSample() {
+    size_t hits = page_hits - window_hits;
+    size_t faults = page_faults - window_faults;
+    size_t total_accesses = page_hits + page_faults;
+    double row[] = {
+        (double)total_accesses,
+        hits + faults > 0 ? 100.0 * hits / (hits + faults) : 0.0,
+        (double)faults,
+        total_accesses > 0 ? 100.0 * page_hits / total_accesses : 0.0,
+        (double)ws_size,
+        (double)resident_count,
+        hits + faults > 0 ? (sim_time - window_time) / (hits + faults) : 0.0,
+    };
+    sampler.write(row);
+    window_hits = page_hits;
+    window_faults = page_faults;
+    window_time = sim_time;
+}
+
+void VirtualMemory::stats() const {
+    size_t total_accesses = page_hits + page_faults;
+    double hit_ratio = total_accesses > 0 ? 
+                       (double)page_hits / total_accesses * 100.0 : 0.0;
+    
+    std::cout << "\n=== Virtual Memory Statistics ===\n";
+    std::cout << "Total page accesses: " << total_accesses << "\n";
+    std::cout << "Page hits: " << page_hits << "\n";
+    std::cout << "Page faults: " << page_faults << "\n";
+    std::cout << "Page hit ratio: " << std::fixed << std::setprecision(2) 
+              << hit_ratio << "%\n";
+    std::cout << "Page fault ratio: " << std::fixed << std::setprecision(2) 
+              << (100.0 - hit_ratio) << "%\n";
+    fault_interval_hist.print("Inter-fault interval", "accesses");
+    
+    // Fault rate against the memory actually held, to compare fixed
+    // allocation with PFF control at the same budget
+    double mean_resident = total_accesses > 0 ? (double)resident_sum / total_accesses : 0.0;
+    std::cout << "Working set (window " << ws_window << "): " << ws_size
+              << " pages now, mean " << std::setprecision(2) << ws_hist.getMean()
+              << ", max " << ws_hist.getMax() << "\n";
+    std::cout << "Resident frames: " << resident_count << " (limit " << resident_limit
+              << " of " << num_frames << "), mean " << mean_resident << " ("
+              << (num_frames > 0 ? 100.0 * mean_resident / num_frames : 0.0)
+              << "% of budget)\n";
+    std::cout << "Fault rate: " << (total_accesses > 0 ? 1000.0 * page_faults / total_accesses : 0.0)
+              << " per 1000 accesses\n";
+    if (pff_threshold > 0) {
+        std::cout << "PFF control: interval " << pff_threshold << ", " << pff_grows
+                  << " grows, " << pff_shrinks << " shrinks, " << pff_released
+                  << " pages released\n";
+    } else {
+        std::cout << "PFF control: off\n";
+    }
+    
+    if (huge_orders.empty()) {
+        std::cout << "Huge pages: off\n";
+    } else {
+        // Each resident mapping needs one TLB entry; fewer, larger mappings
+        // extend the reach of a TLB of fixed size
+        size_t base_mappings = 0, huge_mappings = 0, bloat = 0;
+        for (size_t i = 0; i < num_pages; i++) {
+            const PageTableEntry& entry = page_table[i];
+            if (!isMapped(i) || i != headOf(i)) continue;
+            if (entry.order > 0) {
+                huge_mappings++;
+                bloat += untouchedPages(i);
+            } else {
+                base_mappings++;
+            }
+        }
+        size_t base_faults = page_faults;
+        for (size_t faults : huge_faults) base_faults -= faults;
+        
+        std::cout << "Faults by page size: " << page_size << " B: " << base_faults;
+        for (size_t i = 0; i < huge_orders.size(); i++) {
+            std::cout << ", " << (page_size << huge_orders[i]) << " B: " << huge_faults[i];
+        }
+        std::cout << " (policy "
+                  << (huge_policy == HUGE_NEVER ? "never" : huge_policy == HUGE_ALWAYS ? "always" : "promote")
+                  << ")\n";
+        std::cout << "Huge pages: " << promotions << " promotions, " << demotions << " demotions ("
+                  << demoted_freed << " untouched pages freed), " << huge_fallbacks
+                  << " fallbacks to base pages\n";
+        std::cout << "Resident mappings: " << base_mappings << " base + " << huge_mappings
+                  << " huge for " << resident_count << " pages, TLB reach "
+                  << (base_mappings + huge_mappings > 0 ? (double)resident_count / (base_mappings + huge_mappings) : 0.0)
+                  << " pages per entry\n";
+        std::cout << "Huge page bloat: " << bloat << " untouched pages resident ("
+                  << (resident_count > 0 ? 100.0 * bloat / resident_count : 0.0)
+                  << "% of resident frames), " << bloat_evicted << " evicted untouched\n";
+    }
+    
+    // Swap traffic and the effective access time of design doc section 8.3
+    double fault_rate = total_accesses > 0 ? (double)page_faults / total_accesses : 0.0;
+    double service = page_faults > 0 ? fault_service / page_faults : 0.0;
+    std::cout << "Evictions: " << writebacks + clean_evictions << " pages, " << writebacks
+              << " dirty written back, " << clean_evictions << " clean\n";
+    std::cout << "Swap device: latency " << swap.getLatency() / 1000.0 << " us, bandwidth "
+              << swap.getBandwidth() * 1000.0 << " MB/s, queue depth " << swap.getQueueDepth() << "\n";
+    std::cout << "Swap I/O: " << swap.getReads() << " reads, " << swap.getPrefetches()
+              << " prefetches (" << prefetch_hits << " used), " << swap.getWrites() << " writes; "
+              << swap.getBytesRead() << " bytes in, " << swap.getBytesWritten()
+              << " bytes out, device busy "
+              << (sim_time > 0 ? 100.0 * std::min(swap.getBusyTime(), sim_time) / sim_time : 0.0)
+              << "% of run time\n";
+    std::cout << "Page fault service time: mean " << service << " ns, "
+              << swap.getQueueStall() << " ns waiting for a full I/O queue\n";
+    std::cout << "Effective access time: " << std::setprecision(4) << fault_rate << " * ("
+              << std::setprecision(2) << memory_time << " + " << service << ") + "
+              << std::setprecision(4) << 1.0 - fault_rate << std::setprecision(2) << " * "
+              << memory_time << " = "
+              << fault_rate * (memory_time + service) + (1.0 - fault_rate) * memory_time << " ns\n";
+    std::cout << "Metadata: " << metadataBytes() << " bytes ("
+              << (num_pages > 0 ? (double)metadataBytes() / num_pages : 0.0) << " bytes per page, "
+              << sizeof(PageTableEntry) << " in the page table entry)\n";
+    std::cout << "=================================\n\n";
+}
+
+void VirtualMemory::writeStatsJson(std::ostream& out) const {
+    out << "{\"pages\": " << num_pages << ", \"page_size\": " << page_size
+        << ", \"frames\": " << num_frames
+        << ", \"policy\": \"" << (policy == PAGE_FIFO ? "FIFO" : "LRU")
+        << "\", \"page_hits\": " << page_hits << ", \"page_faults\": " << page_faults
+        << ",\n    \"fault_interval\": ";
+    fault_interval_hist.writeJson(out);
+    size_t total_accesses = page_hits + page_faults;
+    out << ",\n    \"working_set\": {\"window\": " << ws_window << ", \"current\": " << ws_size
+        << ", \"size\": ";
+    ws_hist.writeJson(out);
+    out << "},\n    \"resident_frames\": " << resident_count
+        << ", \"resident_limit\": " << resident_limit
+        << ", \"mean_resident_frames\": "
+        << (total_accesses > 0 ? (double)resident_sum / total_accesses : 0.0)
+        << ", \"faults_per_1000\": "
+        << (total_accesses > 0 ? 1000.0 * page_faults / total_accesses : 0.0)
+        << ",\n    \"pff\": {\"threshold\": " << pff_threshold << ", \"grows\": " << pff_grows
+        << ", \"shrinks\": " << pff_shrinks << ", \"released\": " << pff_released << "}";
+    out << ",\n    \"huge_pages\": {\"policy\": \""
+        << (huge_policy == HUGE_NEVER ? "never" : huge_policy == HUGE_ALWAYS ? "always" : "promote")
+        << "\", \"sizes\": [";
+    for (size_t i = 0; i < huge_orders.size(); i++) {
+        out << (i > 0 ? ", " : "") << "{\"bytes\": " << (page_size << huge_orders[i])
+            << ", \"faults\": " << huge_faults[i] << "}";
+    }
+    out << "], \"promotions\": " << promotions << ", \"demotions\": " << demotions
+        << ", \"demoted_freed\": " << demoted_freed << ", \"fallbacks\": " << huge_fallbacks
+        << ", \"bloat_evicted\": " << bloat_evicted << "}";
+    double fault_rate = total_accesses > 0 ? (double)page_faults / total_accesses : 0.0;
+    double service = page_faults > 0 ? fault_service / page_faults : 0.0;
+    out << ",\n    \"io\": {\"latency_ns\": " << swap.getLatency()
+        << ", \"bandwidth_bytes_per_ns\": " << swap.getBandwidth()
+        << ", \"queue_depth\": " << swap.getQueueDepth() << ", \"reads\": " << swap.getReads()
+        << ", \"prefetches\": " << swap.getPrefetches() << ", \"prefetch_hits\": " << prefetch_hits
+        << ", \"writes\": " << swap.getWrites() << ", \"bytes_read\": " << swap.getBytesRead()
+        << ", \"bytes_written\": " << swap.getBytesWritten()
+        << ", \"writebacks\": " << writebacks << ", \"clean_evictions\": " << clean_evictions
+        << ", \"busy_ns\": " << swap.getBusyTime() << ", \"queue_stall_ns\": " << swap.getQueueStall()
+        << "},\n    \"memory_access_ns\": " << memory_time << ", \"fault_service_ns\": " << service
+        << ", \"eat_ns\": " << fault_rate * (memory_time + service) + (1.0 - fault_rate) * memory_time
+        << ", \"simulated_ns\": " << sim_time << ", \"metadata_bytes\": " << metadataBytes() << "}";
+}
+
+size_t VirtualMemory::metadataBytes() const {
+    // A set node is three pointers and a color word besides its value
+    const size_t free_node_bytes = 4 * sizeof(void*) + sizeof(size_t);
+    size_t bytes = page_table.capacity() * sizeof(PageTableEntry) + frame_page.capacity() * sizeof(int) +
+                   ws_nodes.capacity() * sizeof(WorkingSetNode) + free_order.capacity() * sizeof(int8_t);
+    for (const std::set<size_t>& heads : free_blocks) {
+        bytes += heads.size() * free_node_bytes;
+    }
+    for (const std::vector<uint32_t>& counts : region_resident) {
+        bytes += counts.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+bool VirtualMemory::save(const std::string& path) const {
+    SnapshotWriter out(path, SNAPSHOT_VIRTUAL_MEMORY);
+    out.put(num_pages);
+    out.put(page_size);
+    out.put(num_frames);
+    out.put(policy);
+    out.put(page_faults);
+    out.put(page_hits);
+    out.put(last_fault_access);
+    out.put(ws_window);
+    out.put(pff_threshold);
+    out.put(resident_limit);
+    out.put(resident_sum);
+    out.put(pff_grows);
+    out.put(pff_shrinks);
+    out.put(pff_released);
+    out.put(huge_policy);
+    out.put(promote_pct);
+    out.put(huge_orders.size());
+    out.put(promotions);
+    out.put(demotions);
+    out.put(demoted_freed);
+    out.put(huge_fallbacks);
+    out.put(bloat_evicted);
+    out.putDouble(memory_time);
+    out.putDouble(sim_time);
+    out.putDouble(fault_service);
+    out.put(writebacks);
+    out.put(clean_evictions);
+    out.put(prefetch_pages);
+    out.put(prefetch_hits);
+    out.put(access_base);
+    
+    // Page table entries as they are in memory, with stamps from
+    // access_base. Entries from before the latest reset are written as
+    // empty ones, and every entry with epoch 0.
+    std::vector<PageTableEntry> records(page_table);
+    for (PageTableEntry& entry : records) {
+        if (entry.epoch != epoch) {
+            entry = PageTableEntry();
+        }
+        entry.epoch = 0;
+    }
+    out.putRecords(records.data(), records.size());
+    
+    // FIFO queue, oldest mapping first
+    out.put(fifo_queue.size());
+    for (int page : fifo_queue) {
+        out.put(page);
+    }
+    
+    // Working set, oldest reference first, as (page, stamp) pairs
+    out.put(ws_size);
+    for (size_t page = ws_nodes[num_pages].next; page != num_pages; page = ws_nodes[page].next) {
+        out.put(page);
+        out.put(ws_nodes[page].last_reference);
+    }
+    
+    // Huge page orders and the faults mapped with each; the frame pool and
+    // per-region counts are rebuilt from the page table
+    for (size_t i = 0; i < huge_orders.size(); i++) {
+        out.put(huge_orders[i]);
+        out.put(huge_faults[i]);
+    }
+    
+    // Prefetch buffer, oldest first, as (page, ready time, still unused)
+    out.put(prefetch_order.size());
+    for (const std::pair<size_t, double>& read : prefetch_order) {
+        std::unordered_map<size_t, double>::const_iterator it = prefetched.find(read.first);
+        out.put(read.first);
+        out.putDouble(read.second);
+        out.put(it != prefetched.end() && it->second == read.second);
+    }
+    
+    fault_interval_hist.save(out);
+    ws_hist.save(out);
+    swap.save(out);
+    
+    if (!out.ok()) {
+        std::cout << "Error: Cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<VirtualMemory> VirtualMemory::load(const std::string& path) {
+    SnapshotReader in(path, SNAPSHOT_VIRTUAL_MEMORY);
+    const uint64_t* header = in.getArray(30);
+    std::vector<PageTableEntry> entries;
+    bool have_entries = header && in.getRecords(entries);
+    uint64_t fifo_length = 0;
+    in.get(fifo_length);
+    const uint64_t* fifo = in.getRecords(fifo_length, 1);
+    uint64_t ws_length = 0;
+    in.get(ws_length);
+    const uint64_t* ws = in.getRecords(ws_length, 2);
+    const uint64_t* huge = header ? in.getRecords(header[16], 2) : nullptr;
+    uint64_t prefetch_length = 0;
+    in.get(prefetch_length);
+    const uint64_t* reads = in.getRecords(prefetch_length, 3);
+    Histogram intervals;
+    Histogram working_set;
+    SwapDevice device;
+    if (!header || !have_entries || !fifo || !ws || !huge || !reads || !intervals.load(in) ||
+        !working_set.load(in) || !device.load(in)) {
+        std::cout << "Error: " << in.error() << "\n";
+        return nullptr;
+    }
+    
+    size_t pages = header[0];
+    size_t frames = header[2];
+    size_t window = header[7];
+    size_t huge_count = header[16];
+    bool geometry_ok = header[1] != 0 && header[3] <= PAGE_LRU && window != 0 &&
+                       window <= MAX_WS_WINDOW && header[9] != 0 && header[9] <= frames &&
+                       header[14] <= HUGE_PROMOTE && header[15] <= 100 &&
+                       prefetch_length <= PREFETCH_BUFFER && entries.size() == pages;
+    std::vector<unsigned> orders;
+    for (size_t i = 0; i < huge_count && geometry_ok; i++) {
+        uint64_t order = huge[i * 2];
+        geometry_ok = order > 0 && order <= 30 && (orders.empty() || order > orders.back()) &&
+                      (uint64_t(1) << order) <= pages && (uint64_t(1) << order) <= frames;
+        orders.push_back(order);
+    }
+    if (!geometry_ok) {
+        std::cout << "Error: " << path << " has an invalid VM geometry\n";
+        return nullptr;
+    }
+    
+    // Every mapping must be aligned, cover contiguous aligned frames with
+    // entries of its own order, and no two pages may share a frame
+    std::vector<bool> used(frames, false);
+    size_t resident = 0;
+    size_t mappings = 0;
+    bool consistent = true;
+    size_t page = 0;
+    while (page < pages && consistent) {
+        const PageTableEntry& entry = entries[page];
+        if (!entry.valid) {
+            page++;
+            continue;
+        }
+        uint64_t order = entry.order;
+        int64_t frame = entry.frame;
+        uint64_t span = order <= 30 ? uint64_t(1) << order : 0;
+        consistent = (order == 0 || std::find(orders.begin(), orders.end(), order) != orders.end()) &&
+                     page % span == 0 && page + span <= pages && frame >= 0 &&
+                     (uint64_t)frame % span == 0 && (uint64_t)frame + span <= frames;
+        for (uint64_t i = 0; i < span && consistent; i++) {
+            const PageTableEntry& sub = entries[page + i];
+            consistent = sub.valid && sub.order == order && sub.frame == frame + (int64_t)i &&
+                         !used[frame + i];
+            if (consistent) used[frame + i] = true;
+        }
+        resident += span;
+        mappings++;
+        page += span;
+    }
+    consistent = consistent && resident <= header[9] && header[29] <= header[4] + header[5];
+    // Under FIFO the queue must list every resident mapping once
+    std::vector<bool> queued(pages, false);
+    consistent = consistent && (header[3] != PAGE_FIFO || fifo_length == mappings);
+    for (size_t i = 0; i < fifo_length && consistent; i++) {
+        consistent = fifo[i] < pages && entries[fifo[i]].valid &&
+                     fifo[i] % (uint64_t(1) << entries[fifo[i]].order) == 0 && !queued[fifo[i]];
+        if (consistent) queued[fifo[i]] = true;
+    }
+    // Working-set stamps must rise and lie within the window
+    uint64_t now = header[4] + header[5];
+    std::vector<bool> in_window(pages, false);
+    for (size_t i = 0; i < ws_length && consistent; i++) {
+        uint64_t access = header[29] + ws[i * 2 + 1];
+        consistent = ws[i * 2] < pages && !in_window[ws[i * 2]] && ws[i * 2 + 1] > 0 &&
+                     ws[i * 2 + 1] <= UINT32_MAX && (i == 0 || ws[i * 2 + 1] > ws[i * 2 - 1]) &&
+                     access <= now && access + window > now;
+        if (consistent) in_window[ws[i * 2]] = true;
+    }
+    for (size_t i = 0; i < prefetch_length; i++) {
+        consistent = consistent && reads[i * 3] < pages && !(reads[i * 3 + 2] && entries[reads[i * 3]].valid);
+    }
+    if (!consistent) {
+        std::cout << "Error: " << path << " has an inconsistent page table\n";
+        return nullptr;
+    }
+    
+    std::unique_ptr<VirtualMemory> vm = std::make_unique<VirtualMemory>(
+        pages, header[1], frames, (PageReplacementPolicy)header[3]);
+    vm->page_faults = header[4];
+    vm->page_hits = header[5];
+    vm->last_fault_access = header[6];
+    vm->window_hits = vm->page_hits;
+    vm->window_faults = vm->page_faults;
+    vm->pff_threshold = header[8];
+    vm->resident_limit = header[9];
+    vm->resident_count = resident;
+    vm->resident_sum = header[10];
+    vm->pff_grows = header[11];
+    vm->pff_shrinks = header[12];
+    vm->pff_released = header[13];
+    vm->huge_policy = (HugePagePolicy)header[14];
+    vm->promote_pct = header[15];
+    vm->promotions = header[17];
+    vm->demotions = header[18];
+    vm->demoted_freed = header[19];
+    vm->huge_fallbacks = header[20];
+    vm->bloat_evicted = header[21];
+    vm->memory_time = SnapshotReader::toDouble(header[22]);
+    vm->sim_time = SnapshotReader::toDouble(header[23]);
+    vm->window_time = vm->sim_time;
+    vm->fault_service = SnapshotReader::toDouble(header[24]);
+    vm->writebacks = header[25];
+    vm->clean_evictions = header[26];
+    vm->prefetch_pages = header[27];
+    vm->prefetch_hits = header[28];
+    vm->access_base = header[29];
+    vm->swap = device;
+    vm->huge_orders = orders;
+    for (size_t i = 0; i < huge_count; i++) {
+        vm->region_resident.push_back(std::vector<uint32_t>(pages >> orders[i], 0));
+        vm->huge_faults.push_back(huge[i * 2 + 1]);
+    }
+    
+    for (size_t i = 0; i < pages; i++) {
+        PageTableEntry& entry = vm->page_table[i];
+        entry = entries[i];
+        entry.epoch = vm->epoch;
+        if (!entry.valid) {
+            entry.frame = -1;
+            entry.order = 0;
+            entry.dirty = false;
+        }
+        if (entry.valid) {
+            vm->frame_page[entry.frame] = i;
+            if (i == vm->headOf(i)) {
+                vm->countResident(i, entry.order, 1);
+            }
+        }
+    }
+    
+    // Rebuild the buddy free lists from the frames left over
+    for (std::set<size_t>& blocks : vm->free_blocks) {
+        blocks.clear();
+    }
+    std::fill(vm->free_order.begin(), vm->free_order.end(), -1);
+    for (size_t frame = 0; frame < frames; frame++) {
+        if (!used[frame]) {
+            vm->freeFrames(frame, 0);
+        }
+    }
+    
+    for (size_t i = 0; i < fifo_length; i++) {
+        vm->fifo_queue.push_back(fifo[i]);
+    }
+    for (size_t i = 0; i < prefetch_length; i++) {
+        double ready = SnapshotReader::toDouble(reads[i * 3 + 1]);
+        vm->prefetch_order.push_back({reads[i * 3], ready});
+        if (reads[i * 3 + 2]) {
+            vm->prefetched[reads[i * 3]] = ready;
+        }
+    }
+    
+    vm->ws_window = window;
+    vm->clearWorkingSet();
+    for (size_t i = 0; i < ws_length; i++) {
+        vm->appendWorkingSet(ws[i * 2], ws[i * 2 + 1]);
+    }
+    vm->ws_size = ws_length;
+    vm->fault_interval_hist = intervals;
+    vm->ws_hist = working_set;
+    return vm;
 }
\ No newline at end of file
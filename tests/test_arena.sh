@@ -0,0 +1,51 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for Arena (region) allocation
+
+echo "=== Testing Arena Allocation ==="
+echo ""
+
+# Create test input
+cat > test_arena_input.txt << EOF
+mode standard
+init memory 4096
+malloc 100
+arena create 1024
+arena alloc 1 100
+arena alloc 1 30
+arena alloc 1 250
+arena alloc 1 900
+free 2
+dump
+arena stats 1
+arena reset 1
+arena alloc 1 64
+arena stats 1
+arena destroy 1
+dump
+mode buddy
+init memory 4096
+arena create 1000
+arena alloc 1 10
+arena alloc 1 20
+arena alloc 1 300
+free 1
+arena stats
+dump
+exit
+EOF
+
+# arena stats times the arena against malloc; the timings are masked so
+# the output can be compared between runs
+echo "Running arena test on standard and buddy allocators..."
+../bin/memsim.exe < test_arena_input.txt | sed -E 's/[0-9]+\.[0-9]+ ns/N ns/g' > ../test_arena_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_arena_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_arena_output.txt
+
+# Cleanup
+rm test_arena_input.txt
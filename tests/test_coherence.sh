@@ -0,0 +1,52 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for cache coherence: two cores write different words of one
+# line (false sharing), then a producer and a consumer share one word (true
+# sharing), under MESI on a snooping bus and MOESI with a directory.
+
+echo "=== Testing Cache Coherence ==="
+echo ""
+
+# Create test input
+cat > test_coherence_input.txt << EOF2
+mode coherence
+init coherence 2 1024 64 2 lru
+access 0 0x100 w
+access 1 0x108 w
+access 0 0x100 w
+access 1 0x108 w
+access 0 0x100
+access 0 0x200 w
+access 1 0x200
+access 0 0x200 w
+access 1 0x200
+access 1 0x300
+access 0 0x300
+stats
+set protocol moesi
+set interconnect directory
+set shared 4096 4
+access 0 0x200 w
+access 1 0x200
+access 0 0x200
+access 1 0x200 w
+access 0 0x200
+access 0 0x100 w
+access 1 0x108 w
+access 0 0x100
+stats
+exit
+EOF2
+
+echo "Running cache coherence test..."
+../bin/memsim.exe < test_coherence_input.txt > ../test_coherence_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_coherence_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_coherence_output.txt
+
+# Cleanup
+rm test_coherence_input.txt
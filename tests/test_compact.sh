@@ -0,0 +1,49 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for compaction. Budgeted passes of 100 bytes leave the
+# 300-byte block in place but keep closing the holes behind it, until an
+# unbudgeted pass moves everything.
+
+echo "=== Testing Compaction ==="
+echo ""
+
+# Create test input
+cat > test_compact_input.txt << EOF
+mode standard
+init memory 1024
+malloc 100
+malloc 300
+malloc 40
+malloc 40
+malloc 40
+malloc 40
+malloc 40
+malloc 40
+free 1
+free 3
+free 5
+free 7
+dump
+compact 100
+dump
+compact 100
+dump
+compact 100
+compact
+dump
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_compact_input.txt > ../test_compact_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_compact_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_compact_output.txt
+
+# Cleanup
+rm test_compact_input.txt
@@ -0,0 +1,57 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for allocator + cache co-simulation: the same trace of
+# allocations and object accesses is replayed under first fit, best fit and
+# buddy placement, then compared across every placement.
+
+echo "=== Testing Allocator + Cache Co-simulation ==="
+echo ""
+
+# Create test input
+cat > test_cosim_input.txt << EOF2
+mode cosim
+init cosim 1024 128 16 1 lru
+malloc 40
+malloc 100
+malloc 24
+free 2
+malloc 20
+malloc 60
+malloc 8
+touch 1 0 40
+touch 3 0 24
+touch 4 0 20
+touch 5 0 60
+touch 6 0
+touch 1 0 40
+touch 3 0 24
+touch 4 0 20
+touch 6 0 8
+touch 9 0
+touch 1 30 20
+free 1
+free 1
+stats
+set allocator best_fit
+stats
+set allocator buddy
+dump
+stats
+compare
+reset
+compare
+exit
+EOF2
+
+echo "Running co-simulation test..."
+../bin/memsim.exe < test_cosim_input.txt > ../test_cosim_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_cosim_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_cosim_output.txt
+
+# Cleanup
+rm test_cosim_input.txt
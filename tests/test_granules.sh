@@ -0,0 +1,36 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for memories above 4 GiB. An 8 GiB memory uses 4-byte
+# granules, so odd sizes round up. Requests larger than the memory fail
+# before rounding, including one that would wrap around.
+
+echo "=== Testing Large Memory Granules ==="
+echo ""
+
+# Create test input
+cat > test_granules_input.txt << EOF
+mode standard
+init memory 8589934592
+malloc 3
+malloc 18446744073709551615
+malloc 8589934593
+malloc 4096
+free 1
+malloc 1
+dump
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_granules_input.txt > ../test_granules_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_granules_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_granules_output.txt
+
+# Cleanup
+rm test_granules_input.txt
@@ -0,0 +1,65 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for multi-size pages. With page orders 2 and 3 enabled the
+# always policy maps aligned huge pages on first touch; the promote policy
+# starts with base pages and promotes a region once 75% of it is touched.
+# The last run fills four frames with one huge page under FIFO; demoting
+# it must leave page 0 oldest, so the fifth new page evicts it and the
+# final access to 0x0000 faults.
+
+echo "=== Testing Huge Pages and Promotion ==="
+echo ""
+
+# Create test input
+cat > test_hugepages_input.txt << EOF
+mode vm
+init vm 64 256 8
+set policy lru
+set pagesizes 2 3
+set hugepages always
+translate 0x0000
+translate 0x0100
+translate 0x1000
+translate 0x2000
+translate 0x2300
+translate 0x0200
+stats
+reset
+set hugepages promote 75
+translate 0x0000
+translate 0x0100
+translate 0x0200
+translate 0x0300
+stats
+init vm 64 256 4
+set policy fifo
+set pagesizes 2
+set hugepages always
+translate 0x0000
+translate 0x0400
+translate 0x0800
+translate 0x0c00
+translate 0x1000
+translate 0x1400
+translate 0x1800
+translate 0x1c00
+translate 0x2000
+translate 0x2400
+translate 0x2800
+translate 0x0000
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_hugepages_input.txt > ../test_hugepages_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_hugepages_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_hugepages_output.txt
+
+# Cleanup
+rm test_hugepages_input.txt
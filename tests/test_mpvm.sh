@@ -0,0 +1,66 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for the multi-process VM: two processes share pages after a
+# fork until they write them, then a third process pushes the frame pool
+# into thrashing under global and local replacement.
+
+echo "=== Testing Multi-Process Virtual Memory ==="
+echo ""
+
+# Create test input
+cat > test_mpvm_input.txt << EOF2
+mode mpvm
+init mpvm 256 4
+set thrashing 4 50
+process create 4
+translate 1 0x000
+translate 1 0x100
+translate 1 0x200 w
+process fork 1
+translate 2 0x000
+translate 2 0x100
+translate 2 0x200 w
+translate 1 0x200
+stats
+reset
+process create 4
+translate 3 0x000
+translate 3 0x100
+translate 3 0x200
+translate 3 0x300
+translate 1 0x000
+translate 1 0x100
+translate 3 0x000
+translate 3 0x100
+translate 1 0x200
+translate 1 0x300
+translate 3 0x200
+translate 3 0x300
+stats
+reset
+process exit 2
+set scope local
+translate 3 0x000
+translate 3 0x100
+translate 1 0x000
+translate 1 0x100
+translate 3 0x000
+translate 3 0x100
+translate 1 0x000
+translate 1 0x100
+stats
+exit
+EOF2
+
+echo "Running multi-process virtual memory test..."
+../bin/memsim.exe < test_mpvm_input.txt > ../test_mpvm_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_mpvm_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_mpvm_output.txt
+
+# Cleanup
+rm test_mpvm_input.txt
@@ -0,0 +1,58 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script comparing Next Fit against First Fit on the same trace
+
+echo "=== Testing Next Fit vs First Fit ==="
+echo ""
+
+# Same churn trace for both strategies: fill the front, punch holes, refill
+trace() {
+cat << EOF2
+malloc 64
+malloc 64
+malloc 64
+malloc 64
+malloc 64
+malloc 64
+malloc 64
+malloc 64
+free 2
+free 4
+free 6
+malloc 32
+malloc 32
+malloc 32
+malloc 100
+malloc 16
+malloc 16
+free 1
+malloc 48
+dump
+stats
+EOF2
+}
+
+# Create test input
+{
+    echo "mode standard"
+    echo "init memory 1024"
+    echo "set allocator first_fit"
+    trace
+    echo "init memory 1024"
+    echo "set allocator next_fit"
+    trace
+    echo "exit"
+} > test_next_fit_input.txt
+
+echo "Running first_fit and next_fit on the same trace..."
+../bin/memsim.exe < test_next_fit_input.txt > ../test_next_fit_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_next_fit_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_next_fit_output.txt
+
+# Cleanup
+rm test_next_fit_input.txt
@@ -0,0 +1,46 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for tree-PLRU and SRRIP replacement. Both caches have two
+# 4-way sets and see the same accesses, all mapping to set 0.
+
+echo "=== Testing Tree-PLRU and SRRIP Replacement ==="
+echo ""
+
+# Create test input
+cat > test_replacement_input.txt << EOF
+mode cache
+init cache L2 512 64 4 plru
+access 0
+access 128
+access 256
+access 384
+access 0
+access 512
+access 128
+access 0
+stats
+init cache L3 512 64 4 srrip
+access 0
+access 128
+access 256
+access 384
+access 0
+access 512
+access 128
+access 0
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_replacement_input.txt > ../test_replacement_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_replacement_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_replacement_output.txt
+
+# Cleanup
+rm test_replacement_input.txt
@@ -0,0 +1,56 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for set and time sampling. Each sampled run reports its miss
+# ratio estimate with a confidence interval; sampling off goes back to
+# simulating every access.
+
+echo "=== Testing Sampled Cache Simulation ==="
+echo ""
+
+# Create test input
+cat > test_sampling_input.txt << EOF
+mode cache
+init cache L1 1024 64 2 lru
+set sampling sets 2
+access 0
+access 64
+access 128
+access 192
+access 0
+access 64
+access 1024
+access 1088
+access 0
+access 64
+stats
+set sampling time 4 1 2
+access 0
+access 64
+access 128
+access 192
+access 0
+access 64
+access 128
+access 192
+access 0
+access 64
+access 128
+access 192
+stats
+set sampling off
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_sampling_input.txt > ../test_sampling_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_sampling_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_sampling_output.txt
+
+# Cleanup
+rm test_sampling_input.txt
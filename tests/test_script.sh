@@ -0,0 +1,53 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for batch execution with -f. The script mixes comments,
+# blank lines, hex and decimal addresses, a malformed number, and init
+# commands with missing or zero arguments, which must be rejected.
+
+echo "=== Testing Script Execution ==="
+echo ""
+
+# Create test script
+cat > test_script_input.txt << EOF2
+# Cache: 0x40 and 64 are the same block
+mode cache
+init cache L1 1024 64
+init cache L1 100 64 4
+init cache L1 1024 64 4 lru
+
+access 0x40
+access 64
+access 0x1000
+access 4096
+access 12abc
+stats
+# VM: translate is decimal too, so 256 and 0x100 are the same page
+mode vm
+init vm 16 0 4
+init vm 16 256
+init vm 16 256 4
+translate 0x100
+translate 256 w
+translate 0x1000
+stats
+mode standard
+init memory
+init memory 0
+exit
+EOF2
+
+echo "Running script..."
+../bin/memsim.exe -f test_script_input.txt > ../test_script_output.txt
+echo "" >> ../test_script_output.txt
+echo "=== Missing script ===" >> ../test_script_output.txt
+../bin/memsim.exe -f missing_script.txt >> ../test_script_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_script_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_script_output.txt
+
+# Cleanup
+rm test_script_input.txt
@@ -0,0 +1,78 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for save/load snapshots. Each simulator is warmed up, saved,
+# and then restored in a second session; both sessions run the same tail
+# of the trace, so their stats should match.
+
+echo "=== Testing Snapshot Save/Load ==="
+echo ""
+
+# Create test input
+cat > test_snapshot_input.txt << EOF
+mode standard
+init memory 4096
+malloc 100
+malloc 200
+malloc 300
+free 2
+save snapshot_standard.bin
+malloc 50
+stats
+mode cache
+init cache L1 1024 64 4 lru
+access 0
+access 40
+access 80
+access 0
+save snapshot_cache.bin
+access 400
+access 40
+stats
+mode vm
+init vm 16 256 4
+translate 0
+translate 0x100
+translate 0x200
+save snapshot_vm.bin
+translate 0
+translate 0x300
+stats
+exit
+EOF
+
+cat > test_snapshot_restore_input.txt << EOF
+mode standard
+load snapshot_standard.bin
+malloc 50
+stats
+mode cache
+load snapshot_cache.bin
+access 400
+access 40
+stats
+mode vm
+load snapshot_vm.bin
+translate 0
+translate 0x300
+stats
+mode buddy
+load snapshot_standard.bin
+exit
+EOF
+
+echo "Running warm-up session and restored session..."
+../bin/memsim.exe < test_snapshot_input.txt > ../test_snapshot_output.txt
+echo "" >> ../test_snapshot_output.txt
+echo "=== Restored session ===" >> ../test_snapshot_output.txt
+../bin/memsim.exe < test_snapshot_restore_input.txt >> ../test_snapshot_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_snapshot_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_snapshot_output.txt
+
+# Cleanup
+rm test_snapshot_input.txt test_snapshot_restore_input.txt
+rm -f snapshot_standard.bin snapshot_cache.bin snapshot_vm.bin
@@ -0,0 +1,45 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for the swap device model. Dirty evictions are written back
+# through a 4-deep queue, fault service time includes device latency and
+# transfer time, and sequential faults prefetch the next 2 pages.
+
+echo "=== Testing Swap Device and Prefetch ==="
+echo ""
+
+# Create test input
+cat > test_swap_input.txt << EOF
+mode vm
+init vm 64 256 8
+set policy lru
+set swap 50 100 4
+set memtime 80
+set prefetch 2
+translate 0x0000 w
+translate 0x0100 w
+translate 0x0200
+translate 0x0300
+translate 0x0400
+translate 0x0500
+translate 0x0600 w
+translate 0x0700
+translate 0x0800
+translate 0x0900
+translate 0x0a00
+translate 0x0000
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_swap_input.txt > ../test_swap_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_swap_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_swap_output.txt
+
+# Cleanup
+rm test_swap_input.txt
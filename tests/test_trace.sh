@@ -0,0 +1,52 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for allocation traces. A shell command is run under the
+# LD_PRELOAD shim (build it with make trace) and its trace is replayed
+# against the standard and buddy allocators. trace_bench --aligned then
+# allocates through posix_memalign, aligned_alloc, memalign and valloc,
+# whose blocks must replay as aligned allocations, not untraced frees.
+# ls lists tracked sources only, and the pid and replay time are masked,
+# so the output can be compared between runs.
+
+echo "=== Testing Allocation Trace Replay ==="
+echo ""
+
+echo "Tracing ls under libmemsim_trace.so..."
+LD_PRELOAD=$PWD/../bin/libmemsim_trace.so MEMSIM_TRACE=$PWD/trace_ls.bin ls -R ../include ../src > /dev/null
+
+echo "Tracing trace_bench --aligned under libmemsim_trace.so..."
+LD_PRELOAD=$PWD/../bin/libmemsim_trace.so MEMSIM_TRACE=$PWD/trace_aligned.bin \
+    ../bin/trace_bench --child --threads 1 --ops 2000 --aligned > /dev/null
+
+# Create test input
+cat > test_trace_input.txt << EOF
+mode standard
+init memory 67108864
+replay trace_ls.bin
+stats
+mode buddy
+init memory 67108864
+replay trace_ls.bin
+stats
+mode standard
+init memory 67108864
+replay trace_aligned.bin
+stats
+replay missing_trace.bin
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_trace_input.txt |
+    sed -E 's/process [0-9]+/process N/; s/over [0-9]+\.[0-9]+ s/over T s/' > ../test_trace_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_trace_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_trace_output.txt
+
+# Cleanup
+rm test_trace_input.txt
+rm -f trace_ls.bin trace_aligned.bin
@@ -32,6 +32,15 @@ translate 0x1000
 translate 0x4000
 translate 0x1000
 stats
+set policy fifo
+translate 0x0400
+translate 0x0500
+translate 0x0600
+translate 0x0700
+translate 0x0800
+translate 0x0900
+translate 0x0a00
+stats
 exit
 EOF
 
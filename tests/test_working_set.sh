@@ -0,0 +1,45 @@
+#!/bin/bash
+cd "$(dirname "$0")"
+
+# Test script for working-set tracking and PFF control. Two phases of two
+# pages each run under a 4-access window; PFF with a critical interval of
+# 3 grows the resident set on close faults and shrinks it on distant ones.
+
+echo "=== Testing Working Set and Page-Fault-Frequency Control ==="
+echo ""
+
+# Create test input
+cat > test_working_set_input.txt << EOF
+mode vm
+init vm 64 256 8
+set policy lru
+set window 4
+set pff 3
+translate 0x0000
+translate 0x0100
+translate 0x0000
+translate 0x0100
+translate 0x0000
+translate 0x0100
+translate 0x0200
+translate 0x0300
+translate 0x0200
+translate 0x0300
+translate 0x0200
+translate 0x0300
+translate 0x0400
+stats
+exit
+EOF
+
+echo "Running test..."
+../bin/memsim.exe < test_working_set_input.txt > ../test_working_set_output.txt
+
+echo ""
+echo "Test complete. Output saved to test_working_set_output.txt"
+echo ""
+echo "=== Output Preview ==="
+cat ../test_working_set_output.txt
+
+# Cleanup
+rm test_working_set_input.txt